@@ -273,6 +273,12 @@ class wayfire_animation : public wf::plugin_interface_t, private wf::per_output_
         effects_registry->unregister_effect("squeezimize");
     }
 
+    bool is_init_deferrable() const override
+    {
+        // Views mapped before the first frame do not need to be animated.
+        return true;
+    }
+
     void cleanup_views_on_output(wf::output_t *output)
     {
         std::vector<std::shared_ptr<wf::view_interface_t>> all_views;
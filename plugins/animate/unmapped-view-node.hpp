@@ -4,19 +4,20 @@
 #include "wayfire/scene-render.hpp"
 #include "wayfire/scene.hpp"
 #include <wayfire/view.hpp>
+#include <wayfire/view-snapshot.hpp>
 
 namespace wf
 {
 class unmapped_view_snapshot_node : public wf::scene::node_t
 {
-    wf::auxilliary_buffer_t snapshot;
+    wf::view_snapshot_t snapshot;
     wf::dimensions_t snapshot_logical_size;
     std::weak_ptr<wf::view_interface_t> _view;
 
   public:
     unmapped_view_snapshot_node(wayfire_view view) : node_t(false)
     {
-        view->take_snapshot(snapshot);
+        snapshot.capture(view);
         snapshot_logical_size = wf::dimensions(view->get_surface_root_node()->get_bounding_box());
         _view = view->weak_from_this();
     }
@@ -50,8 +51,7 @@ class unmapped_view_snapshot_node : public wf::scene::node_t
         using simple_render_instance_t::simple_render_instance_t;
         void render(const wf::scene::render_instruction_t& data)
         {
-            auto texture = wf::texture_t::from_aux(self->snapshot);
-            data.pass->add_texture(texture, data.target, self->get_bounding_box(), data.damage);
+            self->snapshot.render(data, self->get_bounding_box());
         }
     };
 };
@@ -220,10 +220,83 @@ static wf::pointf_t get_center(wf::geometry_t g)
     return {g.x + g.width / 2.0, g.y + g.height / 2.0};
 }
 
+void wf_blur_base::reset_cache(blur_cache_t& cache, const wf::render_target_t& target_fb,
+    wf::geometry_t region)
+{
+    auto source_box = target_fb.framebuffer_box_from_geometry_box(target_fb.geometry);
+    cache.geometry  = sanitize(target_fb.framebuffer_box_from_geometry_box(region), degrade_opt, source_box);
+    cache.algorithm = this;
+    cache.degrade   = degrade_opt;
+    cache.buffer.allocate({std::max(cache.geometry.width / cache.degrade, 1),
+        std::max(cache.geometry.height / cache.degrade, 1)});
+}
+
+bool wf_blur_base::is_cache_current(const blur_cache_t& cache) const
+{
+    return (cache.algorithm == this) && (cache.degrade == degrade_opt);
+}
+
+int wf_blur_base::get_degrade() const
+{
+    return degrade_opt;
+}
+
+void wf_blur_base::update_cache(blur_cache_t& cache, const wf::render_target_t& target_fb,
+    const wf::region_t& region)
+{
+    const int degrade = cache.degrade;
+    auto source_box   = target_fb.framebuffer_box_from_geometry_box(target_fb.geometry);
+
+    GLuint src_fb = wf::gles::ensure_render_buffer_fb_id(fb[0].get_renderbuffer());
+    GLuint dst_fb = wf::gles::ensure_render_buffer_fb_id(cache.buffer.get_renderbuffer());
+    GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, src_fb));
+    GL_CALL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst_fb));
+    // The blur iterations leave the scissor test enabled, but it also applies to blits.
+    GL_CALL(glDisable(GL_SCISSOR_TEST));
+
+    for (const auto& b : region)
+    {
+        auto box = target_fb.framebuffer_box_from_geometry_box(wlr_box_from_pixman_box(b));
+        box = sanitize(box, degrade, source_box);
+        box = wf::geometry_intersection(box, prepared_geometry);
+        box = wf::geometry_intersection(box, cache.geometry);
+        if ((box.width <= 0) || (box.height <= 0))
+        {
+            continue;
+        }
+
+        const int src_x = (box.x - prepared_geometry.x) / degrade;
+        const int src_y = (box.y - prepared_geometry.y) / degrade;
+        const int dst_x = (box.x - cache.geometry.x) / degrade;
+        const int dst_y = (box.y - cache.geometry.y) / degrade;
+        const int width = std::max(box.width / degrade, 1);
+        const int height = std::max(box.height / degrade, 1);
+        GL_CALL(glBlitFramebuffer(
+            src_x, src_y, src_x + width, src_y + height,
+            dst_x, dst_y, dst_x + width, dst_y + height,
+            GL_COLOR_BUFFER_BIT, GL_NEAREST));
+    }
+}
+
 void wf_blur_base::render(wf::gles_texture_t src_tex, wlr_box src_box, const wf::region_t& damage,
     const wf::render_target_t& background_source_fb, const wf::render_target_t& target_fb)
 {
-    wf::gles_texture_t blurred_background = wf::gles_texture_t::from_aux(fb[0]);
+    render_blended(src_tex, src_box, damage, background_source_fb, target_fb,
+        wf::gles_texture_t::from_aux(fb[0]), prepared_geometry);
+}
+
+void wf_blur_base::render(wf::gles_texture_t src_tex, wlr_box src_box, const wf::region_t& damage,
+    const wf::render_target_t& background_source_fb, const wf::render_target_t& target_fb,
+    blur_cache_t& cache)
+{
+    render_blended(src_tex, src_box, damage, background_source_fb, target_fb,
+        wf::gles_texture_t::from_aux(cache.buffer), cache.geometry);
+}
+
+void wf_blur_base::render_blended(wf::gles_texture_t src_tex, wlr_box src_box, const wf::region_t& damage,
+    const wf::render_target_t& background_source_fb, const wf::render_target_t& target_fb,
+    wf::gles_texture_t blurred_background, wf::geometry_t blurred_geometry)
+{
     wf::gles::ensure_render_buffer_fb_id(target_fb);
     blend_program.use(src_tex.type);
 
@@ -256,8 +329,8 @@ void wf_blur_base::render(wf::gles_texture_t src_tex, wlr_box src_box, const wf:
     // 3. Scale to match the view size
     // 4. Translate to match the view
     auto view_box    = background_source_fb.framebuffer_box_from_geometry_box(src_box); // Projected view
-    auto blurred_box = prepared_geometry;
-    // prepared_geometry is the projected damage bounding box
+    auto blurred_box = blurred_geometry;
+    // blurred_geometry is the projected bounding box of the blurred region
 
     glm::mat4 fb_fix   = wf::gles::output_transform(target_fb);
     const auto scale_x = 1.0 * view_box.width / blurred_box.width;
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <wayfire/core.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/output-layout.hpp>
+#include <wayfire/region.hpp>
+#include <wayfire/render-manager.hpp>
+
+#include "blur.hpp"
+
+namespace wf
+{
+namespace scene
+{
+/**
+ * The blurred background behind a view on one output. It is kept between frames and recomputed only where
+ * something behind the view changes. The view's own damage (for example a terminal printing text) does not
+ * invalidate it.
+ */
+struct blur_output_cache_t
+{
+    blur_cache_t cache;
+    // The part of the cache which holds the current blurred background, in the coordinate system of the
+    // node's bounding box.
+    wf::region_t valid;
+
+    // What the cache was prepared for.
+    wf::geometry_t target_geometry = {0, 0, 0, 0};
+    wf::dimensions_t target_size   = {0, 0};
+    float target_scale = 0.0;
+    wl_output_transform target_transform = WL_OUTPUT_TRANSFORM_NORMAL;
+    std::optional<wf::geometry_t> target_subbuffer;
+    wf::geometry_t bbox = {0, 0, 0, 0};
+    wf::geometry_t output_bbox = {0, 0, 0, 0};
+
+    // Damage to the output from anything except the view itself since the last frame, in output-local
+    // coordinates. Set pushing_own_damage while the view damages the output.
+    wf::region_t background_damage;
+    bool pushing_own_damage = false;
+
+    /**
+     * Drop the parts of the cache which are affected by the background damage collected so far.
+     *
+     * @param offset The offset from output-local coordinates to the coordinates of the node's bounding box.
+     * @param padding How far the damage affects the blurred background.
+     */
+    void invalidate_background_damage(wf::point_t offset, int padding)
+    {
+        wf::region_t changed = background_damage + offset;
+        changed.expand_edges(padding);
+        valid ^= changed;
+        background_damage.clear();
+    }
+
+    wf::signal::connection_t<wf::output_damage_signal> on_output_damage = [=] (wf::output_damage_signal *ev)
+    {
+        if (!pushing_own_damage)
+        {
+            background_damage |= *ev->region;
+            // Damage keeps accumulating while the view is not rendered, keep it simple.
+            background_damage  = wf::simplify_region(background_damage, 16, 1.0);
+        }
+    };
+};
+
+/**
+ * The caches of a blur node, one for each output. They live in the node, so that they survive when the
+ * render instances are regenerated, and are dropped when their output is removed.
+ */
+class blur_output_caches_t
+{
+  public:
+    blur_output_caches_t()
+    {
+        wf::get_core().output_layout->connect(&on_output_removed);
+    }
+
+    blur_output_cache_t *get(wf::output_t *output)
+    {
+        auto& cache = caches[output];
+        if (!cache)
+        {
+            cache = std::make_unique<blur_output_cache_t>();
+            output->connect(&cache->on_output_damage);
+        }
+
+        return cache.get();
+    }
+
+  private:
+    std::map<wf::output_t*, std::unique_ptr<blur_output_cache_t>> caches;
+    wf::signal::connection_t<wf::output_removed_signal> on_output_removed =
+        [=] (wf::output_removed_signal *ev)
+    {
+        caches.erase(ev->output);
+    };
+};
+}
+}
@@ -1,6 +1,8 @@
 #include <wayfire/per-output-plugin.hpp>
+#include <cmath>
 #include <memory>
 #include <list>
+#include <optional>
 #include <wayfire/config/types.hpp>
 #include <wayfire/plugin.hpp>
 #include <wayfire/view.hpp>
@@ -13,6 +15,7 @@
 #include <wayfire/bindings-repository.hpp>
 
 #include "blur.hpp"
+#include "blur-output-cache.hpp"
 #include "wayfire/core.hpp"
 #include "wayfire/debug.hpp"
 #include "wayfire/geometry.hpp"
@@ -39,6 +42,36 @@ static int calculate_damage_padding(const wf::render_target_t& target, int blur_
     return std::ceil(blur_radius / scale);
 }
 
+/**
+ * Map @box from the coordinate system of @node's bounding box to the coordinate system of the output node
+ * above @node. Fails if @node is not below an output node, or if the nodes in between do more than translate
+ * their children.
+ */
+static std::optional<wf::geometry_t> box_to_output_local(wf::scene::node_t *node, wf::geometry_t box,
+    wf::output_t **output)
+{
+    wf::pointf_t a = {1.0 * box.x, 1.0 * box.y};
+    wf::pointf_t b = {1.0 * box.x + box.width, 1.0 * box.y + box.height};
+    for (auto parent = node->parent(); parent; parent = parent->parent())
+    {
+        if (auto output_node = dynamic_cast<wf::scene::output_node_t*>(parent))
+        {
+            *output = output_node->get_output();
+            if ((std::abs(b.x - a.x - box.width) > 1e-3) || (std::abs(b.y - a.y - box.height) > 1e-3))
+            {
+                return {};
+            }
+
+            return wf::geometry_t{(int)std::round(a.x), (int)std::round(a.y), box.width, box.height};
+        }
+
+        a = parent->to_global(a);
+        b = parent->to_global(b);
+    }
+
+    return {};
+}
+
 namespace wf
 {
 namespace scene
@@ -88,14 +121,78 @@ class blur_node_t : public transformer_base_node_t
     {
         buffer->taken = false;
     }
+
+    // The blurred background behind the view for each output.
+    blur_output_caches_t output_caches;
 };
 
 class blur_render_instance_t : public transformer_render_instance_t<blur_node_t>
 {
     blur_node_t::saved_pixels_t *saved_pixels = nullptr;
+    // The cache of the node for the output we are shown on, if any.
+    blur_output_cache_t *cache_state = nullptr;
+
+    // The region to blur on the next render() call, and the part of it which is copied to the cache.
+    wf::region_t blur_region;
+    wf::region_t cache_update;
+    bool use_cache = false;
+
+    /**
+     * Check whether the cache can be used for @target, resetting it if it was prepared for something else.
+     * Returns the offset from output-local coordinates to the coordinates of the node's bounding box.
+     */
+    std::optional<wf::point_t> validate_cache(const wf::render_target_t& target, wf::geometry_t bbox)
+    {
+        wf::output_t *output = nullptr;
+        auto output_bbox     = box_to_output_local(self.get(), bbox, &output);
+        if (!cache_state || !output_bbox || (output != _shown_on))
+        {
+            return {};
+        }
+
+        auto& cs = *cache_state;
+        const bool same_target = (cs.target_geometry == target.geometry) &&
+            (cs.target_size == target.get_size()) && (cs.target_scale == target.scale) &&
+            (cs.target_transform == target.wl_transform) && (cs.target_subbuffer == target.subbuffer);
+        if (!same_target || (cs.bbox != bbox) || (cs.output_bbox != *output_bbox) ||
+            !self->provider()->is_cache_current(cs.cache))
+        {
+            cs.target_geometry  = target.geometry;
+            cs.target_size      = target.get_size();
+            cs.target_scale     = target.scale;
+            cs.target_transform = target.wl_transform;
+            cs.target_subbuffer = target.subbuffer;
+            cs.bbox = bbox;
+            cs.output_bbox = *output_bbox;
+            cs.valid.clear();
+            wf::gles::run_in_context_if_gles([&]
+            {
+                self->provider()->reset_cache(cs.cache, target,
+                    wf::geometry_intersection(bbox, target.geometry));
+            });
+        }
+
+        return wf::origin(bbox) - wf::origin(*output_bbox);
+    }
 
   public:
-    using transformer_render_instance_t::transformer_render_instance_t;
+    blur_render_instance_t(blur_node_t *self, damage_callback push_damage, wf::output_t *shown_on) :
+        transformer_render_instance_t(self, push_damage, shown_on)
+    {
+        // The damage of our children is pushed through _push_damage, mark it so that it does not count as
+        // damage to the background.
+        if (shown_on)
+        {
+            cache_state = self->output_caches.get(shown_on);
+            this->_push_damage = [=] (const wf::region_t& region)
+            {
+                cache_state->pushing_own_damage = true;
+                push_damage(region);
+                cache_state->pushing_own_damage = false;
+            };
+        }
+    }
+
     bool is_fully_opaque(wf::region_t damage)
     {
         if (self->get_children().size() == 1)
@@ -155,45 +252,71 @@ class blur_render_instance_t : public transformer_render_instance_t<blur_node_t>
             return;
         }
 
-        padded_region.expand_edges(padding);
+        // Actual region which will be repainted by this render instance.
+        wf::region_t we_repaint;
+
+        auto output_offset = validate_cache(target, bbox);
+        use_cache = output_offset.has_value();
+        if (use_cache)
+        {
+            // The blurred background changes up to a blur radius away from the changes behind the view, and
+            // the degraded blur rounds that to whole blocks of pixels.
+            const int cache_padding = calculate_damage_padding(target,
+                self->provider()->calculate_blur_radius() + self->provider()->get_degrade());
+            cache_state->invalidate_background_damage(*output_offset, cache_padding);
+
+            // Blur only the translucent parts that we repaint and for which the cached background is out of
+            // date. Those need to be padded too, so that the blurred result is correct up to their edges.
+            we_repaint   = padded_region & target.geometry;
+            cache_update = calculate_translucent_damage(target, we_repaint ^ cache_state->valid);
+
+            padded_region = cache_update;
+            padded_region.expand_edges(cache_padding);
+        } else
+        {
+            padded_region.expand_edges(padding);
+        }
+
         padded_region &= bbox;
 
         // Don't forget to keep expanded damage within the bounds of the render
         // target, otherwise we may be sampling from outside of it (undefined
         // contents).
         padded_region &= target.geometry;
+        we_repaint    |= padded_region;
+        blur_region    = use_cache ? padded_region : we_repaint;
 
-        // Actual region which will be repainted by this render instance.
-        wf::region_t we_repaint = padded_region;
-
-        this->saved_pixels   = self->acquire_saved_pixel_buffer();
-        saved_pixels->region =
-            target.framebuffer_region_from_geometry_region(padded_region) ^
+        auto extra_region = target.framebuffer_region_from_geometry_region(padded_region) ^
             target.framebuffer_region_from_geometry_region(damage);
-
-        // Nodes below should re-render the padded areas so that we can sample from them
-        damage |= padded_region;
-
-        saved_pixels->pixels.allocate(target.get_size());
-
-        wf::gles::run_in_context_if_gles([&]
+        if (!extra_region.empty())
         {
-            GLuint target_fb = wf::gles::ensure_render_buffer_fb_id(target);
+            this->saved_pixels   = self->acquire_saved_pixel_buffer();
+            saved_pixels->region = extra_region;
 
-            wf::gles::bind_render_buffer(saved_pixels->pixels.get_renderbuffer());
-            GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, target_fb));
+            // Nodes below should re-render the padded areas so that we can sample from them
+            damage |= padded_region;
 
-            /* Copy pixels in padded_region from target_fb to saved_pixels. */
-            for (const auto& box : saved_pixels->region)
+            saved_pixels->pixels.allocate(target.get_size());
+
+            wf::gles::run_in_context_if_gles([&]
             {
-                GL_CALL(glBlitFramebuffer(
-                    box.x1, box.y1,
-                    box.x2, box.y2,
-                    box.x1, box.y1,
-                    box.x2, box.y2,
-                    GL_COLOR_BUFFER_BIT, GL_LINEAR));
-            }
-        });
+                GLuint target_fb = wf::gles::ensure_render_buffer_fb_id(target);
+
+                wf::gles::bind_render_buffer(saved_pixels->pixels.get_renderbuffer());
+                GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, target_fb));
+
+                /* Copy pixels in padded_region from target_fb to saved_pixels. */
+                for (const auto& box : saved_pixels->region)
+                {
+                    GL_CALL(glBlitFramebuffer(
+                        box.x1, box.y1,
+                        box.x2, box.y2,
+                        box.x1, box.y1,
+                        box.x2, box.y2,
+                        GL_COLOR_BUFFER_BIT, GL_LINEAR));
+                }
+            });
+        }
 
         instructions.push_back(render_instruction_t{
                     .instance = this,
@@ -208,14 +331,38 @@ class blur_render_instance_t : public transformer_render_instance_t<blur_node_t>
         data.pass->custom_gles_subpass([&]
         {
             auto tex = wf::gles_texture_t{get_texture(data.target.scale)};
-            if (!data.damage.empty())
+            if (!blur_region.empty())
             {
-                auto translucent_damage = calculate_translucent_damage(data.target, data.damage);
+                auto translucent_damage = calculate_translucent_damage(data.target, blur_region);
                 self->provider()->prepare_blur(data.target, translucent_damage);
-                self->provider()->render(tex, bounding_box, data.damage, data.target, data.target);
             }
 
+            if (use_cache && !cache_update.empty())
+            {
+                self->provider()->update_cache(cache_state->cache, data.target, cache_update);
+                cache_state->valid |= cache_update;
+            }
+
+            if (!data.damage.empty())
+            {
+                if (use_cache)
+                {
+                    self->provider()->render(tex, bounding_box, data.damage, data.target, data.target,
+                        cache_state->cache);
+                } else
+                {
+                    self->provider()->render(tex, bounding_box, data.damage, data.target, data.target);
+                }
+            }
+
+            blur_region.clear();
+            cache_update.clear();
+
             GL_CALL(glDisable(GL_SCISSOR_TEST));
+            if (!saved_pixels)
+            {
+                return;
+            }
 
             GLuint saved_fb = wf::gles::ensure_render_buffer_fb_id(saved_pixels->pixels.get_renderbuffer());
             wf::gles::bind_render_buffer(data.target);
@@ -88,6 +88,23 @@
  * `````````````````````````````````````````````````````````````````
  */
 
+class wf_blur_base;
+
+/**
+ * A blurred background kept between frames, so that it does not have to be recomputed while the content
+ * behind a view does not change.
+ */
+struct blur_cache_t
+{
+    // The blurred background, at the degraded resolution.
+    wf::auxilliary_buffer_t buffer;
+    // The region covered by @buffer, in framebuffer coordinates of the target it was prepared for.
+    wf::geometry_t geometry = {0, 0, 0, 0};
+    // The algorithm and degrade factor the background was blurred with.
+    const wf_blur_base *algorithm = nullptr;
+    int degrade = 0;
+};
+
 class wf_blur_base
 {
   protected:
@@ -127,6 +144,11 @@ class wf_blur_base
      * returns the index of the fb where the result is stored (0 or 1) */
     virtual int blur_fb0(const wf::region_t& blur_region, int width, int height) = 0;
 
+    /* blend the view with the given blurred background, see render() */
+    void render_blended(wf::gles_texture_t src_tex, wlr_box src_box, const wf::region_t& damage,
+        const wf::render_target_t& background_source_fb, const wf::render_target_t& target_fb,
+        wf::gles_texture_t blurred_background, wf::geometry_t blurred_geometry);
+
   public:
     wf_blur_base(std::string name);
     virtual ~wf_blur_base();
@@ -152,6 +174,41 @@ class wf_blur_base
      */
     void render(wf::gles_texture_t src_tex, wlr_box src_box, const wf::region_t& damage,
         const wf::render_target_t& background_source_fb, const wf::render_target_t& target_fb);
+
+    /**
+     * Same as the other render(), but uses the blurred background stored in @cache instead of the one
+     * prepared by @prepare_blur.
+     */
+    void render(wf::gles_texture_t src_tex, wlr_box src_box, const wf::region_t& damage,
+        const wf::render_target_t& background_source_fb, const wf::render_target_t& target_fb,
+        blur_cache_t& cache);
+
+    /**
+     * Allocate @cache for blurring @region of @target_fb with the current settings, discarding its
+     * contents.
+     *
+     * @param region The region to cache, in logical coordinates.
+     */
+    void reset_cache(blur_cache_t& cache, const wf::render_target_t& target_fb, wf::geometry_t region);
+
+    /**
+     * Whether @cache was created with the current algorithm settings.
+     */
+    bool is_cache_current(const blur_cache_t& cache) const;
+
+    /**
+     * Copy the blurred background prepared by @prepare_blur to @cache.
+     *
+     * @param region The region to copy, in logical coordinates. It should lie at least the blur radius plus
+     *   the degrade factor inside the region passed to @prepare_blur, otherwise artifacts from the edges of
+     *   the prepared region end up in the cache.
+     */
+    void update_cache(blur_cache_t& cache, const wf::render_target_t& target_fb, const wf::region_t& region);
+
+    /**
+     * The size of the blocks of pixels that are blurred together, in framebuffer pixels.
+     */
+    int get_degrade() const;
 };
 
 std::unique_ptr<wf_blur_base> create_box_blur();
@@ -798,6 +798,12 @@ class wayfire_cube_global : public wf::plugin_interface_t,
         this->fini_output_tracking();
     }
 
+    bool is_init_deferrable() const override
+    {
+        // Not needed until the user activates it.
+        return true;
+    }
+
     wf::ipc_activator_t::handler_t rotate_left_cb = [=] (wf::output_t *output, wayfire_view)
     {
         return this->output_instance[output]->move_vp(-1);
@@ -10,6 +10,7 @@
 #include "wayfire/signal-provider.hpp"
 #include <memory>
 #include <wayfire/view-transform.hpp>
+#include <wayfire/view-snapshot.hpp>
 #include <wayfire/toplevel-view.hpp>
 #include <wayfire/output.hpp>
 #include <wayfire/nonstd/wlroots.hpp>
@@ -35,7 +36,7 @@ class crossfade_node_t : public scene::view_2d_transformer_t
   public:
     wayfire_toplevel_view view;
     // The contents of the view before the change.
-    wf::auxilliary_buffer_t original_buffer;
+    wf::view_snapshot_t original_buffer;
 
   public:
     wf::geometry_t displayed_geometry;
@@ -45,28 +46,7 @@ class crossfade_node_t : public scene::view_2d_transformer_t
     {
         displayed_geometry = view->get_geometry();
         this->view = view;
-
-        auto root_node = view->get_surface_root_node();
-        const wf::geometry_t bbox = root_node->get_bounding_box();
-        const wf::geometry_t g    = view->get_geometry();
-        const float scale = view->get_output()->handle->scale;
-        original_buffer.allocate(wf::dimensions(g), scale,
-            wf::buffer_allocation_hints_t{.hdr_linear = view->get_output() && view->get_output()->is_hdr()});
-
-        wf::render_target_t target{original_buffer};
-        target.geometry = view->get_geometry();
-        target.scale    = view->get_output()->handle->scale;
-
-        std::vector<scene::render_instance_uptr> instances;
-        root_node->gen_render_instances(instances, [] (auto) {}, view->get_output());
-
-        render_pass_params_t params;
-        params.background_color = {0, 0, 0, 0};
-        params.damage    = bbox;
-        params.target    = target;
-        params.instances = &instances;
-        params.flags     = RPASS_CLEAR_BACKGROUND;
-        wf::render_pass_t::run(params);
+        original_buffer.capture(view, view->get_geometry());
     }
 
     std::string stringify() const override
@@ -151,9 +131,7 @@ class crossfade_render_instance_t : public scene::render_instance_t
             ra = std::pow((self->overlay_alpha - 0.5) * 2, N) / 2.0 + 0.5;
         }
 
-        auto tex = wf::texture_t::from_buffer(
-            self->original_buffer.get_buffer(), self->original_buffer.get_texture());
-        data.pass->add_texture(tex, data.target, self->displayed_geometry, data.damage, 1.0 - ra);
+        self->original_buffer.render(data, self->displayed_geometry, 1.0 - ra);
     }
 };
 
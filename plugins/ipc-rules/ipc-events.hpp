@@ -142,6 +142,7 @@ class ipc_rules_events_methods_t : public wf::per_output_tracker_mixin_t<>
         {"plugin-activation-state-changed", get_generic_core_registration_cb(&on_plugin_activation_changed)},
         {"output-gain-focus", get_generic_core_registration_cb(&on_output_gain_focus)},
         {"keyboard-modifier-state-changed", get_generic_core_registration_cb(&on_keyboard_modifiers)},
+        {"config-reloaded", get_generic_core_registration_cb(&on_config_reloaded)},
 
         {"output-added", get_generic_output_registration_cb(&on_output_added)},
         {"output-removed", get_generic_output_layout_registration_cb(&on_output_removed)},
@@ -429,6 +430,24 @@ class ipc_rules_events_methods_t : public wf::per_output_tracker_mixin_t<>
         send_event_to_subscribes(data, data["event"]);
     };
 
+    wf::signal::connection_t<wf::reload_config_signal> on_config_reloaded = [=] (wf::reload_config_signal *ev)
+    {
+        wf::json_t data;
+        data["event"] = "config-reloaded";
+        // null if the changes are not known
+        data["changed-options"] = wf::json_t{};
+        if (ev->changed_options)
+        {
+            data["changed-options"] = wf::json_t::array();
+            for (auto& name : *ev->changed_options)
+            {
+                data["changed-options"].append(name);
+            }
+        }
+
+        send_event_to_subscribes(data, data["event"]);
+    };
+
     wf::signal::connection_t<wf::output_gain_focus_signal> on_output_gain_focus =
         [=] (wf::output_gain_focus_signal *ev)
     {
@@ -16,11 +16,13 @@
 #include "ipc-input-methods.hpp"
 #include "ipc-utility-methods.hpp"
 #include "ipc-events.hpp"
+#include "ipc-view-stream.hpp"
 
 class ipc_rules_t : public wf::plugin_interface_t,
     public wf::ipc_rules_input_methods_t,
     public wf::ipc_rules_utility_methods_t,
-    public wf::ipc_rules_events_methods_t
+    public wf::ipc_rules_events_methods_t,
+    public wf::ipc_rules_view_stream_methods_t
 {
   public:
     void init() override
@@ -43,6 +45,7 @@ class ipc_rules_t : public wf::plugin_interface_t,
         init_input_methods(method_repository.get());
         init_utility_methods(method_repository.get());
         init_events(method_repository.get());
+        init_view_stream(method_repository.get());
     }
 
     void fini() override
@@ -65,6 +68,7 @@ class ipc_rules_t : public wf::plugin_interface_t,
         fini_input_methods(method_repository.get());
         fini_utility_methods(method_repository.get());
         fini_events(method_repository.get());
+        fini_view_stream(method_repository.get());
     }
 
     wf::ipc::method_callback list_views = [=] (wf::json_t)
@@ -4,10 +4,13 @@
 #include "wayfire/plugins/ipc/ipc-method-repository.hpp"
 #include "wayfire/debug.hpp"
 #include "wayfire/signal-definitions.hpp"
+#include "wayfire/startup-timing.hpp"
+#include "wayfire/alloc-profiling.hpp"
 #include <set>
 #include <wayfire/plugin.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
 #include <wayfire/output-layout.hpp>
+#include <wayfire/render-manager.hpp>
 #include <wayfire/config/compound-option.hpp>
 #include <wayfire/config/config-manager.hpp>
 
@@ -35,6 +38,9 @@ class ipc_rules_utility_methods_t
         method_repository->register_method("wayfire/set-config-options", set_config_options);
         method_repository->register_method("wayfire/get-keyboard-state", get_kb_state);
         method_repository->register_method("wayfire/set-keyboard-state", set_kb_state);
+        method_repository->register_method("wayfire/startup-timing", get_startup_timing);
+        method_repository->register_method("wayfire/alloc-profile", get_alloc_profile);
+        method_repository->register_method("wayfire/damage-stats", get_damage_stats);
     }
 
     void fini_utility_methods(ipc::method_repository_t *method_repository)
@@ -47,6 +53,9 @@ class ipc_rules_utility_methods_t
         method_repository->unregister_method("wayfire/set-config-option");
         method_repository->unregister_method("wayfire/get-keyboard-state");
         method_repository->unregister_method("wayfire/set-keyboard-state");
+        method_repository->unregister_method("wayfire/startup-timing");
+        method_repository->unregister_method("wayfire/alloc-profile");
+        method_repository->unregister_method("wayfire/damage-stats");
     }
 
     wf::ipc::method_callback get_wayfire_configuration_info = [=] (wf::json_t)
@@ -63,6 +72,84 @@ class ipc_rules_utility_methods_t
         return response;
     };
 
+    wf::ipc::method_callback get_startup_timing = [=] (wf::json_t)
+    {
+        auto to_ms = [] (std::chrono::microseconds us) { return us.count() / 1000.0; };
+
+        wf::json_t response = wf::ipc::json_ok();
+        response["phases"] = wf::json_t::array();
+        for (auto& phase : wf::startup::get_phases())
+        {
+            wf::json_t entry;
+            entry["name"]     = phase.name;
+            entry["depth"]    = phase.depth;
+            entry["start-ms"] = to_ms(phase.start);
+            entry["duration-ms"] = to_ms(phase.duration);
+            entry["finished"]    = phase.finished;
+            response["phases"].append(entry);
+        }
+
+        if (auto first_frame = wf::startup::get_time_to_first_frame())
+        {
+            response["first-frame-ms"] = to_ms(*first_frame);
+        } else
+        {
+            response["first-frame-ms"] = wf::json_t::null();
+        }
+
+        return response;
+    };
+
+    wf::ipc::method_callback get_alloc_profile = [=] (const wf::json_t& data)
+    {
+        wf::json_t response = wf::ipc::json_ok();
+        response["enabled"] = wf::alloc_profiling::enabled;
+        response["scopes"]  = wf::json_t::array();
+        for (auto& stats : wf::alloc_profiling::get_stats())
+        {
+            wf::json_t entry;
+            entry["name"]  = stats.name;
+            entry["count"] = stats.count;
+            entry["allocations"] = stats.allocations;
+            entry["bytes"] = stats.bytes;
+            entry["max-allocations"] = stats.max_allocations;
+            response["scopes"].append(entry);
+        }
+
+        if (wf::ipc::json_get_optional_bool(data, "reset").value_or(false))
+        {
+            wf::alloc_profiling::reset();
+        }
+
+        return response;
+    };
+
+    wf::ipc::method_callback get_damage_stats = [=] (const wf::json_t& data)
+    {
+        const bool reset    = wf::ipc::json_get_optional_bool(data, "reset").value_or(false);
+        wf::json_t response = wf::ipc::json_ok();
+        response["outputs"] = wf::json_t::array();
+        for (auto& wo : wf::get_core().output_layout->get_outputs())
+        {
+            auto stats = wo->render->get_damage_stats();
+            wf::json_t entry;
+            entry["output-id"]   = wo->get_id();
+            entry["output-name"] = wo->to_string();
+            entry["frames"] = stats.frames;
+            entry["simplified-frames"] = stats.simplified_frames;
+            entry["rects-before"] = stats.rects_before;
+            entry["rects-after"]  = stats.rects_after;
+            response["outputs"].append(entry);
+
+            if (reset)
+            {
+                wo->render->reset_damage_stats();
+            }
+        }
+
+        return response;
+    };
+
     wf::ipc::method_callback create_headless_output = [=] (const wf::json_t& data)
     {
         auto width  = wf::ipc::json_get_uint64(data, "width");
@@ -314,6 +401,7 @@ class ipc_rules_utility_methods_t
             return wf::ipc::json_error("Options must be an object!");
         }
 
+        std::set<std::string> changed_options;
         for (auto& option : data.get_member_names())
         {
             auto opt = wf::get_core().config->get_option(option);
@@ -322,6 +410,8 @@ class ipc_rules_utility_methods_t
                 return wf::ipc::json_error(option + ": Option not found!");
             }
 
+            changed_options.insert(option);
+
             if (auto compound = std::dynamic_pointer_cast<wf::config::compound_option_t>(opt))
             {
                 auto error = parse_compound_json(data[option], compound);
@@ -342,6 +432,7 @@ class ipc_rules_utility_methods_t
         }
 
         reload_config_signal event;
+        event.changed_options = std::move(changed_options);
         wf::get_core().emit(&event);
         return wf::ipc::json_ok();
     };
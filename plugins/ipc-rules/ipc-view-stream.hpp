@@ -0,0 +1,382 @@
+#pragma once
+
+#include "ipc-rules-common.hpp"
+#include <set>
+#include <map>
+#include "wayfire/output-layout.hpp"
+#include "wayfire/plugins/ipc/ipc-method-repository.hpp"
+#include <wayfire/signal-definitions.hpp>
+#include "plugins/wm-actions/wm-actions-signals.hpp"
+
+namespace wf
+{
+/**
+ * An incremental version of window-rules/list-views.
+ *
+ * A client calls window-rules/list-views/subscribe and receives a snapshot of all views together with a
+ * sequence number. Afterwards, the client receives view-list-diff events, each with the next sequence number,
+ * containing only the views which were added, removed, or had some of their fields changed since the last
+ * diff. Changes are batched until the event loop goes idle, so a burst of signals results in a single diff.
+ *
+ * Views are tracked (and views state is mirrored for comparison) only while at least one client is
+ * subscribed.
+ */
+class ipc_rules_view_stream_methods_t
+{
+    static constexpr const char *DIFF_EVENT = "view-list-diff";
+
+  public:
+    void init_view_stream(ipc::method_repository_t *method_repository)
+    {
+        method_repository->register_method("window-rules/list-views/subscribe", on_stream_subscribe);
+        method_repository->register_method("window-rules/list-views/unsubscribe", on_stream_unsubscribe);
+        method_repository->connect(&on_stream_client_disconnected);
+    }
+
+    void fini_view_stream(ipc::method_repository_t *method_repository)
+    {
+        method_repository->unregister_method("window-rules/list-views/subscribe");
+        method_repository->unregister_method("window-rules/list-views/unsubscribe");
+        on_stream_client_disconnected.disconnect();
+        stream_clients.clear();
+        stop_tracking();
+    }
+
+  private:
+    std::set<wf::ipc::client_interface_t*> stream_clients;
+
+    // The sequence number of the last sent diff. The snapshot sent on subscription has the current value.
+    uint64_t sequence = 0;
+
+    // The last state sent to the clients: view id -> (field name -> serialized value)
+    std::map<uint32_t, std::map<std::string, std::string>> mirror;
+    std::map<uint32_t, wayfire_view> tracked_views;
+    std::set<uint32_t> dirty_views;
+    wf::wl_idle_call idle_flush;
+
+    wf::ipc::method_callback_full on_stream_subscribe =
+        [=] (wf::json_t data, wf::ipc::client_interface_t *client)
+    {
+        if (stream_clients.count(client))
+        {
+            return wf::ipc::json_error("Client is already subscribed to the view list!");
+        }
+
+        if (stream_clients.empty())
+        {
+            start_tracking();
+        } else
+        {
+            // Make sure that the snapshot matches the sequence number we send.
+            flush_changes();
+        }
+
+        stream_clients.insert(client);
+
+        auto response = wf::ipc::json_ok();
+        response["sequence"] = sequence;
+        response["views"]    = wf::json_t::array();
+        for (auto& [id, view] : tracked_views)
+        {
+            response["views"].append(ipc_rules::view_to_json(view));
+        }
+
+        return response;
+    };
+
+    wf::ipc::method_callback_full on_stream_unsubscribe =
+        [=] (wf::json_t data, wf::ipc::client_interface_t *client)
+    {
+        if (!stream_clients.count(client))
+        {
+            return wf::ipc::json_error("Client is not subscribed to the view list!");
+        }
+
+        remove_stream_client(client);
+        return wf::ipc::json_ok();
+    };
+
+    wf::signal::connection_t<wf::ipc::client_disconnected_signal> on_stream_client_disconnected =
+        [=] (wf::ipc::client_disconnected_signal *ev)
+    {
+        remove_stream_client(ev->client);
+    };
+
+    void remove_stream_client(wf::ipc::client_interface_t *client)
+    {
+        if (stream_clients.erase(client) && stream_clients.empty())
+        {
+            stop_tracking();
+        }
+    }
+
+    void start_tracking()
+    {
+        wf::get_core().connect(&on_view_mapped);
+        wf::get_core().connect(&on_geometry_changed);
+        wf::get_core().connect(&on_title_changed);
+        wf::get_core().connect(&on_app_id_changed);
+        wf::get_core().connect(&on_moved_to_wset);
+        wf::get_core().connect(&on_focus_changed);
+        wf::get_core().output_layout->connect(&on_output_added);
+        for (auto& wo : wf::get_core().output_layout->get_outputs())
+        {
+            track_output(wo);
+        }
+
+        for (auto& view : wf::get_core().get_all_views())
+        {
+            track_view(view);
+            mirror[view->get_id()] = serialize_fields(ipc_rules::view_to_json(view));
+        }
+    }
+
+    void stop_tracking()
+    {
+        for (auto conn : std::initializer_list<wf::signal::connection_base_t*>{
+            &on_view_mapped, &on_geometry_changed, &on_title_changed, &on_app_id_changed,
+            &on_moved_to_wset, &on_focus_changed, &on_output_added, &on_workspace_changed,
+            &on_above_changed, &on_set_output, &on_unmapped, &on_minimized, &on_sticky, &on_activated,
+            &on_tiled, &on_fullscreen, &on_view_destruct})
+        {
+            conn->disconnect();
+        }
+
+        idle_flush.disconnect();
+        tracked_views.clear();
+        dirty_views.clear();
+        mirror.clear();
+    }
+
+    void track_output(wf::output_t *output)
+    {
+        output->connect(&on_workspace_changed);
+        output->connect(&on_above_changed);
+    }
+
+    void track_view(wayfire_view view)
+    {
+        if (tracked_views.count(view->get_id()))
+        {
+            return;
+        }
+
+        tracked_views[view->get_id()] = view;
+        view->connect(&on_set_output);
+        view->connect(&on_unmapped);
+        view->connect(&on_minimized);
+        view->connect(&on_sticky);
+        view->connect(&on_activated);
+        view->connect(&on_tiled);
+        view->connect(&on_fullscreen);
+        view->connect(&on_view_destruct);
+    }
+
+    void mark_dirty(wayfire_view view)
+    {
+        if (!view)
+        {
+            return;
+        }
+
+        track_view(view);
+        dirty_views.insert(view->get_id());
+        idle_flush.run_once([=] () { flush_changes(); });
+    }
+
+    static std::string serialize_json(const wf::json_t& data)
+    {
+        std::string buffer;
+        data.map_serialized([&] (const char *src, size_t size)
+        {
+            buffer = std::string{src, size};
+        });
+
+        return buffer;
+    }
+
+    static std::map<std::string, std::string> serialize_fields(const wf::json_t& view_json)
+    {
+        std::map<std::string, std::string> fields;
+        for (auto& key : view_json.get_member_names())
+        {
+            fields[key] = serialize_json(view_json[key]);
+        }
+
+        return fields;
+    }
+
+    void flush_changes()
+    {
+        idle_flush.disconnect();
+        if (dirty_views.empty())
+        {
+            return;
+        }
+
+        wf::json_t changes = wf::json_t::array();
+        for (auto id : dirty_views)
+        {
+            wf::json_t change;
+            change["id"] = id;
+
+            auto it = tracked_views.find(id);
+            if (it == tracked_views.end())
+            {
+                if (mirror.erase(id))
+                {
+                    change["change"] = "removed";
+                    changes.append(change);
+                }
+
+                continue;
+            }
+
+            auto view_json = ipc_rules::view_to_json(it->second);
+            auto fields    = serialize_fields(view_json);
+            auto old_it    = mirror.find(id);
+            if (old_it == mirror.end())
+            {
+                change["change"] = "added";
+                change["view"]   = view_json;
+                changes.append(change);
+                mirror[id] = std::move(fields);
+                continue;
+            }
+
+            wf::json_t changed_fields;
+            bool has_changes = false;
+            for (auto& [key, value] : fields)
+            {
+                auto old_value = old_it->second.find(key);
+                if ((old_value == old_it->second.end()) || (old_value->second != value))
+                {
+                    changed_fields[key] = view_json[key];
+                    has_changes = true;
+                }
+            }
+
+            if (has_changes)
+            {
+                change["change"] = "updated";
+                change["fields"] = changed_fields;
+                changes.append(change);
+                old_it->second = std::move(fields);
+            }
+        }
+
+        dirty_views.clear();
+        if (changes.size() == 0)
+        {
+            return;
+        }
+
+        wf::json_t event;
+        event["event"]    = DIFF_EVENT;
+        event["sequence"] = ++sequence;
+        event["changes"]  = changes;
+        for (auto& client : stream_clients)
+        {
+            client->send_json(event);
+        }
+    }
+
+    wf::signal::connection_t<wf::output_added_signal> on_output_added = [=] (wf::output_added_signal *ev)
+    {
+        track_output(ev->output);
+    };
+
+    wf::signal::connection_t<wf::view_mapped_signal> on_view_mapped = [=] (wf::view_mapped_signal *ev)
+    {
+        mark_dirty(ev->view);
+    };
+
+    wf::signal::connection_t<wf::view_unmapped_signal> on_unmapped = [=] (wf::view_unmapped_signal *ev)
+    {
+        mark_dirty(ev->view);
+    };
+
+    wf::signal::connection_t<wf::destruct_signal<view_interface_t>> on_view_destruct =
+        [=] (wf::destruct_signal<view_interface_t> *ev)
+    {
+        tracked_views.erase(ev->object->get_id());
+        dirty_views.insert(ev->object->get_id());
+        idle_flush.run_once([=] () { flush_changes(); });
+    };
+
+    wf::signal::connection_t<wf::view_set_output_signal> on_set_output =
+        [=] (wf::view_set_output_signal *ev)
+    {
+        mark_dirty(ev->view);
+    };
+
+    wf::signal::connection_t<wf::view_geometry_changed_signal> on_geometry_changed =
+        [=] (wf::view_geometry_changed_signal *ev)
+    {
+        mark_dirty(ev->view);
+    };
+
+    wf::signal::connection_t<wf::view_title_changed_signal> on_title_changed =
+        [=] (wf::view_title_changed_signal *ev)
+    {
+        mark_dirty(ev->view);
+    };
+
+    wf::signal::connection_t<wf::view_app_id_changed_signal> on_app_id_changed =
+        [=] (wf::view_app_id_changed_signal *ev)
+    {
+        mark_dirty(ev->view);
+    };
+
+    wf::signal::connection_t<wf::view_moved_to_wset_signal> on_moved_to_wset =
+        [=] (wf::view_moved_to_wset_signal *ev)
+    {
+        mark_dirty(ev->view);
+    };
+
+    wf::signal::connection_t<wf::keyboard_focus_changed_signal> on_focus_changed =
+        [=] (wf::keyboard_focus_changed_signal *ev)
+    {
+        // The previously focused view is updated via its activated signal.
+        mark_dirty(wf::node_to_view(ev->new_focus));
+    };
+
+    wf::signal::connection_t<wf::view_minimized_signal> on_minimized = [=] (wf::view_minimized_signal *ev)
+    {
+        mark_dirty(ev->view);
+    };
+
+    wf::signal::connection_t<wf::view_set_sticky_signal> on_sticky = [=] (wf::view_set_sticky_signal *ev)
+    {
+        mark_dirty(ev->view);
+    };
+
+    wf::signal::connection_t<wf::view_activated_state_signal> on_activated =
+        [=] (wf::view_activated_state_signal *ev)
+    {
+        mark_dirty(ev->view);
+    };
+
+    wf::signal::connection_t<wf::view_tiled_signal> on_tiled = [=] (wf::view_tiled_signal *ev)
+    {
+        mark_dirty(ev->view);
+    };
+
+    wf::signal::connection_t<wf::view_fullscreen_signal> on_fullscreen = [=] (wf::view_fullscreen_signal *ev)
+    {
+        mark_dirty(ev->view);
+    };
+
+    wf::signal::connection_t<wf::view_change_workspace_signal> on_workspace_changed =
+        [=] (wf::view_change_workspace_signal *ev)
+    {
+        mark_dirty(ev->view);
+    };
+
+    wf::signal::connection_t<wf::wm_actions_above_changed_signal> on_above_changed =
+        [=] (wf::wm_actions_above_changed_signal *ev)
+    {
+        mark_dirty(ev->view);
+    };
+};
+}
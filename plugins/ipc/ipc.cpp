@@ -1,6 +1,7 @@
 #include "ipc.hpp"
 #include "wayfire/plugins/common/shared-core-data.hpp"
 #include <climits>
+#include <wayfire/alloc-profiling.hpp>
 #include <wayfire/util/log.hpp>
 #include <wayfire/core.hpp>
 #include <wayfire/plugin.hpp>
@@ -134,6 +135,7 @@ void wf::ipc::server_t::client_disappeared(client_t *client)
 void wf::ipc::server_t::handle_incoming_message(
     client_t *client, wf::json_t message)
 {
+    wf::alloc_profiling::scope_t alloc_scope{"ipc"};
     client->send_json(method_repository->call_method(message["method"], message["data"], client));
 }
 
@@ -2,6 +2,10 @@
 #include "wayfire/util.hpp"
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <optional>
+#include <algorithm>
+#include <cctype>
 #include <wayfire/plugin.hpp>
 #include <wayfire/per-output-plugin.hpp>
 #include <wayfire/output.hpp>
@@ -21,6 +25,186 @@
 
 class scale_title_filter;
 
+/**
+ * Decode an UTF-8 string into code points. Invalid sequences are replaced by U+FFFD.
+ */
+static std::u32string decode_utf8(const std::string& str)
+{
+    std::u32string result;
+    result.reserve(str.size());
+    for (size_t i = 0; i < str.size();)
+    {
+        unsigned char c = str[i];
+        int len = (c < 0x80) ? 1 : ((c >> 5) == 0x6) ? 2 : ((c >> 4) == 0xe) ? 3 : ((c >> 3) == 0x1e) ? 4 : 0;
+        char32_t cp = (len == 1) ? c : (len == 2) ? (c & 0x1f) : (len == 3) ? (c & 0x0f) : (c & 0x07);
+        bool valid = (len > 0) && (i + len <= str.size());
+        for (int j = 1; valid && (j < len); j++)
+        {
+            unsigned char cont = str[i + j];
+            valid = ((cont >> 6) == 0x2);
+            cp    = (cp << 6) | (cont & 0x3f);
+        }
+
+        result.push_back(valid ? cp : U'\ufffd');
+        i += valid ? len : 1;
+    }
+
+    return result;
+}
+
+/**
+ * Simple case folding for the common alphabets (Latin, Greek and Cyrillic), which does not depend on the
+ * locale of the compositor. Whitespace is folded to a plain space.
+ */
+static char32_t fold_case(char32_t c)
+{
+    if ((c < 0x80) && std::isspace((int)c))
+    {
+        return ' ';
+    }
+
+    if (c == 0xa0)
+    {
+        return ' ';
+    }
+
+    if (((c >= 'A') && (c <= 'Z')) || ((c >= 0xc0) && (c <= 0xde) && (c != 0xd7)) ||
+        ((c >= 0x391) && (c <= 0x3a9) && (c != 0x3a2)) || ((c >= 0x410) && (c <= 0x42f)))
+    {
+        return c + 0x20;
+    }
+
+    if ((c >= 0x400) && (c <= 0x40f))
+    {
+        return c + 0x50;
+    }
+
+    // Latin Extended-A alternates between upper and lower case letters, with a few exceptions.
+    if ((((c >= 0x100) && (c <= 0x12f)) || ((c >= 0x132) && (c <= 0x137)) ||
+         ((c >= 0x14a) && (c <= 0x177)) || ((c >= 0x460) && (c <= 0x481))) && (c % 2 == 0))
+    {
+        return c + 1;
+    }
+
+    if ((((c >= 0x139) && (c <= 0x148)) || ((c >= 0x179) && (c <= 0x17e))) && (c % 2 == 1))
+    {
+        return c + 1;
+    }
+
+    return c;
+}
+
+static std::u32string fold_case(std::u32string str)
+{
+    std::transform(str.begin(), str.end(), str.begin(), [] (char32_t c) { return fold_case(c); });
+    return str;
+}
+
+/**
+ * Check whether all characters of @pattern appear in @str in the same order.
+ */
+static bool is_subsequence(const std::u32string& pattern, const std::u32string& str)
+{
+    size_t matched = 0;
+    for (size_t i = 0; (i < str.size()) && (matched < pattern.size()); i++)
+    {
+        matched += (str[i] == pattern[matched]);
+    }
+
+    return matched == pattern.size();
+}
+
+/**
+ * The decoded and case-folded titles and app-ids of all views, shared among all outputs.
+ *
+ * Entries are computed when a view is first matched against a filter and dropped when its title or app-id
+ * changes, so typing into the filter does not decode or allocate anything for views which were already seen.
+ */
+class view_title_index_t
+{
+  public:
+    struct match_mode_t
+    {
+        bool case_sensitive;
+        bool fuzzy;
+
+        bool operator ==(const match_mode_t& other) const
+        {
+            return (case_sensitive == other.case_sensitive) && (fuzzy == other.fuzzy);
+        }
+    };
+
+    struct entry_t
+    {
+        std::u32string title, app_id;
+        std::u32string folded_title, folded_app_id;
+
+        /* The last pattern which did not match the view. Since a pattern which starts with it can not match
+         * either, the view can be skipped directly while more characters are typed into the filter. */
+        std::optional<std::u32string> rejected_by;
+        match_mode_t rejected_mode;
+
+        bool matches(const std::u32string& pattern, match_mode_t mode)
+        {
+            if (rejected_by && (rejected_mode == mode) &&
+                (pattern.compare(0, rejected_by->size(), *rejected_by) == 0))
+            {
+                return false;
+            }
+
+            const auto& t = mode.case_sensitive ? title : folded_title;
+            const auto& a = mode.case_sensitive ? app_id : folded_app_id;
+            bool match = (t.find(pattern) != std::u32string::npos) ||
+                (a.find(pattern) != std::u32string::npos);
+            if (!match && mode.fuzzy)
+            {
+                match = is_subsequence(pattern, t) || is_subsequence(pattern, a);
+            }
+
+            if (!match)
+            {
+                rejected_by   = pattern;
+                rejected_mode = mode;
+            }
+
+            return match;
+        }
+    };
+
+    view_title_index_t()
+    {
+        wf::get_core().connect(&on_title_changed);
+        wf::get_core().connect(&on_app_id_changed);
+        wf::get_core().connect(&on_view_unmapped);
+    }
+
+    entry_t& get(wayfire_view view)
+    {
+        auto it = entries.find(view.get());
+        if (it == entries.end())
+        {
+            entry_t entry;
+            entry.title  = decode_utf8(view->get_title());
+            entry.app_id = decode_utf8(view->get_app_id());
+            entry.folded_title  = fold_case(entry.title);
+            entry.folded_app_id = fold_case(entry.app_id);
+            it = entries.emplace(view.get(), std::move(entry)).first;
+        }
+
+        return it->second;
+    }
+
+  private:
+    std::unordered_map<wf::view_interface_t*, entry_t> entries;
+
+    wf::signal::connection_t<wf::view_title_changed_signal> on_title_changed =
+        [=] (wf::view_title_changed_signal *ev) { entries.erase(ev->view.get()); };
+    wf::signal::connection_t<wf::view_app_id_changed_signal> on_app_id_changed =
+        [=] (wf::view_app_id_changed_signal *ev) { entries.erase(ev->view.get()); };
+    wf::signal::connection_t<wf::view_unmapped_signal> on_view_unmapped =
+        [=] (wf::view_unmapped_signal *ev) { entries.erase(ev->view.get()); };
+};
+
 /**
  * Class storing the filter text, shared among all outputs
  */
@@ -30,6 +214,26 @@ struct scale_title_filter_text
     /* since title filter is utf-8, here we store the length of each
      * character when adding them so backspace will work properly */
     std::vector<int> char_len;
+    /* the filter decoded into code points, optionally case-folded, see get_pattern() */
+    std::u32string pattern;
+    std::string pattern_source;
+    bool pattern_folded = false;
+
+    const std::u32string& get_pattern(bool case_sensitive)
+    {
+        if ((pattern_source != title_filter) || (pattern_folded == case_sensitive))
+        {
+            pattern_source = title_filter;
+            pattern_folded = !case_sensitive;
+            pattern = decode_utf8(title_filter);
+            if (pattern_folded)
+            {
+                pattern = fold_case(std::move(pattern));
+            }
+        }
+
+        return pattern;
+    }
     /* Individual plugins running on each output -- this is used to update them
      * when the shared filter text changes. */
     std::vector<scale_title_filter*> output_instances;
@@ -79,46 +283,21 @@ class scale_title_filter : public wf::per_output_plugin_instance_t
 {
     wf::option_wrapper_t<bool> case_sensitive{"scale-title-filter/case_sensitive"};
     wf::option_wrapper_t<bool> share_filter{"scale-title-filter/share_filter"};
+    wf::option_wrapper_t<bool> fuzzy{"scale-title-filter/fuzzy"};
     scale_title_filter_text local_filter;
     wf::shared_data::ref_ptr_t<scale_title_filter_text> global_filter;
-
-    inline void fix_case(std::string& string)
-    {
-        if (case_sensitive)
-        {
-            return;
-        }
-
-        auto transform = [] (unsigned char c) -> unsigned char
-        {
-            if (std::isspace(c))
-            {
-                return ' ';
-            }
-
-            return (c <= 127) ? (unsigned char)std::tolower(c) : c;
-        };
-        std::transform(string.begin(), string.end(), string.begin(), transform);
-    }
+    wf::shared_data::ref_ptr_t<view_title_index_t> title_index;
 
     bool should_show_view(wayfire_view view)
     {
-        auto filter = get_active_filter().title_filter;
-
-        if (filter.empty())
+        auto& filter = get_active_filter();
+        if (filter.title_filter.empty())
         {
             return true;
         }
 
-        auto title  = view->get_title();
-        auto app_id = view->get_app_id();
-
-        fix_case(title);
-        fix_case(app_id);
-        fix_case(filter);
-
-        return (title.find(filter) != std::string::npos) ||
-               (app_id.find(filter) != std::string::npos);
+        return title_index->get(view).matches(filter.get_pattern(case_sensitive),
+            {.case_sensitive = case_sensitive, .fuzzy = fuzzy});
     }
 
     scale_title_filter_text& get_active_filter()
@@ -3,6 +3,7 @@
  */
 #include <map>
 #include <memory>
+#include <tuple>
 #include <wayfire/workarea.hpp>
 #include <wayfire/seat.hpp>
 #include <wayfire/per-output-plugin.hpp>
@@ -71,6 +72,7 @@ struct view_scale_data
 
     view_visibility_t visibility = view_visibility_t::VISIBLE;
     bool was_minimized = false; /* flag to indicate if this view was originally minimized */
+    bool has_target    = false; /* whether setup_view_transform() was called for the view */
 };
 
 /**
@@ -205,6 +207,7 @@ class wayfire_scale : public wf::per_output_plugin_instance_t,
 
         auto tr = std::make_shared<wf::scene::view_2d_transformer_t>(view);
         scale_data[view].transformer = tr;
+        scale_data[view].has_target  = false;
         view->get_transformed_node()->add_transformer(tr, wf::TRANSFORMER_2D + 1,
             SCALE_TRANSFORMER);
         /* Handle potentially minimized views by making them visible,
@@ -777,7 +780,11 @@ class wayfire_scale : public wf::per_output_plugin_instance_t,
             views.begin(), views.end(), wf::find_topmost_parent(view)) != views.end();
     }
 
-    /* Convenience assignment function */
+    /* Convenience assignment function.
+     *
+     * Animations which already go to (or have reached) the given target are
+     * left alone, so that relayouting does not restart the animations of
+     * views whose slot did not change, and they are not damaged again. */
     void setup_view_transform(view_scale_data& view_data,
         double scale_x,
         double scale_y,
@@ -785,37 +792,48 @@ class wayfire_scale : public wf::per_output_plugin_instance_t,
         double translation_y,
         double target_alpha)
     {
-        view_data.animation.scale_animation.scale_x.set(
-            view_data.transformer->scale_x, scale_x);
-        view_data.animation.scale_animation.scale_y.set(
-            view_data.transformer->scale_y, scale_y);
-        view_data.animation.scale_animation.translation_x.set(
-            view_data.transformer->translation_x, translation_x);
-        view_data.animation.scale_animation.translation_y.set(
-            view_data.transformer->translation_y, translation_y);
-        view_data.animation.scale_animation.start();
-        view_data.fade_animation = wf::animation::simple_animation_t(
-            wf::option_wrapper_t<wf::animation_description_t>{"scale/duration"});
-        view_data.fade_animation.animate(view_data.transformer->alpha,
-            target_alpha);
+        auto& scale_animation = view_data.animation.scale_animation;
+        const bool same_transform = view_data.has_target &&
+            (scale_animation.scale_x.end == scale_x) &&
+            (scale_animation.scale_y.end == scale_y) &&
+            (scale_animation.translation_x.end == translation_x) &&
+            (scale_animation.translation_y.end == translation_y);
+        const bool same_alpha = view_data.has_target &&
+            (view_data.fade_animation.end == target_alpha);
+        view_data.has_target = true;
+
+        if (!same_transform)
+        {
+            scale_animation.scale_x.set(view_data.transformer->scale_x, scale_x);
+            scale_animation.scale_y.set(view_data.transformer->scale_y, scale_y);
+            scale_animation.translation_x.set(view_data.transformer->translation_x, translation_x);
+            scale_animation.translation_y.set(view_data.transformer->translation_y, translation_y);
+            scale_animation.start();
+        }
+
+        if (!same_alpha)
+        {
+            view_data.fade_animation = wf::animation::simple_animation_t(
+                wf::option_wrapper_t<wf::animation_description_t>{"scale/duration"});
+            view_data.fade_animation.animate(view_data.transformer->alpha,
+                target_alpha);
+        }
     }
 
     static bool view_compare_x(const wayfire_toplevel_view& a, const wayfire_toplevel_view& b)
     {
         auto vg_a = a->get_geometry();
-        std::vector<int> a_coords = {vg_a.x, vg_a.width, vg_a.y, vg_a.height};
         auto vg_b = b->get_geometry();
-        std::vector<int> b_coords = {vg_b.x, vg_b.width, vg_b.y, vg_b.height};
-        return a_coords < b_coords;
+        return std::tie(vg_a.x, vg_a.width, vg_a.y, vg_a.height) <
+               std::tie(vg_b.x, vg_b.width, vg_b.y, vg_b.height);
     }
 
     static bool view_compare_y(const wayfire_toplevel_view& a, const wayfire_toplevel_view& b)
     {
         auto vg_a = a->get_geometry();
-        std::vector<int> a_coords = {vg_a.y, vg_a.height, vg_a.x, vg_a.width};
         auto vg_b = b->get_geometry();
-        std::vector<int> b_coords = {vg_b.y, vg_b.height, vg_b.x, vg_b.width};
-        return a_coords < b_coords;
+        return std::tie(vg_a.y, vg_a.height, vg_a.x, vg_a.width) <
+               std::tie(vg_b.y, vg_b.height, vg_b.x, vg_b.width);
     }
 
     std::vector<std::vector<wayfire_toplevel_view>> view_sort(
@@ -291,8 +291,13 @@ class wayfire_command : public wf::plugin_interface_t
         bindings.clear();
     }
 
-    wf::signal::connection_t<wf::reload_config_signal> on_reload_config = [=] (auto)
+    wf::signal::connection_t<wf::reload_config_signal> on_reload_config = [=] (wf::reload_config_signal *ev)
     {
+        if (!ev->section_changed("command"))
+        {
+            return;
+        }
+
         setup_bindings_from_config();
     };
 
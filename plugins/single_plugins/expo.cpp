@@ -796,6 +796,12 @@ class wayfire_expo_global : public wf::plugin_interface_t,
         this->fini_output_tracking();
     }
 
+    bool is_init_deferrable() const override
+    {
+        // Not needed until the user activates it.
+        return true;
+    }
+
     wf::ipc_activator_t::handler_t toggle_cb = [=] (wf::output_t *output, wayfire_view)
     {
         return this->output_instance[output]->handle_toggle();
@@ -4,6 +4,8 @@
 #include "wayfire/txn/transaction-manager.hpp"
 #include <wayfire/toplevel.hpp>
 #include <cmath>
+#include <chrono>
+#include <optional>
 #include <wayfire/per-output-plugin.hpp>
 #include <wayfire/output.hpp>
 #include <wayfire/view.hpp>
@@ -67,6 +69,35 @@ class wayfire_resize : public wf::per_output_plugin_instance_t, public wf::point
     wf::option_wrapper_t<wf::buttonbinding_t> button{"resize/activate"};
     wf::option_wrapper_t<wf::buttonbinding_t> button_preserve_aspect{
         "resize/activate_preserve_aspect"};
+    wf::option_wrapper_t<bool> client_paced{"resize/client_paced"};
+
+    /**
+     * With client-paced resizing, a new size is sent to the client only after it has committed the previous
+     * one. Pointer motion in the meantime only updates the queued geometry, so the client receives just the
+     * latest size instead of a configure for every motion event.
+     */
+    std::optional<wf::geometry_t> queued_geometry;
+    std::chrono::steady_clock::time_point last_configure;
+    bool waiting_for_client = false;
+    // Smoothed time between scheduling a new size and the client being ready with it.
+    double client_latency_ms = 0.0;
+    wf::wl_timer<false> pacing_timer;
+    wf::wl_idle_call idle_send_queued;
+
+    wf::signal::connection_t<wf::txn::object_ready_signal> on_toplevel_ready =
+        [=] (wf::txn::object_ready_signal*)
+    {
+        if (waiting_for_client)
+        {
+            waiting_for_client = false;
+            double latency = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - last_configure).count();
+            client_latency_ms = (client_latency_ms > 0) ? 0.8 * client_latency_ms + 0.2 * latency : latency;
+        }
+
+        // The transaction manager marks the object as done only after the ready signal has been processed.
+        idle_send_queued.run_once([=] () { send_queued_geometry(); });
+    };
     std::unique_ptr<wf::input_grab_t> input_grab;
     wf::plugin_activation_data_t grab_interface = {
         .name = "resize",
@@ -250,6 +281,10 @@ class wayfire_resize : public wf::per_output_plugin_instance_t, public wf::point
         start_wobbly(view, anchor_x, anchor_y);
         wf::get_core().set_cursor(wlr_xcursor_get_resize_name((wlr_edges)edges));
 
+        queued_geometry.reset();
+        waiting_for_client = false;
+        view->toplevel()->connect(&on_toplevel_ready);
+
         return true;
     }
 
@@ -262,9 +297,18 @@ class wayfire_resize : public wf::per_output_plugin_instance_t, public wf::point
 
         input_grab->ungrab_input();
         output->deactivate_plugin(&grab_interface);
+        on_toplevel_ready.disconnect();
+        pacing_timer.disconnect();
+        idle_send_queued.disconnect();
 
         if (view)
         {
+            // Make sure the final size is not lost, regardless of whether the client has caught up.
+            if (queued_geometry)
+            {
+                set_view_geometry(*queued_geometry);
+            }
+
             end_wobbly(view);
 
             wf::view_change_workspace_signal workspace_may_changed;
@@ -442,16 +486,67 @@ class wayfire_resize : public wf::per_output_plugin_instance_t, public wf::point
             desired.y += desired_unconstrained.height - desired.height;
         }
 
+        if (client_paced)
+        {
+            queued_geometry = desired;
+            send_queued_geometry();
+        } else
+        {
+            set_view_geometry(desired);
+        }
+    }
+
+    void set_view_geometry(wf::geometry_t desired)
+    {
+        queued_geometry.reset();
         if (wf::dimensions(view->toplevel()->pending().geometry) != wf::dimensions(desired))
         {
             view->toplevel()->pending().gravity  = calculate_gravity();
             view->toplevel()->pending().geometry = desired;
             wf::get_core().tx_manager->schedule_object(view->toplevel());
+            last_configure     = std::chrono::steady_clock::now();
+            waiting_for_client = true;
+        }
+    }
+
+    /** The minimal time between two configures, so that we do not resize faster than the output refreshes. */
+    int get_frame_interval_ms()
+    {
+        return (output->handle->refresh > 0) ? (1'000'000 / output->handle->refresh) : 16;
+    }
+
+    void send_queued_geometry()
+    {
+        if (!queued_geometry || !view)
+        {
+            return;
         }
+
+        if (wf::get_core().tx_manager->is_object_waiting(view->toplevel()))
+        {
+            // Normally we continue when the client is ready. If it is not responding, the transaction times
+            // out instead, so check again after roughly twice the time the client usually needs.
+            int poll_ms = std::min(std::max(int(2 * client_latency_ms), get_frame_interval_ms()), 250);
+            pacing_timer.set_timeout(poll_ms, [=] () { send_queued_geometry(); });
+            return;
+        }
+
+        auto since_last = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - last_configure).count();
+        if (since_last < get_frame_interval_ms())
+        {
+            pacing_timer.set_timeout(get_frame_interval_ms() - since_last, [=] () { send_queued_geometry(); });
+            return;
+        }
+
+        pacing_timer.disconnect();
+        set_view_geometry(*queued_geometry);
     }
 
     void fini() override
     {
+        pacing_timer.disconnect();
+        idle_send_queued.disconnect();
         if (input_grab->is_grabbed())
         {
             input_pressed(WLR_BUTTON_RELEASED);
@@ -27,6 +27,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <set>
 
 constexpr const char *switcher_transformer = "switcher-3d";
@@ -743,6 +744,10 @@ class WayfireSwitcher : public wf::per_output_plugin_instance_t, public wf::keyb
         transform->rotation = glm::rotate(glm::mat4(1.0),
             (float)sv.attribs.rotation, {0.0, 1.0, 0.0});
 
+        // The thumbnails are shown scaled down, no need to render them at full resolution.
+        transform->set_content_scale(std::max(std::abs((double)sv.attribs.scale_x),
+            std::abs((double)sv.attribs.scale_y)));
+
         transform->color[3] = sv.attribs.alpha;
         render_view_scene(sv.view, buffer);
     }
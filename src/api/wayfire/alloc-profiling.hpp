@@ -0,0 +1,90 @@
+#pragma once
+
+// WF_USE_CONFIG_H is set only when building Wayfire itself, external plugins
+// need to use <wayfire/config.h>
+#ifdef WF_USE_CONFIG_H
+    #include <config.h>
+#else
+    #include <wayfire/config.h>
+#endif
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace wf
+{
+/**
+ * Heap allocation profiling, available when Wayfire is built with the alloc_profiling option.
+ *
+ * In such builds, Wayfire replaces the global operator new and counts the allocations which happen on the
+ * main thread while a scope marker is alive. Core places markers around frame repaints, input events and
+ * transactions, the IPC plugin around method calls, and plugins may add their own. In regular builds the
+ * markers are empty objects and cost nothing.
+ */
+namespace alloc_profiling
+{
+/** Whether Wayfire was built with allocation profiling. */
+constexpr bool enabled = WF_ALLOC_PROFILING;
+
+struct scope_stats_t
+{
+    std::string name;
+    /** How many times the scope was entered. */
+    uint64_t count = 0;
+    /** The total number of allocations in the scope, including those in nested scopes. */
+    uint64_t allocations = 0;
+    /** The total number of allocated bytes in the scope, including those in nested scopes. */
+    uint64_t bytes = 0;
+    /** The largest number of allocations during a single pass through the scope. */
+    uint64_t max_allocations = 0;
+};
+
+#if WF_ALLOC_PROFILING
+/**
+ * Count the allocations between construction and destruction towards the scope with the given name.
+ * Markers may be nested, but should be used only on the main thread.
+ */
+class scope_t
+{
+  public:
+    scope_t(const char *name);
+    ~scope_t();
+
+    scope_t(const scope_t&) = delete;
+    scope_t(scope_t&&) = delete;
+    scope_t& operator =(const scope_t&) = delete;
+    scope_t& operator =(scope_t&&) = delete;
+
+  private:
+    const char *name;
+    uint64_t start_allocations;
+    uint64_t start_bytes;
+};
+#else
+class scope_t
+{
+  public:
+    scope_t(const char*)
+    {}
+};
+#endif
+
+/**
+ * Get the statistics of all scopes entered so far, sorted by the number of allocations. Empty if allocation
+ * profiling is disabled.
+ */
+std::vector<scope_stats_t> get_stats();
+
+/**
+ * Clear the statistics of all scopes.
+ */
+void reset();
+
+/**
+ * Get the number of allocations made by the calling thread so far, regardless of scopes. Always 0 if
+ * allocation profiling is disabled.
+ */
+uint64_t get_thread_allocations();
+}
+}
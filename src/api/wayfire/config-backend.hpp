@@ -67,4 +67,6 @@ class config_backend_t
     { \
         wf::config_backend_t*newInstance() { return new PluginClass; } \
         uint32_t getWayfireVersion() { return WAYFIRE_API_ABI_VERSION; } \
+        __attribute__((used, section(WAYFIRE_PLUGIN_ABI_SECTION))) \
+        const uint32_t wayfirePluginAbiVersion = WAYFIRE_API_ABI_VERSION; \
     }
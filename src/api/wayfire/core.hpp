@@ -169,6 +169,7 @@ class compositor_core_t : public wf::object_base_t, public signal::provider_t
         wlr_screencopy_manager_v1 *screencopy;
         wlr_ext_image_copy_capture_manager_v1 *image_copy_capture;
         wlr_ext_output_image_capture_source_manager_v1 *output_image_capture_source;
+        wlr_ext_foreign_toplevel_image_capture_source_manager_v1 *toplevel_image_capture_source;
         wlr_export_dmabuf_manager_v1 *export_dmabuf;
         wlr_server_decoration_manager *decorator_manager;
         wlr_xdg_decoration_manager_v1 *xdg_decorator;
@@ -184,6 +185,8 @@ class compositor_core_t : public wf::object_base_t, public signal::provider_t
         wlr_input_method_manager_v2 *input_method = NULL;
         wlr_text_input_manager_v3 *text_input     = NULL;
         wlr_presentation *presentation;
+        wlr_tearing_control_manager_v1 *tearing_control;
+        wlr_content_type_manager_v1 *content_type;
         wlr_primary_selection_v1_device_manager *primary_selection_v1;
         wlr_viewporter *viewporter;
         wlr_drm_lease_v1_manager *drm_v1;
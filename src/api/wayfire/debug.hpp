@@ -69,6 +69,10 @@ enum class logging_category : size_t
     INPUT_DEVICES = 12,
     // Output-device-related events
     OUTPUT        = 13,
+    // Startup phase timing
+    STARTUP       = 14,
+    // Allocation profiling summaries
+    ALLOC         = 15,
     TOTAL,
 };
 
@@ -165,6 +165,12 @@ extern "C"
 #if  __has_include(<cursor-shape-v1-protocol.h>)
     #include <wlr/types/wlr_cursor_shape_v1.h>
 #endif
+#if  __has_include(<tearing-control-v1-protocol.h>)
+    #include <wlr/types/wlr_tearing_control_v1.h>
+#endif
+#if  __has_include(<content-type-v1-protocol.h>)
+    #include <wlr/types/wlr_content_type_v1.h>
+#endif
 
 // Activation plugin
 #include <wlr/types/wlr_xdg_activation_v1.h>
@@ -30,6 +30,7 @@ extern "C"
     struct wlr_screencopy_manager_v1;
     struct wlr_ext_image_copy_capture_manager_v1;
     struct wlr_ext_output_image_capture_source_manager_v1;
+    struct wlr_ext_foreign_toplevel_image_capture_source_manager_v1;
     struct wlr_foreign_toplevel_manager_v1;
     struct wlr_pointer_gestures_v1;
     struct wlr_relative_pointer_manager_v1;
@@ -38,6 +39,8 @@ extern "C"
     struct wlr_input_method_manager_v2;
     struct wlr_text_input_manager_v3;
     struct wlr_presentation;
+    struct wlr_tearing_control_manager_v1;
+    struct wlr_content_type_manager_v1;
     struct wlr_primary_selection_v1_device_manager;
     struct wlr_drm_lease_v1_manager;
     struct wlr_session_lock_manager_v1;
@@ -91,6 +91,19 @@ class plugin_interface_t
         return 0;
     }
 
+    /**
+     * A plugin can indicate that it is not needed to show the first frame of the session, for example
+     * because it only provides effects or overviews which are activated later.
+     *
+     * When Wayfire starts, such plugins are loaded together with all other plugins, but their init() is
+     * postponed until the first frame has been shown on an output. Plugins loaded later (e.g. after
+     * changing the plugin list) are initialized immediately.
+     */
+    virtual bool is_init_deferrable() const
+    {
+        return false;
+    }
+
     virtual ~plugin_interface_t() = default;
 };
 }
@@ -107,7 +120,7 @@ using wayfire_plugin_load_func = wf::plugin_interface_t * (*)();
 /**
  * The version is defined as macro as well, to allow conditional compilation.
  */
-#define WAYFIRE_API_ABI_VERSION_MACRO 2026'06'11
+#define WAYFIRE_API_ABI_VERSION_MACRO 2026'10'19
 
 /**
  * The version of Wayfire's API/ABI
@@ -123,6 +136,12 @@ constexpr uint32_t WAYFIRE_API_ABI_VERSION = WAYFIRE_API_ABI_VERSION_MACRO;
  */
 using wayfire_plugin_version_func = uint32_t (*)();
 
+/**
+ * The name of the ELF section in which plugins store the API/ABI version they were compiled with.
+ * This allows Wayfire to check the version of a plugin before dlopen()-ing it.
+ */
+#define WAYFIRE_PLUGIN_ABI_SECTION ".wayfire_abi"
+
 /**
  * A macro to declare the necessary functions, given the plugin class name
  */
@@ -131,6 +150,8 @@ using wayfire_plugin_version_func = uint32_t (*)();
     { \
         wf::plugin_interface_t*newInstance() { return new PluginClass; } \
         uint32_t getWayfireVersion() { return WAYFIRE_API_ABI_VERSION; } \
+        __attribute__((used, section(WAYFIRE_PLUGIN_ABI_SECTION))) \
+        const uint32_t wayfirePluginAbiVersion = WAYFIRE_API_ABI_VERSION; \
     }
 
 #endif
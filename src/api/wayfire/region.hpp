@@ -69,6 +69,17 @@ struct region_t
      * won't let us pass a const pixman_region32_t* */
     pixman_region32_t *unconst() const;
 };
+
+/**
+ * Cover a fragmented region with fewer, larger rectangles.
+ *
+ * If @region consists of more than @max_rects rectangles, rectangles are merged as long as the area of the
+ * merged rectangle which is not part of @region stays below @max_waste (a fraction of the merged rectangle's
+ * area). If more than @max_rects rectangles remain after that, the extents of @region are returned instead.
+ *
+ * The result always contains @region. A non-positive @max_rects disables simplification.
+ */
+wf::region_t simplify_region(const wf::region_t& region, int max_rects, double max_waste);
 }
 
 wlr_box wlr_box_from_pixman_box(const pixman_box32_t& box);
@@ -58,6 +58,50 @@ using post_hook_t = std::function<void (wf::auxilliary_buffer_t& source,
 struct frame_done_signal
 {};
 
+/**
+ * on: output
+ * when: A part of the output was damaged by the scenegraph or by a plugin. Damage caused by the backend (for
+ *   example when the contents of the output's buffers are lost) is not reported.
+ */
+struct output_damage_signal
+{
+    /** The damaged region, in output-local coordinates. */
+    const wf::region_t *region;
+};
+
+/**
+ * on: output
+ * when: Before a surface is directly scanned out on the output, to decide whether it may be presented with
+ *   a tearing page-flip, i.e. immediately instead of at the next vblank.
+ *
+ * The initial decision is based on the output's allow_tearing option and the surface's tearing-control
+ * hint. Plugins may change @allow_tearing to implement a different policy.
+ */
+struct output_tearing_request_signal
+{
+    wf::output_t *output;
+    wlr_surface *surface;
+    bool allow_tearing;
+};
+
+/**
+ * Statistics about the damage repainted on an output, see render_manager::get_damage_stats().
+ *
+ * Fragmented damage is simplified before repainting according to the core/damage_max_rects and
+ * core/damage_max_waste options.
+ */
+struct damage_stats_t
+{
+    /** The number of repainted frames. */
+    uint64_t frames = 0;
+    /** The number of frames whose damage was simplified. */
+    uint64_t simplified_frames = 0;
+    /** The total number of damage rectangles of all frames, before simplification. */
+    uint64_t rects_before = 0;
+    /** The total number of damage rectangles of all frames, after simplification. */
+    uint64_t rects_after = 0;
+};
+
 /** Render manager
  *
  * Each output has a render manager, which is responsible for all rendering
@@ -90,6 +134,12 @@ class render_manager
      */
     void schedule_redraw();
 
+    /**
+     * Render at most one frame every @interval_ms milliseconds, so that the refresh rate of adaptive sync
+     * outputs drops while their content changes only rarely. 0 removes the limit.
+     */
+    void set_min_frame_interval(int interval_ms);
+
     /**
      * Inhibit rendering to the output. An inhibited output will show a
      * fully black image. Used mainly for compositor fade in/out on startup.
@@ -142,6 +192,16 @@ class render_manager
      */
     wf::region_t get_scheduled_damage();
 
+    /**
+     * @return Statistics about the damage repainted on the output so far.
+     */
+    damage_stats_t get_damage_stats();
+
+    /**
+     * Clear the damage statistics of the output.
+     */
+    void reset_damage_stats();
+
     /**
      * @return The current wlr_color_transform from the icc_profile option, or NULL if none is set.
      */
@@ -188,6 +248,12 @@ class render_manager
      */
     wf::render_target_t get_target_framebuffer() const;
 
+    /**
+     * Decide whether the given surface, which is about to be directly scanned out, may be presented with a
+     * tearing page-flip. See @output_tearing_request_signal.
+     */
+    bool should_tear(wlr_surface *surface);
+
     /**
      * Inform Wayfire whether a depth buffer is required for rendering on the default framebuffer for each
      * output.
@@ -182,6 +182,11 @@ class texture_t : public wf::signal::provider_t
      */
     wlr_texture *get_wlr_texture() const;
 
+    /**
+     * Get the buffer the texture was created from, or nullptr if the texture was not created from a buffer.
+     */
+    wlr_buffer *get_buffer() const;
+
   private:
     texture_t();
 
@@ -542,6 +547,7 @@ struct render_pass_params_t
 };
 
 class vulkan_render_state_t;
+class pixman_tiled_pass_t;
 
 /**
  * A render pass is used to generate and execute a set of drawing commands to the same render target.
@@ -733,6 +739,13 @@ class render_pass_t
 
     bool needs_restart = false;
     wlr_render_pass *_get_pass();
+
+    /**
+     * With the pixman renderer, texture and rectangle operations are recorded and executed in parallel
+     * when the wlroots pass is needed or the pass is submitted, see core/software_render_threads.
+     */
+    std::unique_ptr<pixman_tiled_pass_t> tiled_pass;
+    void flush_tiled_pass();
 };
 
 /**
@@ -105,6 +105,8 @@ struct render_instance_manager_t
 
     void regen_instances();
     void update_visibility();
+    // Whether an update starting at @source cannot affect the instances for the reference output.
+    bool is_hidden_update(node_t *source);
 };
 }
 }
@@ -497,6 +497,8 @@ struct node_update_signal
 {
     scene::node_t *node;
     uint32_t flags;
+    // The node where the update sequence started, either @node or one of its descendants.
+    scene::node_t *source;
 };
 
 /**
@@ -3,6 +3,11 @@
 
 #include "wayfire/view.hpp"
 #include "wayfire/output.hpp"
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
 
 /**
  * Documentation of signals emitted from core components.
@@ -43,6 +48,17 @@ struct core_startup_finished_signal
 struct core_shutdown_signal
 {};
 
+/**
+ * on: core
+ * when: A process started with compositor_core_t::run() has exited.
+ */
+struct command_exited_signal
+{
+    pid_t pid;
+    // The status as returned by waitpid(), see WIFEXITED() and related macros.
+    int status;
+};
+
 class input_device_t;
 /**
  * on: core
@@ -189,10 +205,51 @@ struct touch_focus_changed_signal
 
 /**
  * on: core
- * when: When the config file is reloaded
+ * when: When the config file is reloaded, or options are changed in bulk (for example over IPC). Not emitted
+ *   if the reload did not change any option.
  */
 struct reload_config_signal
-{};
+{
+    /**
+     * The options which were changed, added or removed, in the form "section/option". If not set, the
+     * changes are not known and listeners should assume that any option might have changed.
+     */
+    std::optional<std::set<std::string>> changed_options;
+
+    /**
+     * Check whether the given option (in the form "section/option") might have changed.
+     */
+    bool option_changed(const std::string& name) const
+    {
+        return !changed_options || changed_options->count(name);
+    }
+
+    /**
+     * Check whether any option in the given section, or in a section named "section:<something>" (for
+     * example output:DP-1 for the output section) might have changed.
+     */
+    bool section_changed(const std::string& section) const
+    {
+        if (!changed_options)
+        {
+            return true;
+        }
+
+        for (auto& name : *changed_options)
+        {
+            const auto changed_section = std::string_view{name}.substr(0, name.rfind('/'));
+            if ((changed_section == section) ||
+                ((changed_section.size() > section.size()) &&
+                 (changed_section.substr(0, section.size()) == section) &&
+                 (changed_section[section.size()] == ':')))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
 
 /**
  * on: core
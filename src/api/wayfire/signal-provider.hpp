@@ -140,6 +140,16 @@ class provider_t
     /** Unregister a connection. */
     void disconnect(connection_base_t *callback);
 
+    /**
+     * Check whether any connection is registered for the given signal. Useful to skip preparing signal
+     * data which is expensive to compute and which nobody listens for.
+     */
+    template<class SignalType>
+    bool has_connections()
+    {
+        return has_connections_base(index<SignalType>());
+    }
+
     /** Emit the given signal. */
     template<class SignalType>
     void emit(SignalType *data)
@@ -172,6 +182,7 @@ class provider_t
 
     void connect_base(std::type_index type, connection_base_t *callback);
     void for_each_connection(std::type_index type, std::function<void(connection_base_t*)> func);
+    bool has_connections_base(std::type_index type);
     void disconnect_other_side(connection_base_t *callback);
 
     struct impl;
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace wf
+{
+namespace startup
+{
+/**
+ * A single measured phase of the compositor startup, for example loading the configuration backend or
+ * initializing a plugin. All times are relative to the start of main().
+ */
+struct phase_t
+{
+    std::string name;
+    /**
+     * Phases which begin while another phase is still running are nested inside it. The outermost phases
+     * have depth 0.
+     */
+    int depth = 0;
+    std::chrono::microseconds start{0};
+    std::chrono::microseconds duration{0};
+    /** Whether the phase has ended. Phases which are still running have duration 0. */
+    bool finished = false;
+};
+
+/**
+ * Begin a new phase. The phase is nested inside the currently running phase, if any.
+ */
+void begin_phase(std::string name);
+
+/**
+ * End the innermost running phase.
+ */
+void end_phase();
+
+/**
+ * Begin a phase which ends asynchronously, for example the startup of XWayland which finishes only after
+ * the server has connected back. The phase is nested inside the currently running phase, if any, but the
+ * phases which begin after it are not nested inside it.
+ */
+void begin_async_phase(std::string name);
+
+/**
+ * End the running asynchronous phase with the given name.
+ */
+void end_async_phase(const std::string& name);
+
+/**
+ * Record a point in time without a duration, for example when XWayland becomes ready.
+ */
+void mark(std::string name);
+
+/**
+ * Begin a phase when constructed and end it when destroyed.
+ */
+class scoped_phase_t
+{
+  public:
+    scoped_phase_t(std::string name);
+    ~scoped_phase_t();
+
+    scoped_phase_t(const scoped_phase_t&) = delete;
+    scoped_phase_t(scoped_phase_t&&) = delete;
+    scoped_phase_t& operator =(const scoped_phase_t&) = delete;
+    scoped_phase_t& operator =(scoped_phase_t&&) = delete;
+};
+
+/**
+ * Get all phases recorded so far, in the order they began.
+ */
+const std::vector<phase_t>& get_phases();
+
+/**
+ * Get the time from the start of main() until the first frame was shown on any output, or std::nullopt if
+ * that has not happened yet.
+ */
+std::optional<std::chrono::microseconds> get_time_to_first_frame();
+}
+}
@@ -50,6 +50,14 @@ class transaction_manager_t : public signal::provider_t
      */
     bool is_object_committed(transaction_object_sptr object) const;
 
+    /**
+     * Check whether the object is still waiting for an earlier transaction, that is, whether it is part of a
+     * pending or a committed transaction. Changes to the pending state of such an object will be sent to the
+     * client only after the earlier transactions are done, so callers which produce a stream of updates
+     * (e.g. interactive resize) can use this to avoid queueing up more changes than the client can handle.
+     */
+    bool is_object_waiting(transaction_object_sptr object) const;
+
     struct impl;
     std::unique_ptr<impl> priv;
 };
@@ -43,6 +43,15 @@ struct surface_state_t
     surface_state_t& operator =(surface_state_t&& other);
 };
 
+/**
+ * on: wlr_surface_node_t
+ * when: The node starts or stops throttling its surface, see wlr_surface_node_t::is_throttled().
+ */
+struct surface_throttled_signal
+{
+    bool throttled;
+};
+
 /**
  * An implementation of node_t for wlr_surfaces.
  *
@@ -75,6 +84,14 @@ class wlr_surface_node_t : public node_t, public zero_copy_texturable_node_t
     void apply_current_surface_state();
     void send_frame_done(bool delay_until_vblank);
 
+    /**
+     * Whether the surface is throttled because none of its render instances found it visible, for example
+     * because it is on another workspace or fully occluded. Commits of throttled surfaces do not trigger
+     * repaints, their damage is applied once they become visible again, and frame callbacks are sent at the
+     * rate configured in core/hidden_surface_frame_rate.
+     */
+    bool is_throttled() const;
+
   private:
     std::unique_ptr<pointer_interaction_t> ptr_interaction;
     std::unique_ptr<touch_interaction_t> tch_interaction;
@@ -96,6 +113,27 @@ class wlr_surface_node_t : public node_t, public zero_copy_texturable_node_t
 
     const bool autocommit;
 
+    // The number of render instances which have not computed their visibility yet, found the surface
+    // visible, or found it hidden.
+    enum class instance_visibility_t
+    {
+        NONE,
+        UNKNOWN,
+        VISIBLE,
+        HIDDEN,
+    };
+    int unknown_instances = 0;
+    int visible_instances = 0;
+    int hidden_instances  = 0;
+    void update_instance_visibility(instance_visibility_t old_state, instance_visibility_t new_state);
+
+    bool throttled = false;
+    bool damage_on_unthrottle = false;
+    wf::wl_timer<false> throttle_update_timer;
+    wf::wl_timer<false> throttled_frame_timer;
+    void set_throttled(bool throttled);
+    void handle_throttled_commit();
+
   protected:
     surface_state_t current_state;
 };
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+#include <wayfire/geometry.hpp>
+#include <wayfire/render.hpp>
+#include <wayfire/scene-render.hpp>
+#include <wayfire/view.hpp>
+
+namespace wf
+{
+/**
+ * A snapshot of the contents of a view, used for example to keep showing a view after it was unmapped, or to
+ * show the old contents of a view while it changes its size.
+ *
+ * Views which consist only of client surfaces (the main surface, subsurfaces and popups) are captured without
+ * rendering anything: the snapshot keeps a reference to the current buffer of each surface, together with its
+ * position in the view. Views with other nodes in their surface tree (for example server-side decorations)
+ * are rendered into an auxilliary buffer instead, like view_interface_t::take_snapshot() does.
+ */
+class view_snapshot_t
+{
+  public:
+    /**
+     * Capture the current contents of the view's surface root node.
+     *
+     * @param region The part of the view to capture, in the coordinate system of the surface root node's
+     *   bounding box. Defaults to the whole bounding box.
+     */
+    void capture(wayfire_view view, std::optional<wf::geometry_t> region = {});
+
+    /**
+     * Release the captured contents.
+     */
+    void reset();
+
+    /**
+     * Get the region which was captured, see capture().
+     */
+    wf::geometry_t get_region() const;
+
+    /**
+     * Whether the snapshot references the client buffers directly, as opposed to a rendered copy.
+     */
+    bool is_zero_copy() const;
+
+    /**
+     * Render the snapshot, scaled so that the captured region fills @geometry.
+     *
+     * Note that for zero-copy snapshots, @alpha is applied to each surface separately, so overlapping
+     * translucent subsurfaces blend with the main surface underneath them.
+     */
+    void render(const wf::scene::render_instruction_t& data, wf::geometry_t geometry, float alpha = 1.0);
+
+  private:
+    struct surface_t
+    {
+        std::shared_ptr<wf::texture_t> texture;
+        // In the coordinate system of the surface root node's bounding box.
+        wf::geometry_t geometry;
+    };
+
+    // The captured surfaces for zero-copy snapshots, ordered from top to bottom.
+    std::vector<surface_t> surfaces;
+    // The rendered contents otherwise.
+    wf::auxilliary_buffer_t buffer;
+
+    wf::geometry_t region = {0, 0, 0, 0};
+    bool zero_copy = false;
+
+    bool collect_surfaces(wf::scene::node_t *node, wf::scene::node_t *root);
+    void render_to_buffer(wayfire_view view);
+};
+}
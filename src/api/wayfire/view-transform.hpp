@@ -70,8 +70,23 @@ class transformer_base_node_t : public scene::floating_inner_node_t
     std::shared_ptr<wf::texture_t> get_updated_contents(const wf::geometry_t& bbox, float scale,
         std::vector<scene::render_instance_uptr>& children, wf::output_t *output = nullptr);
 
+    /**
+     * Set how large the children are shown on screen relative to their actual size, for example when the
+     * view is displayed as a thumbnail. @inner_content is then rendered at the smallest of a few reduced
+     * resolutions (1, 1/2, 1/4 or 1/8 of the full one) which is still at least as large as the displayed
+     * size, instead of at full resolution. The zero-copy path is not affected.
+     */
+    void set_content_scale(float scale);
+
+    /** Get the resolution of @inner_content relative to the children's actual size. */
+    float get_content_scale() const;
+
     void release_buffers();
     ~transformer_base_node_t();
+
+  private:
+    // The resolution of @inner_content relative to the children's actual size.
+    float content_scale = 1.0;
 };
 
 /**
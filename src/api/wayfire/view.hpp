@@ -179,6 +179,7 @@ class view_interface_t : public wf::signal::provider_t, public wf::object_base_t
 
     /**
      * A snapshot of the view is a copy of the view's contents into a framebuffer.
+     * See also wf::view_snapshot_t, which avoids the copy when possible.
      */
     virtual void take_snapshot(wf::auxilliary_buffer_t& buffer);
 
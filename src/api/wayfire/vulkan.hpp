@@ -9,6 +9,8 @@
 #if WF_HAS_VULKANFX
     #include <memory>
     #include <map>
+    #include <set>
+    #include <functional>
     #include <string>
     #include <string_view>
     #include <variant>
@@ -26,6 +28,7 @@ namespace vk
 {
 class context_t;
 class gpu_buffer_t;
+class pipeline_compile_job_t;
 class graphics_pipeline_t;
 class image_descriptor_set_pool_t;
 /**
@@ -361,12 +364,45 @@ class context_t : public std::enable_shared_from_this<context_t>
         return renderer;
     }
 
+    /**
+     * Get the pipeline cache used for all pipelines created from this context.
+     *
+     * The cache is loaded from $XDG_CACHE_HOME/wayfire/vulkan-pipeline-cache when the context is created
+     * and written back whenever new pipelines are compiled, so that pipelines compiled in earlier sessions
+     * are cheap to create. Setting WAYFIRE_DISABLE_VK_PIPELINE_CACHE=1 disables loading and saving.
+     */
+    VkPipelineCache get_pipeline_cache() const
+    {
+        return pipeline_cache;
+    }
+
+    /**
+     * Run the given job on the background thread of the context.
+     * Jobs are executed in the order they were submitted, and all pending jobs are finished before the
+     * context is destroyed. Jobs must not access any compositor state which is not thread-safe.
+     */
+    void run_in_background(std::function<void()> job);
+
+    /**
+     * Request that the pipeline cache is written to disk.
+     * The actual write happens on the background thread, multiple requests are coalesced.
+     */
+    void schedule_pipeline_cache_save();
+
   private:
     // Vulkan core objects
     wlr_renderer *renderer = nullptr;
     VkDevice device;
     VkPhysicalDevice physical_device;
     VkQueue queue;
+
+    VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
+    std::string pipeline_cache_path;
+    void load_pipeline_cache();
+    void save_pipeline_cache();
+
+    struct background_worker_t;
+    std::unique_ptr<background_worker_t> worker;
 };
 
 struct pipeline_shader_t
@@ -440,6 +476,31 @@ class graphics_pipeline_t
     std::pair<VkPipelineLayout, VkPipeline> pipeline_for(const command_buffer_t& pass,
         const pipeline_specialization_t& specialization = pipeline_specialization_t{});
 
+    /**
+     * Declare a specialization which is likely to be used with this pipeline in the future, for example
+     * one created with add_specialization_for_texture() for a texture format/transform which is not on
+     * screen yet.
+     *
+     * Declared specializations are compiled on the background thread of the context for every render pass
+     * the pipeline has been used with so far, and for every render pass it is used with later (see
+     * warm_up()), so that the first pipeline_for() call with them does not have to compile the pipeline in
+     * the middle of a frame.
+     *
+     * Specializations without textures are queued immediately. The descriptor set layouts of specialized
+     * textures can only be queried with a command buffer, so specializations with textures are queued on
+     * the next pipeline_for() call (for any specialization), and their textures are kept alive until then.
+     * Only the last few such declarations are kept.
+     */
+    void declare_specialization(const pipeline_specialization_t& specialization);
+
+    /**
+     * Start compiling (in the background) pipelines for the render pass of the given command buffer, for all
+     * declared specializations and all specializations which have already been used with other render
+     * passes. This is done automatically the first time the pipeline is used with a new render pass, but
+     * may also be called explicitly, e.g. right after declaring new specializations.
+     */
+    void warm_up(const command_buffer_t& cmd_buf);
+
   private:
     std::shared_ptr<context_t> context;
     pipeline_params_t params;
@@ -449,6 +510,43 @@ class graphics_pipeline_t
     using pipeline_key_t = std::tuple<VkRenderPass, std::vector<std::byte>,
         std::vector<VkDescriptorSetLayout>>;
     std::map<pipeline_key_t, std::pair<VkPipelineLayout, VkPipeline>> pipelines;
+
+    // Pipelines which are being compiled in the background. The layout is created on the main thread.
+    struct pending_pipeline_t
+    {
+        VkPipelineLayout layout;
+        std::shared_ptr<pipeline_compile_job_t> job;
+    };
+
+    std::map<pipeline_key_t, pending_pipeline_t> pending_pipelines;
+
+    // Specializations which have been used or declared so far, independently of the render pass, keyed by
+    // (specialization data bytes, specialization texture ds).
+    using specialization_key_t = std::pair<std::vector<std::byte>, std::vector<VkDescriptorSetLayout>>;
+    std::map<specialization_key_t, std::vector<VkSpecializationMapEntry>> known_specializations;
+
+    // Declared specializations whose texture descriptor set layouts are not known yet.
+    struct declared_specialization_t
+    {
+        std::vector<VkSpecializationMapEntry> entries;
+        std::vector<std::byte> data;
+        std::vector<std::shared_ptr<wf::texture_t>> textures;
+    };
+
+    std::vector<declared_specialization_t> unresolved_declarations;
+    std::set<VkRenderPass> seen_passes;
+
+    std::vector<VkDescriptorSetLayout> get_texture_layouts(const command_buffer_t& cmd_buf,
+        const std::vector<std::shared_ptr<wf::texture_t>>& textures);
+    VkPipelineLayout create_layout(const std::vector<VkDescriptorSetLayout>& texture_layouts);
+    VkPipeline create_pipeline(VkPipelineLayout layout, VkRenderPass render_pass,
+        const std::vector<VkSpecializationMapEntry>& entries, const std::vector<std::byte>& data) const;
+    void compile_in_background(const pipeline_key_t& key,
+        const std::vector<VkSpecializationMapEntry>& entries);
+    std::pair<VkPipelineLayout, VkPipeline> compile_now(const command_buffer_t& cmd_buf,
+        const pipeline_specialization_t& specialization, const pipeline_key_t& key);
+    void add_known_specialization(const specialization_key_t& key,
+        const std::vector<VkSpecializationMapEntry>& entries);
 };
 
 /**
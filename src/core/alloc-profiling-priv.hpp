@@ -0,0 +1,20 @@
+#pragma once
+
+#include <wayfire/alloc-profiling.hpp>
+
+namespace wf
+{
+namespace alloc_profiling
+{
+/**
+ * Start logging a summary of the allocation statistics periodically (with the alloc debugging category).
+ * Called by core at the end of post_init().
+ */
+void start_periodic_summary();
+
+/**
+ * Stop the periodic summary and log the final statistics. Called by core on shutdown.
+ */
+void log_final_summary();
+}
+}
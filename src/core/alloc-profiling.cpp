@@ -0,0 +1,169 @@
+#include <wayfire/alloc-profiling.hpp>
+#include <wayfire/debug.hpp>
+#include <wayfire/util.hpp>
+#include <wayfire/util/log.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+
+#include "alloc-profiling-priv.hpp"
+
+#if WF_ALLOC_PROFILING
+namespace
+{
+// Plain thread-local integers, so that operator new does not need any initialization or locking.
+thread_local uint64_t thread_allocations = 0;
+thread_local uint64_t thread_bytes = 0;
+// Set while the profiler itself allocates, so that its bookkeeping is not attributed to the scopes.
+thread_local bool paused = false;
+
+std::map<std::string, wf::alloc_profiling::scope_stats_t, std::less<>>& get_scopes()
+{
+    static std::map<std::string, wf::alloc_profiling::scope_stats_t, std::less<>> scopes;
+    return scopes;
+}
+
+std::unique_ptr<wf::wl_timer<true>> summary_timer;
+}
+
+void*operator new(std::size_t size)
+{
+    if (!paused)
+    {
+        ++thread_allocations;
+        thread_bytes += size;
+    }
+
+    if (void *ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+wf::alloc_profiling::scope_t::scope_t(const char *name)
+{
+    this->name = name;
+    this->start_allocations = thread_allocations;
+    this->start_bytes = thread_bytes;
+}
+
+wf::alloc_profiling::scope_t::~scope_t()
+{
+    const uint64_t allocations = thread_allocations - start_allocations;
+    const uint64_t bytes = thread_bytes - start_bytes;
+
+    paused = true;
+    auto& scopes = get_scopes();
+    auto it = scopes.find(std::string_view{name});
+    if (it == scopes.end())
+    {
+        it = scopes.emplace(name, scope_stats_t{}).first;
+        it->second.name = name;
+    }
+
+    auto& stats = it->second;
+    ++stats.count;
+    stats.allocations    += allocations;
+    stats.bytes += bytes;
+    stats.max_allocations = std::max(stats.max_allocations, allocations);
+    paused = false;
+}
+
+std::vector<wf::alloc_profiling::scope_stats_t> wf::alloc_profiling::get_stats()
+{
+    std::vector<scope_stats_t> result;
+    for (auto& [_, stats] : get_scopes())
+    {
+        result.push_back(stats);
+    }
+
+    std::sort(result.begin(), result.end(), [] (const auto& a, const auto& b)
+    {
+        return a.allocations > b.allocations;
+    });
+    return result;
+}
+
+void wf::alloc_profiling::reset()
+{
+    get_scopes().clear();
+}
+
+uint64_t wf::alloc_profiling::get_thread_allocations()
+{
+    return thread_allocations;
+}
+
+static void log_summary(bool final)
+{
+    for (auto& stats : wf::alloc_profiling::get_stats())
+    {
+        const double count = std::max<uint64_t>(stats.count, 1);
+        if (final)
+        {
+            LOGI("Allocations in ", stats.name, ": ", stats.count, " passes, ",
+                stats.allocations / count, " allocations (", stats.bytes / count, " bytes) per pass, max ",
+                stats.max_allocations);
+        } else
+        {
+            LOGC(ALLOC, stats.name, ": ", stats.count, " passes, ",
+                stats.allocations / count, " allocations (", stats.bytes / count, " bytes) per pass, max ",
+                stats.max_allocations);
+        }
+    }
+}
+
+void wf::alloc_profiling::start_periodic_summary()
+{
+    static constexpr uint32_t SUMMARY_INTERVAL_MS = 10'000;
+    summary_timer = std::make_unique<wf::wl_timer<true>>();
+    summary_timer->set_timeout(SUMMARY_INTERVAL_MS, [] ()
+    {
+        log_summary(false);
+        return true;
+    });
+}
+
+void wf::alloc_profiling::log_final_summary()
+{
+    summary_timer.reset();
+    log_summary(true);
+}
+
+#else
+
+std::vector<wf::alloc_profiling::scope_stats_t> wf::alloc_profiling::get_stats()
+{
+    return {};
+}
+
+void wf::alloc_profiling::reset()
+{}
+
+uint64_t wf::alloc_profiling::get_thread_allocations()
+{
+    return 0;
+}
+
+void wf::alloc_profiling::start_periodic_summary()
+{}
+
+void wf::alloc_profiling::log_final_summary()
+{}
+
+#endif
@@ -10,6 +10,9 @@
 #include <wayfire/nonstd/wlroots-full.hpp>
 #include <wayfire/vulkan.hpp>
 #include "src/core/xdg-output-management.hpp"
+#include "src/core/toplevel-capture.hpp"
+#include "src/core/frame-pacing.hpp"
+#include "src/core/spawn.hpp"
 
 namespace wf
 {
@@ -31,6 +34,9 @@ class compositor_core_impl_t : public compositor_core_t
     std::unique_ptr<input_method_relay> im_relay;
     std::unique_ptr<plugin_manager_t> plugin_mgr;
     std::unique_ptr<wf::xdg_output_manager_v1> xdg_output_manager;
+    std::unique_ptr<wf::toplevel_capture_manager_t> toplevel_capture;
+    std::unique_ptr<wf::frame_pacing_manager_t> frame_pacing;
+    std::unique_ptr<wf::process_spawner_t> spawner;
 
     /**
      * Initialize the compositor core.
@@ -102,7 +108,6 @@ class compositor_core_impl_t : public compositor_core_t
     compositor_state_t state = compositor_state_t::UNKNOWN;
     struct rlimit user_maxfiles;
     void increase_nofile_limit();
-    void restore_nofile_limit();
 
   private:
     wf::option_wrapper_t<bool> discard_command_output;
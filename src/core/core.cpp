@@ -19,9 +19,7 @@
 #include "seat/tablet.hpp"
 #include "wayfire/touch/touch.hpp"
 #include "wayfire/view.hpp"
-#include <sys/wait.h>
 #include <unistd.h>
-#include <fcntl.h>
 #include <float.h>
 
 #include <wayfire/img.hpp>
@@ -45,6 +43,8 @@
 #include <wayfire/window-manager.hpp>
 
 #include "core-impl.hpp"
+#include "startup-timing-priv.hpp"
+#include "alloc-profiling-priv.hpp"
 
 struct wf_pointer_constraint
 {
@@ -147,6 +147,10 @@ void wf::compositor_core_impl_t::init()
     protocols.screencopy = wlr_screencopy_manager_v1_create(display);
     protocols.image_copy_capture = wlr_ext_image_copy_capture_manager_v1_create(display, 1);
     protocols.output_image_capture_source = wlr_ext_output_image_capture_source_manager_v1_create(display, 1);
+    protocols.toplevel_image_capture_source =
+        wlr_ext_foreign_toplevel_image_capture_source_manager_v1_create(display, 1);
+    toplevel_capture = std::make_unique<wf::toplevel_capture_manager_t>(
+        protocols.toplevel_image_capture_source);
     protocols.gamma_v1 = wlr_gamma_control_manager_v1_create(display);
     protocols.export_dmabuf = wlr_export_dmabuf_manager_v1_create(display);
     xdg_output_manager = std::make_unique<wf::xdg_output_manager_v1>(display,
@@ -231,8 +235,12 @@ void wf::compositor_core_impl_t::init()
 
     // TODO: is v2 the correct version here?
     // https://gitlab.freedesktop.org/wlroots/wlroots/-/merge_requests/4858
-    protocols.presentation = wlr_presentation_create(display, backend, 2);
-    protocols.viewporter   = wlr_viewporter_create(display);
+    protocols.presentation    = wlr_presentation_create(display, backend, 2);
+    protocols.tearing_control = wlr_tearing_control_manager_v1_create(display, 1);
+    protocols.content_type    = wlr_content_type_manager_v1_create(display, 1);
+    protocols.viewporter      = wlr_viewporter_create(display);
+    frame_pacing = std::make_unique<wf::frame_pacing_manager_t>(display);
+    spawner = std::make_unique<wf::process_spawner_t>(ev_loop);
 
     protocols.foreign_registry = wlr_xdg_foreign_registry_create(display);
     protocols.foreign_v1 = wlr_xdg_foreign_v1_create(display,
@@ -321,14 +329,6 @@ void wf::compositor_core_impl_t::increase_nofile_limit()
     }
 }
 
-void wf::compositor_core_impl_t::restore_nofile_limit()
-{
-    if (setrlimit(RLIMIT_NOFILE, &user_maxfiles) != 0)
-    {
-        LOGE("Failed to setrlimit(RLIMIT_NOFILE), could not restore maximum open file descriptors.");
-    }
-}
-
 void wf::compositor_core_impl_t::post_init()
 {
     discard_command_output.load_option("workarounds/discard_command_output");
@@ -336,7 +336,9 @@ void wf::compositor_core_impl_t::post_init()
     core_backend_started_signal backend_started_ev;
     this->emit(&backend_started_ev);
     this->state = compositor_state_t::START_PLUGINS;
-    plugin_mgr  = std::make_unique<wf::plugin_manager_t>();
+    wf::startup::begin_phase("plugins");
+    plugin_mgr = std::make_unique<wf::plugin_manager_t>();
+    wf::startup::end_phase();
     this->bindings->reparse_extensions();
 
     this->state = compositor_state_t::RUNNING;
@@ -353,6 +355,8 @@ void wf::compositor_core_impl_t::post_init()
     seat->priv->cursor->setup_listeners();
     core_startup_finished_signal startup_ev;
     this->emit(&startup_ev);
+    wf::startup::report_on_first_frame();
+    wf::alloc_profiling::start_periodic_summary();
 }
 
 void wf::compositor_core_impl_t::shutdown()
@@ -390,6 +394,7 @@ void wf::compositor_core_impl_t::fini()
     this->state = compositor_state_t::SHUTDOWN;
     core_shutdown_signal ev;
     this->emit(&ev);
+    wf::alloc_profiling::log_final_summary();
 
     LOGI("Unloading plugins...");
     plugin_mgr.reset();
@@ -401,6 +406,9 @@ void wf::compositor_core_impl_t::fini()
     LOGI("Stopping clients...");
     wl_display_destroy_clients(static_core->display);
     LOGI("Freeing resources...");
+    toplevel_capture.reset();
+    frame_pacing.reset();
+    spawner.reset();
     layout_detail::priv_output_layout_fini(output_layout.get());
     default_wm.reset();
     bindings.reset();
@@ -564,88 +572,24 @@ std::vector<wayfire_view> wf::compositor_core_t::get_all_views()
  */
 pid_t wf::compositor_core_impl_t::run(std::string command)
 {
-    static constexpr size_t READ_END  = 0;
-    static constexpr size_t WRITE_END = 1;
+    wf::process_spawner_t::spawn_params_t params;
+    params.command = command;
+    params.discard_output = discard_command_output;
+    params.nofile_limit   = &user_maxfiles;
+    params.env = {
+        {"_JAVA_AWT_WM_NONREPARENTING", "1"},
+        {"WAYLAND_DISPLAY", wayland_display},
+    };
 
-    int pipe_fd[2];
-    int ret = pipe2(pipe_fd, O_CLOEXEC);
-    if (ret == -1)
+#if WF_HAS_XWAYLAND
+    if (!xwayland_get_display().empty())
     {
-        LOGE("wf::compositor_core_impl_t::run: failed to create pipe2: ", strerror(errno));
-        return 0;
+        params.env.push_back({"DISPLAY", xwayland_get_display()});
     }
 
-    /* The following is a "hack" for disowning the child processes,
-     * otherwise they will simply stay as zombie processes */
-    pid_t pid = fork();
-    if (!pid)
-    {
-        restore_nofile_limit();
-        pid = fork();
-        if (!pid)
-        {
-            close(pipe_fd[READ_END]);
-            close(pipe_fd[WRITE_END]);
-
-            setenv("_JAVA_AWT_WM_NONREPARENTING", "1", 1);
-            setenv("WAYLAND_DISPLAY", wayland_display.c_str(), 1);
-#if WF_HAS_XWAYLAND
-            if (!xwayland_get_display().empty())
-            {
-                setenv("DISPLAY", xwayland_get_display().c_str(), 1);
-            }
-
 #endif
-            if (discard_command_output)
-            {
-                int dev_null = open("/dev/null", O_WRONLY);
-                dup2(dev_null, 1);
-                dup2(dev_null, 2);
-                close(dev_null);
-            }
 
-            _exit(execl("/bin/sh", "/bin/sh", "-c", command.c_str(), NULL));
-        } else
-        {
-            close(pipe_fd[READ_END]);
-            int ret = write(pipe_fd[WRITE_END], (void*)(&pid), sizeof(pid));
-            close(pipe_fd[WRITE_END]);
-            _exit(ret != sizeof(pid) ? 1 : 0);
-        }
-    } else
-    {
-        close(pipe_fd[WRITE_END]);
-
-        int status;
-        waitpid(pid, &status, 0);
-
-        // Return 0 if the child process didn't run or didn't exit normally, or returns a non-zero return
-        // value.
-        pid_t child_pid{};
-        if (WIFEXITED(status) && (WEXITSTATUS(status) == 0))
-        {
-            int ret = read(pipe_fd[READ_END], &child_pid, sizeof(child_pid));
-            if (ret != sizeof(child_pid))
-            {
-                // This is consider to be an error (even though theoretically a partial read would require an
-                // attempt to continue).
-                child_pid = 0;
-                if (ret == -1)
-                {
-                    LOGE("wf::compositor_core_impl_t::run(\"", command,
-                        "\"): failed to read PID from pipe end: ", strerror(errno));
-                } else
-                {
-                    LOGE("wf::compositor_core_impl_t::run(\"", command,
-                        "\"): short read of PID from pipe end, got ", std::to_string(ret), " bytes");
-                }
-            }
-        }
-
-        close(pipe_fd[READ_END]);
-
-        return child_pid;
-    }
+    return spawner->spawn(params);
 }
 
 std::string wf::compositor_core_impl_t::get_xwayland_display()
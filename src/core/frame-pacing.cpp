@@ -0,0 +1,638 @@
+// fifo-v1 and commit-timing-v1 Wayland protocols
+#include "frame-pacing.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <ctime>
+
+#include <wayfire/core.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/render-manager.hpp>
+#include <wayfire/util.hpp>
+#include <wayfire/debug.hpp>
+#include <wayfire/nonstd/wlroots-full.hpp>
+
+namespace wf
+{
+#define FIFO_MANAGER_VERSION 1
+#define COMMIT_TIMING_MANAGER_VERSION 1
+
+/**
+ * If a fifo barrier is not cleared by a presentation in this time (for example because the surface is not
+ * visible on any output), it is cleared anyway, so that hidden clients keep making progress, just slowly.
+ */
+static constexpr int BARRIER_TIMEOUT_MS = 1000;
+
+/**
+ * Clients usually compute their target times from presentation feedback, so allow for small rounding errors
+ * when comparing the target to the predicted presentation time.
+ */
+static constexpr int64_t TARGET_TOLERANCE_NS = 1'000'000;
+
+static int64_t timespec_to_nsec(const timespec& ts)
+{
+    return ts.tv_sec * 1'000'000'000ll + ts.tv_nsec;
+}
+
+static int64_t get_current_time_nsec()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timespec_to_nsec(now);
+}
+
+/**
+ * Tracks the vblanks of an output, and gives surfaces a chance to release timed updates once per refresh
+ * cycle, when the output has finished a frame.
+ */
+class output_pacing_t
+{
+  public:
+    wf::output_t *output;
+
+    output_pacing_t(wf::output_t *output, std::function<void()> on_frame_done,
+        std::function<void(uint32_t)> on_present)
+    {
+        this->output = output;
+
+        // Surface state must not be applied while the output is repainting, so updates are released after
+        // the frame instead of in a render hook. They are shown in the next frame.
+        this->on_frame_done = [=] (wf::frame_done_signal*) { on_frame_done(); };
+        output->connect(&this->on_frame_done);
+
+        this->on_commit.set_callback([=] (void *data)
+        {
+            auto ev = static_cast<wlr_output_event_commit*>(data);
+            if (ev->state->committed & WLR_OUTPUT_STATE_BUFFER)
+            {
+                frame_in_flight = true;
+            }
+        });
+        this->on_commit.connect(&output->handle->events.commit);
+
+        this->on_present.set_callback([=] (void *data)
+        {
+            auto ev = static_cast<wlr_output_event_present*>(data);
+            frame_in_flight = false;
+            if (ev->presented)
+            {
+                last_present = timespec_to_nsec(ev->when);
+                refresh = ev->refresh;
+            }
+
+            on_present(ev->commit_seq);
+        });
+        this->on_present.connect(&output->handle->events.present);
+    }
+
+    /** The time when a frame rendered after @now will be presented, or @now if it is not known. */
+    int64_t predict_next_vblank(int64_t now) const
+    {
+        if ((refresh <= 0) || (last_present <= 0))
+        {
+            return now;
+        }
+
+        int64_t cycles = std::max<int64_t>((now - last_present + refresh - 1) / refresh, 1);
+        if (frame_in_flight)
+        {
+            // The next vblank shows a frame which has already been committed.
+            ++cycles;
+        }
+
+        return last_present + cycles * refresh;
+    }
+
+    int64_t get_refresh() const
+    {
+        return refresh;
+    }
+
+  private:
+    wf::signal::connection_t<wf::frame_done_signal> on_frame_done;
+    wf::wl_listener_wrapper on_commit;
+    wf::wl_listener_wrapper on_present;
+    int64_t last_present = 0;
+    int64_t refresh = 0;
+    bool frame_in_flight = false;
+};
+
+/**
+ * The fifo and commit timing state of a single surface.
+ */
+class surface_pacing_t
+{
+  public:
+    wlr_surface *surface;
+    wl_resource *fifo  = nullptr;
+    wl_resource *timer = nullptr;
+
+    /* Double-buffered state for the next commit, set by requests on the fifo and timer objects. */
+    bool pending_set_barrier  = false;
+    bool pending_wait_barrier = false;
+    std::optional<int64_t> pending_target;
+
+    surface_pacing_t(frame_pacing_manager_t *manager, wlr_surface *surface,
+        std::function<void()> on_destroy)
+    {
+        this->manager = manager;
+        this->surface = surface;
+
+        on_client_commit.set_callback([=] (void*) { handle_client_commit(); });
+        on_client_commit.connect(&surface->events.client_commit);
+        on_commit.set_callback([=] (void*) { handle_commit(); });
+        on_commit.connect(&surface->events.commit);
+        on_surface_destroy.set_callback([=] (void*) { on_destroy(); });
+        on_surface_destroy.connect(&surface->events.destroy);
+    }
+
+    ~surface_pacing_t()
+    {
+        // The objects of the client remain, but their requests now fail with surface_destroyed.
+        if (fifo)
+        {
+            wl_resource_set_user_data(fifo, nullptr);
+        }
+
+        if (timer)
+        {
+            wl_resource_set_user_data(timer, nullptr);
+        }
+    }
+
+    /** The output used for pacing the surface, i.e the first output it is visible on. */
+    wlr_output *get_primary_output() const
+    {
+        wlr_surface_output *surface_output;
+        wl_list_for_each(surface_output, &surface->current_outputs, link)
+        {
+            return surface_output->output;
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * Release all queued updates whose conditions are met.
+     *
+     * Applying an update triggers the commit handlers of the surface, so this must not be called from
+     * within a surface commit or while an output is repainting.
+     */
+    void process()
+    {
+        bool released = true;
+        while (released)
+        {
+            released = false;
+            for (auto& update : queue)
+            {
+                if (!update.lock)
+                {
+                    continue;
+                }
+
+                if (!can_release(update))
+                {
+                    break;
+                }
+
+                // Unlocking applies the state synchronously, and the commit handler pops applied updates
+                // from the queue, so we need to start over.
+                uint32_t lock = *update.lock;
+                update.lock.reset();
+                wlr_surface_unlock_cached(surface, lock);
+                released = true;
+                break;
+            }
+        }
+
+        arm_wakeup();
+    }
+
+    /** An output presented the frame with the given output commit sequence number. */
+    void handle_present(wlr_output *output, uint32_t commit_seq)
+    {
+        if (barrier && (output == barrier_output) && ((int32_t)(commit_seq - barrier_commit_seq) > 0))
+        {
+            clear_barrier();
+        }
+    }
+
+  private:
+    frame_pacing_manager_t *manager;
+
+    struct queued_update_t
+    {
+        /** The sequence number of the surface state, see wlr_surface_state::seq. */
+        uint32_t seq;
+        bool set_barrier;
+        bool wait_barrier;
+        std::optional<int64_t> target;
+
+        /** The lock on the cached state, if the update is still held back. */
+        std::optional<uint32_t> lock;
+    };
+
+    /** Updates which have been committed by the client, but not applied yet. */
+    std::deque<queued_update_t> queue;
+
+    bool barrier = false;
+    wlr_output *barrier_output  = nullptr;
+    uint32_t barrier_commit_seq = 0;
+
+    wf::wl_timer<false> barrier_timeout;
+    wf::wl_timer<false> wakeup;
+    wf::wl_idle_call idle_process;
+
+    wf::wl_listener_wrapper on_client_commit;
+    wf::wl_listener_wrapper on_commit;
+    wf::wl_listener_wrapper on_surface_destroy;
+
+    bool is_due(int64_t target)
+    {
+        int64_t now = get_current_time_nsec();
+        auto output = manager->get_output(get_primary_output());
+        int64_t presentation = output ? output->predict_next_vblank(now) : now;
+        return presentation + TARGET_TOLERANCE_NS >= target;
+    }
+
+    bool can_release(const queued_update_t& update)
+    {
+        if (update.wait_barrier && barrier)
+        {
+            return false;
+        }
+
+        return !update.target || is_due(*update.target);
+    }
+
+    void handle_client_commit()
+    {
+        queued_update_t update;
+        update.seq = surface->pending.seq;
+        update.set_barrier  = std::exchange(pending_set_barrier, false);
+        update.wait_barrier = std::exchange(pending_wait_barrier, false);
+        update.target = std::exchange(pending_target, std::nullopt);
+
+        bool blocked_by_barrier = false;
+        if (update.wait_barrier)
+        {
+            // Earlier updates which are still queued may set a barrier when they are applied.
+            blocked_by_barrier = barrier;
+            for (auto& queued : queue)
+            {
+                blocked_by_barrier |= queued.set_barrier;
+            }
+        }
+
+        if (!update.set_barrier && !blocked_by_barrier && !update.target && queue.empty())
+        {
+            // Nothing to do, the update is applied right away.
+            return;
+        }
+
+        if (blocked_by_barrier || (update.target && !is_due(*update.target)))
+        {
+            update.lock = wlr_surface_lock_pending(surface);
+        }
+
+        queue.push_back(update);
+        if (update.lock)
+        {
+            arm_wakeup();
+        }
+    }
+
+    void handle_commit()
+    {
+        while (!queue.empty() && !queue.front().lock &&
+               ((int32_t)(surface->current.seq - queue.front().seq) >= 0))
+        {
+            if (queue.front().set_barrier)
+            {
+                set_barrier();
+            }
+
+            queue.pop_front();
+        }
+
+        if (!queue.empty())
+        {
+            idle_process.run_once([=] () { process(); });
+        }
+    }
+
+    void set_barrier()
+    {
+        barrier = true;
+        barrier_output = get_primary_output();
+        barrier_commit_seq = barrier_output ? barrier_output->commit_seq : 0;
+        barrier_timeout.set_timeout(BARRIER_TIMEOUT_MS, [=] () { clear_barrier(); });
+    }
+
+    void clear_barrier()
+    {
+        barrier = false;
+        barrier_output = nullptr;
+        barrier_timeout.disconnect();
+
+        // This may be called from an output commit, so defer releasing updates.
+        idle_process.run_once([=] () { process(); });
+    }
+
+    /**
+     * If the first held back update waits for a target time, wake up shortly before it is due.
+     * For visible surfaces, this is two refresh cycles before the target, at which point we schedule a
+     * repaint of the output. The update is then released when that frame is done, and shown in the next
+     * frame, on the right vblank.
+     */
+    void arm_wakeup()
+    {
+        wakeup.disconnect();
+        auto it = std::find_if(queue.begin(), queue.end(), [] (auto& update) { return update.lock; });
+        if ((it == queue.end()) || !it->target || (it->wait_barrier && barrier))
+        {
+            return;
+        }
+
+        int64_t now = get_current_time_nsec();
+        int64_t wake_at = *it->target;
+        if (auto output = manager->get_output(get_primary_output()))
+        {
+            if (*it->target - 2 * output->get_refresh() <= now)
+            {
+                // One of the next frames will release the update, the timer is just a fallback.
+                output->output->render->schedule_redraw();
+            } else
+            {
+                wake_at = *it->target - 2 * output->get_refresh();
+            }
+        }
+
+        int64_t delay_ms = (wake_at - now) / 1'000'000;
+        wakeup.set_timeout(std::max<int64_t>(delay_ms, 1), [=] () { process(); });
+    }
+};
+
+static surface_pacing_t *get_fifo_state(wl_resource *resource)
+{
+    auto state = static_cast<surface_pacing_t*>(wl_resource_get_user_data(resource));
+    if (!state)
+    {
+        wl_resource_post_error(resource, WP_FIFO_V1_ERROR_SURFACE_DESTROYED,
+            "the surface of the fifo object has been destroyed");
+    }
+
+    return state;
+}
+
+static void fifo_handle_set_barrier(wl_client*, wl_resource *resource)
+{
+    if (auto state = get_fifo_state(resource))
+    {
+        state->pending_set_barrier = true;
+    }
+}
+
+static void fifo_handle_wait_barrier(wl_client*, wl_resource *resource)
+{
+    if (auto state = get_fifo_state(resource))
+    {
+        state->pending_wait_barrier = true;
+    }
+}
+
+static void timer_handle_set_timestamp(wl_client*, wl_resource *resource, uint32_t tv_sec_hi,
+    uint32_t tv_sec_lo, uint32_t tv_nsec)
+{
+    auto state = static_cast<surface_pacing_t*>(wl_resource_get_user_data(resource));
+    if (!state)
+    {
+        wl_resource_post_error(resource, WP_COMMIT_TIMER_V1_ERROR_SURFACE_DESTROYED,
+            "the surface of the commit timer has been destroyed");
+        return;
+    }
+
+    if (tv_nsec >= 1'000'000'000)
+    {
+        wl_resource_post_error(resource, WP_COMMIT_TIMER_V1_ERROR_INVALID_TIMESTAMP,
+            "tv_nsec must be less than one second");
+        return;
+    }
+
+    if (state->pending_target)
+    {
+        wl_resource_post_error(resource, WP_COMMIT_TIMER_V1_ERROR_TIMESTAMP_EXISTS,
+            "a timestamp has already been set for this commit");
+        return;
+    }
+
+    int64_t tv_sec = ((uint64_t)tv_sec_hi << 32) | tv_sec_lo;
+    state->pending_target = tv_sec * 1'000'000'000ll + tv_nsec;
+}
+
+static void resource_handle_destroy(wl_client*, wl_resource *resource)
+{
+    wl_resource_destroy(resource);
+}
+
+constexpr static const struct wp_fifo_v1_interface fifo_implementation = {
+    .set_barrier  = fifo_handle_set_barrier,
+    .wait_barrier = fifo_handle_wait_barrier,
+    .destroy = resource_handle_destroy,
+};
+
+constexpr static const struct wp_commit_timer_v1_interface commit_timer_implementation = {
+    .set_timestamp = timer_handle_set_timestamp,
+    .destroy = resource_handle_destroy,
+};
+
+static void handle_fifo_resource_destroy(wl_resource *resource)
+{
+    if (auto state = static_cast<surface_pacing_t*>(wl_resource_get_user_data(resource)))
+    {
+        state->fifo = nullptr;
+        state->pending_set_barrier  = false;
+        state->pending_wait_barrier = false;
+    }
+}
+
+static void handle_timer_resource_destroy(wl_resource *resource)
+{
+    if (auto state = static_cast<surface_pacing_t*>(wl_resource_get_user_data(resource)))
+    {
+        state->timer = nullptr;
+        state->pending_target.reset();
+    }
+}
+
+constexpr const struct wp_fifo_manager_v1_interface frame_pacing_manager_t::fifo_manager_implementation = {
+    .destroy  = frame_pacing_manager_t::generic_handle_destroy,
+    .get_fifo = frame_pacing_manager_t::handle_get_fifo,
+};
+
+constexpr const struct wp_commit_timing_manager_v1_interface
+frame_pacing_manager_t::commit_timing_manager_implementation = {
+    .destroy   = frame_pacing_manager_t::generic_handle_destroy,
+    .get_timer = frame_pacing_manager_t::handle_get_timer,
+};
+
+frame_pacing_manager_t::frame_pacing_manager_t(wl_display *display)
+{
+    this->fifo_global = wl_global_create(display, &wp_fifo_manager_v1_interface,
+        FIFO_MANAGER_VERSION, this, frame_pacing_manager_t::fifo_manager_bind);
+    this->commit_timing_global = wl_global_create(display, &wp_commit_timing_manager_v1_interface,
+        COMMIT_TIMING_MANAGER_VERSION, this, frame_pacing_manager_t::commit_timing_manager_bind);
+
+    on_output_added = [=] (wf::output_added_signal *ev)
+    {
+        add_output(ev->output);
+    };
+    on_output_pre_remove = [=] (wf::output_pre_remove_signal *ev)
+    {
+        outputs.erase(ev->output->handle);
+    };
+
+    wf::get_core().output_layout->connect(&on_output_added);
+    wf::get_core().output_layout->connect(&on_output_pre_remove);
+    for (auto& output : wf::get_core().output_layout->get_outputs())
+    {
+        add_output(output);
+    }
+}
+
+frame_pacing_manager_t::~frame_pacing_manager_t()
+{
+    wl_global_destroy(fifo_global);
+    wl_global_destroy(commit_timing_global);
+}
+
+void frame_pacing_manager_t::add_output(wf::output_t *output)
+{
+    wlr_output *handle = output->handle;
+    auto on_frame_done = [=] ()
+    {
+        for (auto& [surface, state] : surfaces)
+        {
+            if (state->get_primary_output() == handle)
+            {
+                state->process();
+            }
+        }
+    };
+
+    auto on_present = [=] (uint32_t commit_seq)
+    {
+        for (auto& [surface, state] : surfaces)
+        {
+            state->handle_present(handle, commit_seq);
+        }
+    };
+
+    outputs[handle] = std::make_unique<output_pacing_t>(output, on_frame_done, on_present);
+}
+
+output_pacing_t*frame_pacing_manager_t::get_output(wlr_output *output)
+{
+    auto it = outputs.find(output);
+    return (it == outputs.end()) ? nullptr : it->second.get();
+}
+
+surface_pacing_t*frame_pacing_manager_t::get_surface_state(wlr_surface *surface)
+{
+    auto& state = surfaces[surface];
+    if (!state)
+    {
+        state = std::make_unique<surface_pacing_t>(this, surface, [=] ()
+        {
+            surfaces.erase(surface);
+        });
+    }
+
+    return state.get();
+}
+
+void frame_pacing_manager_t::fifo_manager_bind(wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+    auto self = static_cast<frame_pacing_manager_t*>(data);
+    wl_resource *resource = wl_resource_create(client, &wp_fifo_manager_v1_interface, version, id);
+    if (resource == NULL)
+    {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(resource, &fifo_manager_implementation, self, NULL);
+}
+
+void frame_pacing_manager_t::commit_timing_manager_bind(wl_client *client, void *data,
+    uint32_t version, uint32_t id)
+{
+    auto self = static_cast<frame_pacing_manager_t*>(data);
+    wl_resource *resource = wl_resource_create(client, &wp_commit_timing_manager_v1_interface, version, id);
+    if (resource == NULL)
+    {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(resource, &commit_timing_manager_implementation, self, NULL);
+}
+
+void frame_pacing_manager_t::generic_handle_destroy(wl_client*, wl_resource *resource)
+{
+    wl_resource_destroy(resource);
+}
+
+void frame_pacing_manager_t::handle_get_fifo(wl_client *client, wl_resource *resource, uint32_t id,
+    wl_resource *surface_resource)
+{
+    auto self    = static_cast<frame_pacing_manager_t*>(wl_resource_get_user_data(resource));
+    auto surface = wlr_surface_from_resource(surface_resource);
+    auto state   = self->get_surface_state(surface);
+    if (state->fifo)
+    {
+        wl_resource_post_error(resource, WP_FIFO_MANAGER_V1_ERROR_ALREADY_EXISTS,
+            "the surface already has a fifo object");
+        return;
+    }
+
+    wl_resource *fifo = wl_resource_create(client, &wp_fifo_v1_interface, wl_resource_get_version(resource),
+        id);
+    if (!fifo)
+    {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(fifo, &fifo_implementation, state, handle_fifo_resource_destroy);
+    state->fifo = fifo;
+}
+
+void frame_pacing_manager_t::handle_get_timer(wl_client *client, wl_resource *resource, uint32_t id,
+    wl_resource *surface_resource)
+{
+    auto self    = static_cast<frame_pacing_manager_t*>(wl_resource_get_user_data(resource));
+    auto surface = wlr_surface_from_resource(surface_resource);
+    auto state   = self->get_surface_state(surface);
+    if (state->timer)
+    {
+        wl_resource_post_error(resource, WP_COMMIT_TIMING_MANAGER_V1_ERROR_COMMIT_TIMER_EXISTS,
+            "the surface already has a commit timer");
+        return;
+    }
+
+    wl_resource *timer = wl_resource_create(client, &wp_commit_timer_v1_interface,
+        wl_resource_get_version(resource), id);
+    if (!timer)
+    {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(timer, &commit_timer_implementation, state, handle_timer_resource_destroy);
+    state->timer = timer;
+}
+}
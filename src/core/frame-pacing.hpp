@@ -0,0 +1,58 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <wayfire/nonstd/wlroots.hpp>
+#include <wayfire/output-layout.hpp>
+#include "fifo-v1-protocol.h"
+#include "commit-timing-v1-protocol.h"
+
+namespace wf
+{
+class surface_pacing_t;
+class output_pacing_t;
+
+/**
+ * Implements the fifo-v1 and commit-timing-v1 protocols, which let clients queue content updates which are
+ * applied only once the previous update has been presented (fifo), or not before a given time (commit
+ * timing).
+ *
+ * Queued updates are held back with wlroots' cached surface state (wlr_surface_lock_pending()), so the
+ * surface keeps its current content until the update is released. Timed updates of surfaces which are
+ * visible on an output are released when the output finishes the frame before the first refresh cycle at or
+ * after the target time, so they are presented on the right vblank without the client waiting for frame
+ * callbacks.
+ */
+class frame_pacing_manager_t
+{
+  public:
+    frame_pacing_manager_t(wl_display *display);
+    ~frame_pacing_manager_t();
+
+    /** The vblank prediction for the given output, or nullptr if the output is not enabled. */
+    output_pacing_t *get_output(wlr_output *output);
+
+  private:
+    wl_global *fifo_global;
+    wl_global *commit_timing_global;
+
+    std::map<wlr_surface*, std::unique_ptr<surface_pacing_t>> surfaces;
+    std::map<wlr_output*, std::unique_ptr<output_pacing_t>> outputs;
+
+    wf::signal::connection_t<wf::output_added_signal> on_output_added;
+    wf::signal::connection_t<wf::output_pre_remove_signal> on_output_pre_remove;
+
+    void add_output(wf::output_t *output);
+    surface_pacing_t *get_surface_state(wlr_surface *surface);
+
+    static void fifo_manager_bind(wl_client *client, void *data, uint32_t version, uint32_t id);
+    static void commit_timing_manager_bind(wl_client *client, void *data, uint32_t version, uint32_t id);
+    static void generic_handle_destroy(wl_client *client, wl_resource *resource);
+    static void handle_get_fifo(wl_client *client, wl_resource *resource, uint32_t id,
+        wl_resource *surface_resource);
+    static void handle_get_timer(wl_client *client, wl_resource *resource, uint32_t id,
+        wl_resource *surface_resource);
+    static const struct wp_fifo_manager_v1_interface fifo_manager_implementation;
+    static const struct wp_commit_timing_manager_v1_interface commit_timing_manager_implementation;
+};
+}
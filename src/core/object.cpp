@@ -40,6 +40,19 @@ void wf::signal::provider_t::for_each_connection(
     priv->typed_connections[type].for_each(func);
 }
 
+bool wf::signal::provider_t::has_connections_base(std::type_index type)
+{
+    auto it = priv->typed_connections.find(type);
+    if (it == priv->typed_connections.end())
+    {
+        return false;
+    }
+
+    bool connected = false;
+    it->second.for_each([&] (connection_base_t*) { connected = true; });
+    return connected;
+}
+
 void wf::signal::connection_base_t::disconnect()
 {
     auto connected_copy = this->connected_to;
@@ -8,6 +8,7 @@
 #include "wayfire/util.hpp"
 #include "wayfire/config-backend.hpp"
 #include "output-layout-priv.hpp"
+#include "vrr-policy.hpp"
 
 #include "../output/output-impl.hpp"
 #include <xf86drmMode.h>
@@ -476,6 +477,7 @@ struct output_layout_output_t
     std::optional<bool> current_hdr_enabled;
 
     std::unique_ptr<wf::output_impl_t> output;
+    std::unique_ptr<wf::vrr_policy_t> vrr_policy;
     wl_listener_wrapper on_destroy, on_commit, on_request_state;
 
     std::shared_ptr<wf::config::section_t> config_section;
@@ -484,6 +486,8 @@ struct output_layout_output_t
     wf::option_wrapper_t<double> scale_opt;
     wf::option_wrapper_t<std::string> transform_opt;
     wf::option_wrapper_t<bool> vrr_opt;
+    wf::option_wrapper_t<std::string> vrr_policy_opt;
+    wf::option_wrapper_t<int> vrr_idle_timeout_opt;
     wf::option_wrapper_t<bool> hdr_opt;
     wf::option_wrapper_t<int> depth_opt;
 
@@ -498,8 +502,13 @@ struct output_layout_output_t
         scale_opt.load_option(config_section, "scale");
         transform_opt.load_option(config_section, "transform");
         vrr_opt.load_option(config_section, "vrr");
+        vrr_policy_opt.load_option(config_section, "vrr_policy");
+        vrr_idle_timeout_opt.load_option(config_section, "vrr_idle_timeout");
         hdr_opt.load_option(config_section, "hdr");
         depth_opt.load_option(config_section, "depth");
+
+        vrr_policy_opt.set_callback([=] () { update_vrr_policy(); });
+        vrr_idle_timeout_opt.set_callback([=] () { update_vrr_policy(); });
     }
 
     output_layout_output_t(wlr_output *handle)
@@ -788,6 +797,7 @@ struct output_layout_output_t
         output_added_signal data;
         data.output = wo;
         get_core().output_layout->emit(&data);
+        update_vrr_policy();
     }
 
     void destroy_wayfire_output()
@@ -800,6 +810,7 @@ struct output_layout_output_t
         LOGE("disabling output: ", output->handle->name);
 
         auto wo = output.get();
+        vrr_policy.reset();
 
         output_pre_remove_signal data;
         data.output = wo;
@@ -917,15 +928,52 @@ struct output_layout_output_t
         pending_state.commit(handle);
     }
 
+    /**
+     * With the "content" policy, adaptive sync follows what is shown on the output, otherwise it follows the
+     * static configuration.
+     */
+    bool wants_vrr()
+    {
+        if (vrr_policy)
+        {
+            return handle->adaptive_sync_supported && vrr_policy->wants_vrr();
+        }
+
+        return current_state.vrr;
+    }
+
+    void update_vrr_policy()
+    {
+        if (!output)
+        {
+            return;
+        }
+
+        if (std::string(vrr_policy_opt) != "content")
+        {
+            vrr_policy.reset();
+        } else if (!vrr_policy)
+        {
+            vrr_policy = std::make_unique<wf::vrr_policy_t>(output.get(), [=] () { apply_vrr(wants_vrr()); });
+        }
+
+        if (vrr_policy)
+        {
+            vrr_policy->set_idle_timeout(vrr_idle_timeout_opt);
+        }
+
+        apply_vrr(wants_vrr());
+    }
+
     void apply_vrr(bool want_vrr_enabled)
     {
         const bool adaptive_sync_enabled = (handle->adaptive_sync_status == WLR_OUTPUT_ADAPTIVE_SYNC_ENABLED);
         if (adaptive_sync_enabled != want_vrr_enabled)
         {
-            wlr_output_state_set_adaptive_sync_enabled(&pending_state.pending, current_state.vrr);
+            wlr_output_state_set_adaptive_sync_enabled(&pending_state.pending, want_vrr_enabled);
             if (pending_state.test_and_commit(handle))
             {
-                LOGC(OUTPUT, "Changed adaptive sync on output: ", handle->name, " to ", current_state.vrr);
+                LOGC(OUTPUT, "Changed adaptive sync on output: ", handle->name, " to ", want_vrr_enabled);
             } else
             {
                 LOGE("Failed to change adaptive sync on output: ", handle->name);
@@ -1247,7 +1295,7 @@ struct output_layout_output_t
 
         set_enabled(!(state.source & OUTPUT_IMAGE_SOURCE_NONE));
         apply_mode(state.mode, state.uses_custom_mode);
-        apply_vrr(state.vrr);
+        apply_vrr(wants_vrr());
         apply_depth(state.depth);
         apply_hdr(state.hdr);
 
@@ -1303,6 +1351,11 @@ class output_layout_t::impl
 
     wf::signal::connection_t<wf::reload_config_signal> on_config_reload = [=] (wf::reload_config_signal *ev)
     {
+        if (!ev->section_changed("output"))
+        {
+            return;
+        }
+
         reconfigure_from_config();
     };
 
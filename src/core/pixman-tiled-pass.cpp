@@ -0,0 +1,595 @@
+#include "pixman-tiled-pass.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <pixman.h>
+
+#include <wayfire/nonstd/wlroots-full.hpp>
+#include <wayfire/option-wrapper.hpp>
+#include <wayfire/util/log.hpp>
+
+/** The maximal number of threads used for software rendering when core/software_render_threads is 0. */
+static constexpr int MAX_AUTO_THREADS = 8;
+
+/** Damage smaller than this (in pixels) is rendered on the compositor thread without splitting it. */
+static constexpr int64_t MIN_PARALLEL_AREA = 128 * 128;
+
+/** Bands are at least this many pixel rows high, to keep the per-band overhead low. */
+static constexpr int MIN_BAND_HEIGHT = 32;
+
+namespace
+{
+/**
+ * A fixed set of worker threads which execute the tasks of one batch in parallel.
+ * The thread calling run() participates in the work, so a pool for N threads starts N - 1 workers.
+ */
+class worker_pool_t
+{
+  public:
+    worker_pool_t(int threads)
+    {
+        for (int i = 1; i < threads; i++)
+        {
+            workers.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~worker_pool_t()
+    {
+        {
+            std::lock_guard lock{mutex};
+            stopping = true;
+        }
+
+        work_available.notify_all();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    int get_thread_count() const
+    {
+        return workers.size() + 1;
+    }
+
+    /**
+     * Run @task for all indices in [0, count) and wait until all of them are done.
+     */
+    void run(size_t count, const std::function<void(size_t)>& task)
+    {
+        {
+            std::lock_guard lock{mutex};
+            current   = &task;
+            total     = count;
+            next_task = 0;
+            finished  = 0;
+            ++generation;
+        }
+
+        work_available.notify_all();
+        execute_tasks();
+
+        std::unique_lock lock{mutex};
+        all_done.wait(lock, [&] { return finished == total; });
+        current = nullptr;
+    }
+
+  private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable all_done;
+
+    const std::function<void(size_t)> *current = nullptr;
+    size_t total     = 0;
+    size_t next_task = 0;
+    size_t finished  = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    void execute_tasks()
+    {
+        std::unique_lock lock{mutex};
+        while (current && (next_task < total))
+        {
+            size_t idx = next_task++;
+            auto task  = current;
+            lock.unlock();
+            (*task)(idx);
+            lock.lock();
+
+            if (++finished == total)
+            {
+                all_done.notify_all();
+            }
+        }
+    }
+
+    void worker_loop()
+    {
+        uint64_t seen_generation = 0;
+        while (true)
+        {
+            {
+                std::unique_lock lock{mutex};
+                work_available.wait(lock, [&] { return stopping || (generation != seen_generation); });
+                if (stopping)
+                {
+                    return;
+                }
+
+                seen_generation = generation;
+            }
+
+            execute_tasks();
+        }
+    }
+};
+
+int get_configured_threads()
+{
+    static wf::option_wrapper_t<int> software_render_threads{"core/software_render_threads"};
+    if (software_render_threads > 0)
+    {
+        return software_render_threads;
+    }
+
+    return std::clamp<int>(std::thread::hardware_concurrency(), 1, MAX_AUTO_THREADS);
+}
+
+worker_pool_t& get_pool(int threads)
+{
+    static std::unique_ptr<worker_pool_t> pool;
+    if (!pool || (pool->get_thread_count() != threads))
+    {
+        pool.reset();
+        pool = std::make_unique<worker_pool_t>(threads);
+    }
+
+    return *pool;
+}
+
+pixman_op_t get_pixman_op(wlr_render_blend_mode mode)
+{
+    return (mode == WLR_RENDER_BLEND_MODE_NONE) ? PIXMAN_OP_SRC : PIXMAN_OP_OVER;
+}
+
+uint16_t to_pixman_channel(float value)
+{
+    // Truncate like the wlroots pixman renderer, so that both produce the same colors.
+    return std::clamp(value, 0.0f, 1.0f) * 0xFFFF;
+}
+
+/**
+ * A second pixman image for the same pixel data as @image. Pixman images carry state like the clip region,
+ * the transform and the filter, so every thread needs its own image for each source and for the target.
+ */
+pixman_image_t *wrap_image(pixman_image_t *image)
+{
+    return pixman_image_create_bits_no_clear(pixman_image_get_format(image),
+        pixman_image_get_width(image), pixman_image_get_height(image),
+        pixman_image_get_data(image), pixman_image_get_stride(image));
+}
+
+/**
+ * Compute the transform from target coordinates to source texture coordinates for drawing @src_box of the
+ * texture into @dst_box with the given @transform, as the wlroots renderers do.
+ */
+pixman_transform_t compute_source_transform(const wlr_fbox& src_box, const wlr_box& dst_box,
+    wl_output_transform transform)
+{
+    // Position in the destination box, normalized to [0, 1] -> position in the source box, normalized
+    // to [0, 1]: (x, y) -> (a * x + b * y + c, d * x + e * y + f).
+    double a = 1, b = 0, c = 0, d = 0, e = 1, f = 0;
+    switch (transform)
+    {
+      case WL_OUTPUT_TRANSFORM_NORMAL:
+        break;
+
+      case WL_OUTPUT_TRANSFORM_90:
+        a = 0, b = 1, c = 0, d = -1, e = 0, f = 1;
+        break;
+
+      case WL_OUTPUT_TRANSFORM_180:
+        a = -1, b = 0, c = 1, d = 0, e = -1, f = 1;
+        break;
+
+      case WL_OUTPUT_TRANSFORM_270:
+        a = 0, b = -1, c = 1, d = 1, e = 0, f = 0;
+        break;
+
+      case WL_OUTPUT_TRANSFORM_FLIPPED:
+        a = -1, b = 0, c = 1, d = 0, e = 1, f = 0;
+        break;
+
+      case WL_OUTPUT_TRANSFORM_FLIPPED_90:
+        a = 0, b = 1, c = 0, d = 1, e = 0, f = 0;
+        break;
+
+      case WL_OUTPUT_TRANSFORM_FLIPPED_180:
+        a = 1, b = 0, c = 0, d = 0, e = -1, f = 1;
+        break;
+
+      case WL_OUTPUT_TRANSFORM_FLIPPED_270:
+        a = 0, b = -1, c = 1, d = -1, e = 0, f = 1;
+        break;
+    }
+
+    pixman_f_transform ftransform;
+    ftransform.m[0][0] = src_box.width * a / dst_box.width;
+    ftransform.m[0][1] = src_box.width * b / dst_box.height;
+    ftransform.m[0][2] = src_box.x + src_box.width *
+        (c - a * dst_box.x / dst_box.width - b * dst_box.y / dst_box.height);
+    ftransform.m[1][0] = src_box.height * d / dst_box.width;
+    ftransform.m[1][1] = src_box.height * e / dst_box.height;
+    ftransform.m[1][2] = src_box.y + src_box.height *
+        (f - d * dst_box.x / dst_box.width - e * dst_box.y / dst_box.height);
+    ftransform.m[2][0] = 0;
+    ftransform.m[2][1] = 0;
+    ftransform.m[2][2] = 1;
+
+    pixman_transform_t result;
+    pixman_transform_from_pixman_f_transform(&result, &ftransform);
+    return result;
+}
+}
+
+std::unique_ptr<wf::pixman_tiled_pass_t> wf::pixman_tiled_pass_t::create(wlr_renderer *renderer)
+{
+    if (!renderer || !wlr_renderer_is_pixman(renderer))
+    {
+        return nullptr;
+    }
+
+    int threads = get_configured_threads();
+    if (threads <= 1)
+    {
+        return nullptr;
+    }
+
+    return std::unique_ptr<pixman_tiled_pass_t>(new pixman_tiled_pass_t(threads));
+}
+
+wf::pixman_tiled_pass_t::pixman_tiled_pass_t(int threads) : threads(threads)
+{}
+
+bool wf::pixman_tiled_pass_t::has_pending() const
+{
+    return !ops.empty();
+}
+
+bool wf::pixman_tiled_pass_t::add_texture(const std::shared_ptr<wf::texture_t>& texture,
+    const wlr_render_texture_options& opts)
+{
+    if (!wlr_texture_is_pixman(opts.texture) || !wlr_pixman_texture_get_image(opts.texture))
+    {
+        return false;
+    }
+
+    operation_t op;
+    op.texture = texture;
+    op.wlr_tex = opts.texture;
+    op.src_box = opts.src_box;
+    if ((op.src_box.width <= 0) || (op.src_box.height <= 0))
+    {
+        op.src_box = {0, 0, (double)opts.texture->width, (double)opts.texture->height};
+    }
+
+    op.transform  = opts.transform;
+    op.filter     = opts.filter_mode;
+    op.alpha      = opts.alpha ? *opts.alpha : 1.0;
+    op.dst_box    = opts.dst_box;
+    op.blend_mode = opts.blend_mode;
+    op.clip = opts.clip ? wf::region_t{opts.clip} :
+        wf::region_t{op.dst_box};
+    ops.push_back(std::move(op));
+    return true;
+}
+
+void wf::pixman_tiled_pass_t::add_rect(const wlr_render_rect_options& opts)
+{
+    operation_t op;
+    op.color   = opts.color;
+    op.dst_box = opts.box;
+    // Opaque rectangles do not need blending, same as in the wlroots pixman renderer.
+    op.blend_mode = (opts.color.a >= 1.0) ? WLR_RENDER_BLEND_MODE_NONE : opts.blend_mode;
+    op.clip = opts.clip ? wf::region_t{opts.clip} :
+        wf::region_t{op.dst_box};
+    ops.push_back(std::move(op));
+}
+
+void wf::pixman_tiled_pass_t::flush_to_wlroots(wlr_render_pass *pass, std::vector<operation_t>& recorded)
+{
+    for (auto& op : recorded)
+    {
+        if (op.texture)
+        {
+            wlr_render_texture_options opts{};
+            opts.texture    = op.wlr_tex;
+            opts.src_box    = op.src_box;
+            opts.dst_box    = op.dst_box;
+            opts.alpha      = &op.alpha;
+            opts.clip       = op.clip.to_pixman();
+            opts.transform  = op.transform;
+            opts.filter_mode = op.filter;
+            opts.blend_mode = op.blend_mode;
+            wlr_render_pass_add_texture(pass, &opts);
+        } else
+        {
+            wlr_render_rect_options opts{};
+            opts.box   = op.dst_box;
+            opts.color = op.color;
+            opts.clip  = op.clip.to_pixman();
+            opts.blend_mode = op.blend_mode;
+            wlr_render_pass_add_rect(pass, &opts);
+        }
+    }
+}
+
+bool wf::pixman_tiled_pass_t::prepare_sources(std::vector<operation_t>& recorded, wlr_buffer *target,
+    std::vector<wlr_buffer*>& accessed)
+{
+    struct access_t
+    {
+        void *data;
+        size_t stride;
+    };
+
+    std::map<wlr_buffer*, access_t> accesses;
+    for (auto& op : recorded)
+    {
+        if (!op.texture)
+        {
+            continue;
+        }
+
+        pixman_image_t *image = wlr_pixman_texture_get_image(op.wlr_tex);
+        wlr_buffer *buffer    = op.texture->get_buffer();
+        if (!buffer)
+        {
+            // The texture owns its pixels, they cannot change or go away while it is alive.
+            op.source = pixman_image_ref(image);
+            continue;
+        }
+
+        // The pixels of client buffers are in the memory of the client, which may truncate it at any time.
+        auto client_buffer = wlr_client_buffer_get(buffer);
+        if (client_buffer)
+        {
+            buffer = client_buffer->source;
+        }
+
+        if (!buffer || (buffer == target))
+        {
+            return false;
+        }
+
+        auto it = accesses.find(buffer);
+        if (it == accesses.end())
+        {
+            access_t access;
+            uint32_t format;
+            if (!wlr_buffer_begin_data_ptr_access(buffer, WLR_BUFFER_DATA_PTR_ACCESS_READ,
+                &access.data, &format, &access.stride))
+            {
+                return false;
+            }
+
+            accessed.push_back(buffer);
+            it = accesses.emplace(buffer, access).first;
+        }
+
+        // The data pointer may have changed since the texture image was created, so create a new image for
+        // the current one.
+        const auto pixman_format = pixman_image_get_format(image);
+        const int width  = pixman_image_get_width(image);
+        const int height = pixman_image_get_height(image);
+        pixman_image_t *current = pixman_image_create_bits_no_clear(pixman_format, width, height,
+            static_cast<uint32_t*>(it->second.data), int(it->second.stride));
+        if (!client_buffer)
+        {
+            op.source = current;
+            continue;
+        }
+
+        // wl_shm protects only the thread which accessed the buffer against SIGBUS, so the worker threads
+        // must not touch client memory. Copy the sampled part of the texture (with a margin for bilinear
+        // filtering) here instead.
+        wf::geometry_t rect;
+        rect.x = std::floor(op.src_box.x) - 1;
+        rect.y = std::floor(op.src_box.y) - 1;
+        rect.width  = std::ceil(op.src_box.x + op.src_box.width) + 1 - rect.x;
+        rect.height = std::ceil(op.src_box.y + op.src_box.height) + 1 - rect.y;
+        rect = wf::geometry_intersection(rect, {0, 0, width, height});
+
+        op.source   = pixman_image_create_bits_no_clear(pixman_format, rect.width, rect.height, NULL, 0);
+        op.source_x = rect.x;
+        op.source_y = rect.y;
+        pixman_image_composite32(PIXMAN_OP_SRC, current, NULL, op.source, rect.x, rect.y, 0, 0, 0, 0,
+            rect.width, rect.height);
+        pixman_image_unref(current);
+    }
+
+    return true;
+}
+
+void wf::pixman_tiled_pass_t::release_sources(std::vector<operation_t>& recorded,
+    std::vector<wlr_buffer*>& accessed)
+{
+    for (auto& op : recorded)
+    {
+        if (op.source)
+        {
+            pixman_image_unref(op.source);
+            op.source = nullptr;
+        }
+    }
+
+    for (auto buffer : accessed)
+    {
+        wlr_buffer_end_data_ptr_access(buffer);
+    }
+
+    accessed.clear();
+}
+
+void wf::pixman_tiled_pass_t::flush(wlr_render_pass *pass, wlr_renderer *renderer, wlr_buffer *target)
+{
+    if (ops.empty())
+    {
+        return;
+    }
+
+    auto recorded = std::move(ops);
+    ops.clear();
+
+    pixman_image_t *target_image = wlr_pixman_renderer_get_buffer_image(renderer, target);
+    if (!target_image)
+    {
+        LOGE("Cannot access the pixman image of the render target, falling back to wlroots rendering.");
+        flush_to_wlroots(pass, recorded);
+        return;
+    }
+
+    const wf::geometry_t bounds = {0, 0,
+        pixman_image_get_width(target_image), pixman_image_get_height(target_image)};
+
+    wf::region_t damage;
+    for (auto& op : recorded)
+    {
+        op.clip &= op.dst_box;
+        op.clip &= bounds;
+        damage  |= op.clip;
+    }
+
+    if (damage.empty())
+    {
+        return;
+    }
+
+    std::vector<wlr_buffer*> accessed;
+    if (!prepare_sources(recorded, target, accessed))
+    {
+        release_sources(recorded, accessed);
+        flush_to_wlroots(pass, recorded);
+        return;
+    }
+
+    // Split the damaged rows into horizontal bands. Pixman processes images row by row, so bands keep the
+    // memory accessed by each thread contiguous.
+    auto extents = wlr_box_from_pixman_box(damage.get_extents());
+    int64_t area = 0;
+    for (auto& rect : damage)
+    {
+        area += int64_t(rect.x2 - rect.x1) * (rect.y2 - rect.y1);
+    }
+
+    int nr_bands = 1;
+    if (area >= MIN_PARALLEL_AREA)
+    {
+        nr_bands = std::clamp(extents.height / MIN_BAND_HEIGHT, 1, 2 * threads);
+    }
+
+    std::vector<wf::region_t> bands;
+    for (int i = 0; i < nr_bands; i++)
+    {
+        int y1 = extents.y + extents.height * i / nr_bands;
+        int y2 = extents.y + extents.height * (i + 1) / nr_bands;
+        wf::region_t band = damage & wf::geometry_t{bounds.x, y1, bounds.width, y2 - y1};
+        if (!band.empty())
+        {
+            bands.push_back(std::move(band));
+        }
+    }
+
+    auto render_band = [&] (size_t idx)
+    {
+        pixman_image_t *dst = wrap_image(target_image);
+        for (auto& op : recorded)
+        {
+            wf::region_t clip = op.clip & bands[idx];
+            if (clip.empty())
+            {
+                continue;
+            }
+
+            pixman_image_set_clip_region32(dst, clip.to_pixman());
+            const pixman_op_t pixman_op = get_pixman_op(op.blend_mode);
+            const auto& box = op.dst_box;
+
+            if (!op.texture)
+            {
+                pixman_color_t color = {
+                    .red   = to_pixman_channel(op.color.r),
+                    .green = to_pixman_channel(op.color.g),
+                    .blue  = to_pixman_channel(op.color.b),
+                    .alpha = to_pixman_channel(op.color.a),
+                };
+
+                pixman_image_t *fill = pixman_image_create_solid_fill(&color);
+                pixman_image_composite32(pixman_op, fill, NULL, dst, 0, 0, 0, 0,
+                    box.x, box.y, box.width, box.height);
+                pixman_image_unref(fill);
+                continue;
+            }
+
+            pixman_image_t *src  = wrap_image(op.source);
+            pixman_image_t *mask = NULL;
+            if (op.alpha < 1.0)
+            {
+                pixman_color_t mask_color = {0, 0, 0, to_pixman_channel(op.alpha)};
+                mask = pixman_image_create_solid_fill(&mask_color);
+            }
+
+            // Source box relative to the prepared source image.
+            wlr_fbox src_box = op.src_box;
+            src_box.x -= op.source_x;
+            src_box.y -= op.source_y;
+
+            const bool is_identity = (op.transform == WL_OUTPUT_TRANSFORM_NORMAL) &&
+                (src_box.x == std::round(src_box.x)) && (src_box.y == std::round(src_box.y)) &&
+                (src_box.width == box.width) && (src_box.height == box.height);
+
+            if (is_identity)
+            {
+                pixman_image_composite32(pixman_op, src, mask, dst, src_box.x, src_box.y, 0, 0,
+                    box.x, box.y, box.width, box.height);
+            } else
+            {
+                auto transform = compute_source_transform(src_box, box, op.transform);
+                pixman_image_set_transform(src, &transform);
+                pixman_image_set_filter(src, (op.filter == WLR_SCALE_FILTER_NEAREST) ?
+                    PIXMAN_FILTER_NEAREST : PIXMAN_FILTER_BILINEAR, NULL, 0);
+                // The transform maps target coordinates to texture coordinates, so the source origin is
+                // the same as the destination origin.
+                pixman_image_composite32(pixman_op, src, mask, dst, box.x, box.y, 0, 0,
+                    box.x, box.y, box.width, box.height);
+            }
+
+            if (mask)
+            {
+                pixman_image_unref(mask);
+            }
+
+            pixman_image_unref(src);
+        }
+
+        pixman_image_unref(dst);
+    };
+
+    if (bands.size() == 1)
+    {
+        render_band(0);
+    } else
+    {
+        get_pool(threads).run(bands.size(), render_band);
+    }
+
+    release_sources(recorded, accessed);
+}
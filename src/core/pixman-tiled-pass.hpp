@@ -0,0 +1,96 @@
+#pragma once
+
+#include <memory>
+#include <pixman.h>
+#include <vector>
+#include <wayfire/render.hpp>
+#include <wayfire/region.hpp>
+
+namespace wf
+{
+/**
+ * A software render pass for the pixman renderer which splits the work of a frame across multiple threads.
+ *
+ * The wlroots pixman render pass executes every operation immediately on the compositor thread. Instead,
+ * the tiled pass records the texture and rectangle operations of a render pass, and when flushed, splits
+ * the damaged area into horizontal bands which are composited in parallel by a pool of worker threads.
+ * Each band executes all operations in the order they were added, so the result is the same as with the
+ * wlroots pass.
+ */
+class pixman_tiled_pass_t
+{
+  public:
+    /**
+     * Create a tiled pass for the given renderer, or return nullptr if tiled rendering should not be used,
+     * i.e the renderer is not a pixman renderer or core/software_render_threads allows only one thread.
+     */
+    static std::unique_ptr<pixman_tiled_pass_t> create(wlr_renderer *renderer);
+
+    /**
+     * Record a texture operation.
+     *
+     * @return false if the operation cannot be executed by the tiled pass, in which case the caller should
+     *   flush the pass and add the operation to the wlroots pass instead.
+     */
+    bool add_texture(const std::shared_ptr<wf::texture_t>& texture, const wlr_render_texture_options& opts);
+
+    /**
+     * Record a rectangle operation.
+     */
+    void add_rect(const wlr_render_rect_options& opts);
+
+    /**
+     * Execute all recorded operations on the target buffer of @pass, which must be a wlroots pixman render
+     * pass. If the image of the target buffer cannot be accessed directly, the operations are added to
+     * @pass instead.
+     */
+    void flush(wlr_render_pass *pass, wlr_renderer *renderer, wlr_buffer *target);
+
+    /** Whether there are recorded operations which have not been flushed yet. */
+    bool has_pending() const;
+
+  private:
+    pixman_tiled_pass_t(int threads);
+
+    struct operation_t
+    {
+        /** The texture to composite, or nullptr for a solid rectangle with @color. */
+        std::shared_ptr<wf::texture_t> texture;
+        wlr_texture *wlr_tex = nullptr;
+        wlr_fbox src_box;
+        wl_output_transform transform = WL_OUTPUT_TRANSFORM_NORMAL;
+        wlr_scale_filter_mode filter  = WLR_SCALE_FILTER_BILINEAR;
+        float alpha = 1.0;
+
+        wlr_render_color color;
+
+        /** The destination box in framebuffer coordinates. */
+        wlr_box dst_box;
+        wlr_render_blend_mode blend_mode;
+        /** The clip region in framebuffer coordinates. */
+        wf::region_t clip;
+
+        /**
+         * The pixels of the texture, prepared on the compositor thread by prepare_sources(). For client
+         * buffers, this is a copy of the part of the texture at (@source_x, @source_y) which is sampled.
+         */
+        pixman_image_t *source = nullptr;
+        int source_x = 0;
+        int source_y = 0;
+    };
+
+    int threads;
+    std::vector<operation_t> ops;
+
+    /**
+     * Access the pixels of all textures in @recorded on the compositor thread. The buffers whose data
+     * pointer was accessed are added to @accessed.
+     *
+     * @return false if the pixels of some texture cannot be accessed.
+     */
+    static bool prepare_sources(std::vector<operation_t>& recorded, wlr_buffer *target,
+        std::vector<wlr_buffer*>& accessed);
+    static void release_sources(std::vector<operation_t>& recorded, std::vector<wlr_buffer*>& accessed);
+    static void flush_to_wlroots(wlr_render_pass *pass, std::vector<operation_t>& recorded);
+};
+}
@@ -2,14 +2,45 @@
 #include <algorithm>
 #include <memory>
 #include <filesystem>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <iterator>
+#include <cstring>
 #include <dlfcn.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "config.h"
 #include "plugin-loader.hpp"
 #include "../core/wm.hpp"
 #include "wayfire/plugin.hpp"
+#include "wayfire/core.hpp"
+#include "wayfire/output.hpp"
+#include "wayfire/startup-timing.hpp"
 #include <wayfire/util/log.hpp>
 
+/**
+ * If no output shows a frame for this long after startup, deferred plugins are initialized anyway
+ * (e.g. when running without outputs).
+ */
+static constexpr uint32_t DEFERRED_INIT_TIMEOUT_MS = 2000;
+
+/**
+ * The name under which a plugin appears in the startup timing report, e.g. expo for /usr/lib/wayfire/libexpo.so.
+ */
+static std::string get_startup_phase_name(const std::string& path)
+{
+    std::string name = std::filesystem::path(path).stem();
+    if (name.rfind("lib", 0) == 0)
+    {
+        name = name.substr(3);
+    }
+
+    return "plugin:" + name;
+}
+
 wf::plugin_manager_t::plugin_manager_t()
 {
     this->plugins_opt.load_option("core/plugins");
@@ -17,12 +48,59 @@ wf::plugin_manager_t::plugin_manager_t()
 
     reload_dynamic_plugins();
     load_static_plugins();
+    initial_load = false;
+    measure_startup = !deferred_plugins.empty();
 
     this->plugins_opt.set_callback([=] ()
     {
         /* reload when config reload has finished */
         idle_reload_plugins.run_once([&] () { reload_dynamic_plugins(); });
     });
+
+    if (!deferred_plugins.empty())
+    {
+        on_frame_done = [=] (wf::frame_done_signal*)
+        {
+            on_frame_done.disconnect();
+            on_output_added.disconnect();
+            // Do not initialize the plugins in the middle of the frame handler.
+            idle_init_deferred.run_once([=] () { init_deferred_plugins(); });
+        };
+
+        on_output_added = [=] (wf::output_added_signal *ev)
+        {
+            ev->output->connect(&on_frame_done);
+        };
+
+        wf::get_core().output_layout->connect(&on_output_added);
+        for (auto& wo : wf::get_core().output_layout->get_outputs())
+        {
+            wo->connect(&on_frame_done);
+        }
+
+        deferred_init_timeout.set_timeout(DEFERRED_INIT_TIMEOUT_MS, [=] () { init_deferred_plugins(); });
+    }
+}
+
+void wf::plugin_manager_t::init_deferred_plugins()
+{
+    on_frame_done.disconnect();
+    on_output_added.disconnect();
+    idle_init_deferred.disconnect();
+    deferred_init_timeout.disconnect();
+    if (deferred_plugins.empty())
+    {
+        return;
+    }
+
+    LOGD("Initializing ", deferred_plugins.size(), " deferred plugins");
+    auto plugins = std::move(deferred_plugins);
+    deferred_plugins.clear();
+
+    wf::startup::begin_phase("deferred-plugins");
+    init_plugins(plugins);
+    wf::startup::end_phase();
+    measure_startup = false;
 }
 
 void wf::plugin_manager_t::deinit_plugins(bool unloadable)
@@ -43,6 +121,18 @@ void wf::plugin_manager_t::deinit_plugins(bool unloadable)
 
 wf::plugin_manager_t::~plugin_manager_t()
 {
+    // Plugins which were never initialized do not need fini()
+    for (auto& [name, plugin] : deferred_plugins)
+    {
+        plugin.instance.reset();
+        if (plugin.so_handle && enable_so_unloading)
+        {
+            dlclose(plugin.so_handle);
+        }
+    }
+
+    deferred_plugins.clear();
+
     /* First remove unloadable plugins, then others */
     deinit_plugins(true);
     deinit_plugins(false);
@@ -79,9 +169,99 @@ void wf::plugin_manager_t::destroy_plugin(wf::loaded_plugin_t& p)
     }
 }
 
-static bool check_plugin_api_version(const std::string& path, bool can_unload_so)
+template<class Ehdr, class Shdr>
+static std::optional<uint32_t> read_abi_section(std::ifstream& file)
+{
+    Ehdr header;
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        (header.e_shentsize != sizeof(Shdr)) || (header.e_shstrndx >= header.e_shnum))
+    {
+        return {};
+    }
+
+    std::vector<Shdr> sections(header.e_shnum);
+    file.seekg(header.e_shoff);
+    if (!file.read(reinterpret_cast<char*>(sections.data()), sizeof(Shdr) * sections.size()))
+    {
+        return {};
+    }
+
+    const auto& strtab = sections[header.e_shstrndx];
+    std::string names(strtab.sh_size, '\0');
+    file.seekg(strtab.sh_offset);
+    if (!file.read(names.data(), names.size()))
+    {
+        return {};
+    }
+
+    for (const auto& section : sections)
+    {
+        if ((section.sh_name >= names.size()) ||
+            strcmp(names.c_str() + section.sh_name, WAYFIRE_PLUGIN_ABI_SECTION) ||
+            (section.sh_size != sizeof(uint32_t)))
+        {
+            continue;
+        }
+
+        uint32_t version;
+        file.seekg(section.sh_offset);
+        if (file.read(reinterpret_cast<char*>(&version), sizeof(version)))
+        {
+            return version;
+        }
+    }
+
+    return {};
+}
+
+std::optional<uint32_t> wf::read_plugin_abi_version(const std::string& path)
 {
-    // First, open everything just locally and in a lazy way.
+    std::ifstream file(path, std::ios::binary);
+    unsigned char ident[EI_NIDENT];
+    if (!file.read(reinterpret_cast<char*>(ident), EI_NIDENT) || memcmp(ident, ELFMAG, SELFMAG))
+    {
+        return {};
+    }
+
+    // The version is stored in the plugin's byte order, which has to match ours for a loadable plugin.
+    const unsigned char host_data = (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) ? ELFDATA2LSB : ELFDATA2MSB;
+    if (ident[EI_DATA] != host_data)
+    {
+        return {};
+    }
+
+    switch (ident[EI_CLASS])
+    {
+      case ELFCLASS64:
+        return read_abi_section<Elf64_Ehdr, Elf64_Shdr>(file);
+
+      case ELFCLASS32:
+        return read_abi_section<Elf32_Ehdr, Elf32_Shdr>(file);
+
+      default:
+        return {};
+    }
+}
+
+static bool check_plugin_api_version(const std::string& path, bool can_unload_so,
+    std::optional<uint32_t> version)
+{
+    // Plugins built against a recent Wayfire store their version in a dedicated section, so we can check it
+    // without loading the plugin at all.
+    if (version)
+    {
+        if (*version != WAYFIRE_API_ABI_VERSION)
+        {
+            LOGE(path, ": API/ABI version mismatch: Wayfire is ",
+                WAYFIRE_API_ABI_VERSION, ",  plugin built with ", *version);
+            return false;
+        }
+
+        return true;
+    }
+
+    // Otherwise, open everything just locally and in a lazy way.
     // We want to check just the API/ABI version.
     // If we load with RTLD_NOW, if the API/ABI version is wrong, we may get a crash just by
     // dlopen()-ing the plugin.
@@ -120,13 +300,11 @@ static bool check_plugin_api_version(const std::string& path, bool can_unload_so
     return true;
 }
 
-std::pair<void*, void*> wf::get_new_instance_handle(const std::string& path, bool can_unload_so)
+/**
+ * dlopen() a plugin whose version has already been checked.
+ */
+static std::pair<void*, void*> open_plugin_handle(const std::string& path)
 {
-    if (!check_plugin_api_version(path, can_unload_so))
-    {
-        return {nullptr, nullptr};
-    }
-
     // RTLD_GLOBAL is required for RTTI/dynamic_cast across plugins
     void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_GLOBAL);
     if (handle == NULL)
@@ -149,9 +327,70 @@ std::pair<void*, void*> wf::get_new_instance_handle(const std::string& path, boo
     return {handle, new_instance_func_ptr};
 }
 
-std::optional<wf::loaded_plugin_t> wf::plugin_manager_t::load_plugin_from_file(std::string path)
+static std::pair<void*, void*> get_instance_handle(const std::string& path, bool can_unload_so,
+    std::optional<uint32_t> version)
 {
-    auto [handle, new_instance_func_ptr] = wf::get_new_instance_handle(path, enable_so_unloading);
+    if (!check_plugin_api_version(path, can_unload_so, version))
+    {
+        return {nullptr, nullptr};
+    }
+
+    return open_plugin_handle(path);
+}
+
+std::pair<void*, void*> wf::get_new_instance_handle(const std::string& path, bool can_unload_so)
+{
+    return get_instance_handle(path, can_unload_so, read_plugin_abi_version(path));
+}
+
+/**
+ * Start reading the plugin files from disk and check their API/ABI versions on worker threads.
+ *
+ * Note that the plugins are not dlopen()-ed on the worker threads: their static initializers may access
+ * compositor state (e.g. global option wrappers), and the dynamic loader serializes most of the work anyway.
+ * What we can parallelize is the disk I/O, so that the following dlopen() calls find the files in the page
+ * cache instead of reading them one after another.
+ *
+ * @return The ABI version of each plugin, as returned by read_plugin_abi_version().
+ */
+static std::vector<std::optional<uint32_t>> prefetch_plugins(const std::vector<std::string>& paths)
+{
+    std::vector<std::optional<uint32_t>> versions(paths.size());
+    std::atomic<size_t> next_idx = 0;
+    const auto& worker = [&] ()
+    {
+        for (size_t i = next_idx++; i < paths.size(); i = next_idx++)
+        {
+            int fd = open(paths[i].c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd >= 0)
+            {
+                posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+                close(fd);
+            }
+
+            versions[i] = wf::read_plugin_abi_version(paths[i]);
+        }
+    };
+
+    const size_t nr_workers = std::min<size_t>(paths.size(), std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < nr_workers; i++)
+    {
+        workers.emplace_back(worker);
+    }
+
+    for (auto& thread : workers)
+    {
+        thread.join();
+    }
+
+    return versions;
+}
+
+std::optional<wf::loaded_plugin_t> wf::plugin_manager_t::load_plugin_from_file(std::string path,
+    std::optional<uint32_t> version)
+{
+    auto [handle, new_instance_func_ptr] = get_instance_handle(path, enable_so_unloading, version);
     if (new_instance_func_ptr)
     {
         auto new_instance_func = union_cast<void*, wayfire_plugin_load_func>(new_instance_func_ptr);
@@ -177,6 +416,8 @@ std::optional<wf::loaded_plugin_t> wf::plugin_manager_t::load_plugin_from_file(s
 
 void wf::plugin_manager_t::reload_dynamic_plugins()
 {
+    // The plugin list changed before the first frame, there is no point in deferring any longer.
+    init_deferred_plugins();
     is_loading = true;
 
     std::string plugin_list = plugins_opt;
@@ -240,29 +481,62 @@ void wf::plugin_manager_t::reload_dynamic_plugins()
     }
 
     /* load new plugins */
-    std::vector<std::pair<std::string, wf::loaded_plugin_t>> pending_initialize;
+    std::vector<std::string> new_plugins;
+    std::copy_if(next_plugins.begin(), next_plugins.end(), std::back_inserter(new_plugins),
+        [&] (const std::string& plugin) { return !loaded_plugins.count(plugin); });
 
-    for (auto plugin : next_plugins)
+    if (measure_startup)
+    {
+        wf::startup::begin_phase("plugin-load");
+    }
+
+    auto versions = prefetch_plugins(new_plugins);
+    std::vector<std::pair<std::string, wf::loaded_plugin_t>> pending_initialize;
+    for (size_t i = 0; i < new_plugins.size(); i++)
     {
-        if (loaded_plugins.count(plugin))
+        std::optional<wf::loaded_plugin_t> ptr = load_plugin_from_file(new_plugins[i], versions[i]);
+        if (!ptr)
         {
             continue;
         }
 
-        std::optional<wf::loaded_plugin_t> ptr = load_plugin_from_file(plugin);
-        if (ptr)
+        if (initial_load && ptr->instance->is_init_deferrable())
         {
-            pending_initialize.emplace_back(plugin, std::move(*ptr));
+            LOGD("Deferring initialization of plugin ", new_plugins[i]);
+            deferred_plugins.emplace_back(new_plugins[i], std::move(*ptr));
+        } else
+        {
+            pending_initialize.emplace_back(new_plugins[i], std::move(*ptr));
         }
     }
 
-    std::stable_sort(pending_initialize.begin(), pending_initialize.end(), [] (const auto& a, const auto& b)
+    if (measure_startup)
+    {
+        wf::startup::end_phase();
+    }
+
+    init_plugins(pending_initialize);
+    is_loading = false;
+}
+
+void wf::plugin_manager_t::init_plugins(std::vector<std::pair<std::string, loaded_plugin_t>>& plugins)
+{
+    const bool was_loading = is_loading;
+    is_loading = true;
+
+    std::stable_sort(plugins.begin(), plugins.end(), [] (const auto& a, const auto& b)
     {
         return a.second.instance->get_order_hint() < b.second.instance->get_order_hint();
     });
 
-    for (auto& [plugin, ptr] : pending_initialize)
+    for (auto& [plugin, ptr] : plugins)
     {
+        std::optional<wf::startup::scoped_phase_t> init_phase;
+        if (measure_startup)
+        {
+            init_phase.emplace(get_startup_phase_name(plugin));
+        }
+
         try {
             ptr.instance->init();
             loaded_plugins[plugin] = std::move(ptr);
@@ -270,11 +544,11 @@ void wf::plugin_manager_t::reload_dynamic_plugins()
         {
             // this will call fini(), the destructor and optionally unload the .so
             destroy_plugin(ptr);
-            LOGE("Failed to init plugin \"", plugin_name, "\". ");
+            LOGE("Failed to init plugin \"", plugin, "\". ");
         }
     }
 
-    is_loading = false;
+    is_loading = was_loading;
 }
 
 template<class T>
@@ -284,6 +558,7 @@ static wf::loaded_plugin_t create_plugin(std::string name)
     lp.instance  = std::make_unique<T>();
     lp.so_handle = nullptr;
     lp.so_path   = name;
+    wf::startup::scoped_phase_t init_phase{"plugin:" + name};
     lp.instance->init();
     return lp;
 }
@@ -5,6 +5,9 @@
 #include "wayfire/plugin.hpp"
 #include "wayfire/util.hpp"
 #include <wayfire/option-wrapper.hpp>
+#include <wayfire/signal-provider.hpp>
+#include <wayfire/output-layout.hpp>
+#include <wayfire/render-manager.hpp>
 
 namespace wf
 {
@@ -37,9 +40,24 @@ struct plugin_manager_t
     wf::option_wrapper_t<bool> enable_so_unloading;
     std::unordered_map<std::string, loaded_plugin_t> loaded_plugins;
 
+    // Plugins whose init() is postponed until the first frame has been shown, see
+    // plugin_interface_t::is_init_deferrable().
+    std::vector<std::pair<std::string, loaded_plugin_t>> deferred_plugins;
+    // Plugin initialization may only be deferred when loading the plugins at startup.
+    bool initial_load = true;
+    wf::wl_idle_call idle_init_deferred;
+    wf::wl_timer<false> deferred_init_timeout;
+    wf::signal::connection_t<wf::frame_done_signal> on_frame_done;
+    wf::signal::connection_t<wf::output_added_signal> on_output_added;
+    // Whether plugin loading is recorded in the startup timing report. True until the plugins from the
+    // initial load (including the deferred ones) are initialized.
+    bool measure_startup = true;
+    void init_deferred_plugins();
+    void init_plugins(std::vector<std::pair<std::string, loaded_plugin_t>>& plugins);
+
     void deinit_plugins(bool unloadable);
 
-    std::optional<loaded_plugin_t> load_plugin_from_file(std::string path);
+    std::optional<loaded_plugin_t> load_plugin_from_file(std::string path, std::optional<uint32_t> version);
     void load_static_plugins();
     void destroy_plugin(loaded_plugin_t& plugin);
 
@@ -59,6 +77,15 @@ B union_cast(A object)
     return helper.y;
 }
 
+/**
+ * Read the API/ABI version stored in the WAYFIRE_PLUGIN_ABI_SECTION of a plugin file without loading it.
+ * This only reads the ELF headers of the file and is therefore safe to call from any thread.
+ *
+ * @return The version, or std::nullopt if the file could not be read or does not have the section (for
+ *   example, because the plugin was built against an older version of Wayfire).
+ */
+std::optional<uint32_t> read_plugin_abi_version(const std::string& path);
+
 /**
  * Open a plugin file and check the file for version errors.
  *
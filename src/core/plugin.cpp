@@ -5,6 +5,7 @@
 #include <wayfire/plugin.hpp>
 #include <libudev.h>
 #include <filesystem>
+#include <set>
 #include <wayfire/plugin.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
 
@@ -142,6 +143,21 @@ std::vector<std::string> wf::config_backend_t::get_xml_dirs() const
     }
 
     xmldirs.push_back(PLUGIN_XML_DIR);
-    return xmldirs;
+
+    // Each directory is parsed in full, so avoid parsing the same metadata twice if a directory is listed
+    // more than once, for example when WAYFIRE_PLUGIN_XML_PATH also contains the default directory.
+    std::vector<std::string> unique_dirs;
+    std::set<std::string> seen;
+    for (auto& dir : xmldirs)
+    {
+        std::error_code ec;
+        auto canonical = fs::weakly_canonical(dir, ec);
+        if (seen.insert(ec ? dir : canonical.string()).second)
+        {
+            unique_dirs.push_back(dir);
+        }
+    }
+
+    return unique_dirs;
 }
 }
@@ -584,7 +584,7 @@ void set_node_enabled(wf::scene::node_ptr node, bool enabled)
     }
 }
 
-void update(node_ptr changed_node, uint32_t flags)
+static void update_from(node_ptr changed_node, uint32_t flags, node_t *source)
 {
     if ((flags & update_flag::CHILDREN_LIST) ||
         (flags & update_flag::ENABLED) ||
@@ -600,8 +600,9 @@ void update(node_ptr changed_node, uint32_t flags)
     }
 
     node_update_signal data;
-    data.node  = changed_node.get();
-    data.flags = flags;
+    data.node   = changed_node.get();
+    data.flags  = flags;
+    data.source = source;
     changed_node->emit(&data);
 
     if (changed_node == wf::get_core().scene())
@@ -620,10 +621,15 @@ void update(node_ptr changed_node, uint32_t flags)
             flags |= update_flag::MASKED;
         }
 
-        update(changed_node->parent()->shared_from_this(), flags);
+        update_from(changed_node->parent()->shared_from_this(), flags, source);
     }
 }
 
+void update(node_ptr changed_node, uint32_t flags)
+{
+    update_from(changed_node, flags, changed_node.get());
+}
+
 floating_inner_node_t::~floating_inner_node_t()
 {
     for (auto& node : this->children)
@@ -666,6 +672,11 @@ render_instance_manager_t::render_instance_manager_t(std::vector<node_ptr> nodes
             }
         }
 
+        if (is_hidden_update(ev->source))
+        {
+            return;
+        }
+
         constexpr uint32_t recompute_instances_on = scene::update_flag::CHILDREN_LIST |
             scene::update_flag::ENABLED;
         constexpr uint32_t recompute_visibility_on = recompute_instances_on | scene::update_flag::GEOMETRY;
@@ -697,6 +708,35 @@ render_instance_manager_t::render_instance_manager_t(std::vector<node_ptr> nodes
     }
 }
 
+bool render_instance_manager_t::is_hidden_update(node_t *source)
+{
+    if (!reference_output)
+    {
+        return false;
+    }
+
+    // Output nodes with a limit region do not generate instances for other outputs (see
+    // output_node_t::gen_render_instances()), so updates below them cannot change our instances or their
+    // visibility. With several outputs, this avoids regenerating the instances of every output whenever
+    // something changes on one of them.
+    for (auto node = source; node; node = node->parent())
+    {
+        if (auto output_node = dynamic_cast<output_node_t*>(node))
+        {
+            return output_node->limit_region && output_node->get_output() &&
+                   (output_node->get_output() != reference_output);
+        }
+
+        if (std::any_of(nodes.begin(), nodes.end(), [&] (const node_ptr& root) { return root.get() == node; }))
+        {
+            // The update is inside the subtree we render, but not below an output node.
+            return false;
+        }
+    }
+
+    return false;
+}
+
 void render_instance_manager_t::regen_instances()
 {
     instances.clear();
@@ -28,6 +28,12 @@ struct wf::bindings_repository_t::impl
 
     void reparse_extensions();
 
+    /**
+     * Check whether a config reload might have changed the value of a registered activator binding. Key,
+     * button and axis bindings read their option when they are matched, so they need no update.
+     */
+    bool activators_changed(const wf::reload_config_signal *ev);
+
     binding_container_t<wf::keybinding_t, key_callback> keys;
     binding_container_t<wf::keybinding_t, axis_callback> axes;
     binding_container_t<wf::buttonbinding_t, button_callback> buttons;
@@ -37,8 +43,11 @@ struct wf::bindings_repository_t::impl
 
     wf::signal::connection_t<wf::reload_config_signal> on_config_reload = [=] (wf::reload_config_signal *ev)
     {
-        recreate_hotspots();
-        reparse_extensions();
+        if (activators_changed(ev))
+        {
+            recreate_hotspots();
+            reparse_extensions();
+        }
     };
 
     wf::wl_idle_call idle_recreate_hotspots;
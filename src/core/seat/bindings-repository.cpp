@@ -1,5 +1,7 @@
 #include <wayfire/core.hpp>
+#include <wayfire/config/config-manager.hpp>
 #include <algorithm>
+#include <set>
 #include "bindings-repository-impl.hpp"
 
 wf::bindings_repository_t::bindings_repository_t()
@@ -275,6 +277,28 @@ void wf::bindings_repository_t::set_enabled(bool enabled)
     priv->recreate_hotspots();
 }
 
+bool wf::bindings_repository_t::impl::activators_changed(const wf::reload_config_signal *ev)
+{
+    if (!ev->changed_options)
+    {
+        return true;
+    }
+
+    std::set<wf::config::option_base_t*> changed;
+    for (auto& name : *ev->changed_options)
+    {
+        if (auto opt = wf::get_core().config->get_option(name))
+        {
+            changed.insert(opt.get());
+        }
+    }
+
+    return std::any_of(activators.begin(), activators.end(), [&] (const auto& binding)
+    {
+        return changed.count(binding->activated_by.get());
+    });
+}
+
 void wf::bindings_repository_t::impl::reparse_extensions()
 {
     for (auto& binding : this->activators)
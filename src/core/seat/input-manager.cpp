@@ -125,8 +125,13 @@ wf::input_manager_t::input_manager_t()
     });
     input_device_created.connect(&wf::get_core().backend->events.new_input);
 
-    config_updated = [=] (auto)
+    config_updated = [=] (wf::reload_config_signal *ev)
     {
+        if (!ev->section_changed("input") && !ev->section_changed("input-device"))
+        {
+            return;
+        }
+
         for (auto& dev : input_devices)
         {
             dev->update_options();
@@ -4,6 +4,7 @@
 #include <wayland-server-protocol.h>
 #include <xkbcommon/xkbcommon.h>
 
+#include <wayfire/alloc-profiling.hpp>
 #include <wayfire/util/log.hpp>
 #include "pointer.hpp"
 #include "keyboard.hpp"
@@ -12,19 +13,26 @@
 #include "input-manager.hpp"
 #include "input-method-relay.hpp"
 #include "seat-impl.hpp"
+#include "keymap-cache.hpp"
 #include "wayfire/signal-definitions.hpp"
 #include <wayfire/config-backend.hpp>
 
 void wf::keyboard_t::setup_listeners()
 {
-    on_config_reload = [=] (auto)
+    on_config_reload = [=] (wf::reload_config_signal *ev)
     {
-        reload_input_options();
+        if (!ev->section_changed("input"))
+        {
+            return;
+        }
+
+        reload_input_options(true);
     };
     wf::get_core().connect(&on_config_reload);
 
     on_key.set_callback([&] (void *data)
     {
+        wf::alloc_profiling::scope_t alloc_scope{"input:key"};
         auto ev    = static_cast<wlr_keyboard_key_event*>(data);
         auto mode  = emit_device_event_signal(ev, &handle->base);
         auto& seat = wf::get_core_impl().seat;
@@ -145,12 +153,12 @@ void wf::keyboard_t::schedule_idle_reload()
 {
     idle_reload_config.run_once([=] ()
     {
-        this->reload_input_options();
+        this->reload_input_options(true);
     });
 }
 
-wf::keyboard_t::keyboard_t(wlr_input_device *dev) :
-    handle(wlr_keyboard_from_input_device(dev)), device(dev)
+wf::keyboard_t::keyboard_t(wlr_input_device *dev, keymap_cache_t *cache) :
+    handle(wlr_keyboard_from_input_device(dev)), device(dev), keymap_cache(cache)
 {
     auto section =
         wf::get_core().config_backend->get_input_device_section("input", dev);
@@ -171,7 +179,7 @@ wf::keyboard_t::keyboard_t(wlr_input_device *dev) :
     repeat_delay.set_callback([=] () { schedule_idle_reload();});
 
     setup_listeners();
-    reload_input_options();
+    reload_input_options(false);
     wlr_seat_set_keyboard(
         wf::get_core().get_current_seat(), wlr_keyboard_from_input_device(dev));
 }
@@ -190,35 +198,32 @@ static void set_locked_mod(xkb_mod_mask_t *mods, xkb_keymap *keymap, const char
     }
 }
 
-void wf::keyboard_t::reload_input_options()
+void wf::keyboard_t::reload_input_options(bool async)
 {
-    auto ctx = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
-
-    /* Copy memory to stack, so that .c_str() is valid */
-    std::string rules   = this->rules;
-    std::string model   = this->model;
-    std::string layout  = this->layout;
-    std::string variant = this->variant;
-    std::string options = this->options;
-
-    xkb_rule_names names;
-    names.rules   = rules.c_str();
-    names.model   = model.c_str();
-    names.layout  = layout.c_str();
-    names.variant = variant.c_str();
-    names.options = options.c_str();
-    auto keymap = xkb_map_new_from_names(ctx, &names,
-        XKB_KEYMAP_COMPILE_NO_FLAGS);
-
-    if (!keymap)
+    wlr_keyboard_set_repeat_info(handle, repeat_rate, repeat_delay);
+
+    keymap_names_t names;
+    names.rules   = this->rules;
+    names.model   = this->model;
+    names.layout  = this->layout;
+    names.variant = this->variant;
+    names.options = this->options;
+
+    if (async)
+    {
+        keymap_cache->get_keymap_async(this, names, [=] (xkb_keymap *keymap) { set_keymap(keymap); });
+    } else
     {
-        LOGE("Could not create keymap with given configuration:",
-            " rules=\"", rules, "\" model=\"", model, "\" layout=\"", layout,
-            "\" variant=\"", variant, "\" options=\"", options, "\"");
+        set_keymap(keymap_cache->get_keymap(names));
+    }
+}
 
-        // reset to NULL
-        std::memset(&names, 0, sizeof(names));
-        keymap = xkb_map_new_from_names(ctx, &names, XKB_KEYMAP_COMPILE_NO_FLAGS);
+void wf::keyboard_t::set_keymap(xkb_keymap *keymap)
+{
+    if (!keymap || (handle->keymap == keymap))
+    {
+        // Keymap is shared with other keyboards and did not change, no need to send it to clients again.
+        return;
     }
 
     xkb_mod_mask_t locked_mods = 0;
@@ -234,16 +239,13 @@ void wf::keyboard_t::reload_input_options()
     }
 
     wlr_keyboard_set_keymap(handle, keymap);
-    xkb_keymap_unref(keymap);
-    xkb_context_unref(ctx);
-
-    wlr_keyboard_set_repeat_info(handle, repeat_rate, repeat_delay);
-
     wlr_keyboard_notify_modifiers(handle, 0, 0, locked_mods, 0);
 }
 
 wf::keyboard_t::~keyboard_t()
-{}
+{
+    keymap_cache->cancel(this);
+}
 
 static bool check_vt_switch(wlr_session *session, uint32_t key, uint32_t mods)
 {
@@ -9,6 +9,8 @@
 
 namespace wf
 {
+class keymap_cache_t;
+
 enum locked_mods_t
 {
     KB_MOD_NUM_LOCK  = 1 << 0,
@@ -21,7 +23,7 @@ enum locked_mods_t
 class keyboard_t
 {
   public:
-    keyboard_t(wlr_input_device *keyboard);
+    keyboard_t(wlr_input_device *keyboard, keymap_cache_t *cache);
     ~keyboard_t();
 
     wlr_keyboard *handle;
@@ -38,13 +40,20 @@ class keyboard_t
 
   private:
     wf::wl_listener_wrapper on_key, on_modifier;
+    keymap_cache_t *keymap_cache;
     wf::wl_idle_call idle_reload_config;
     void schedule_idle_reload();
 
     void setup_listeners();
 
     wf::signal::connection_t<wf::reload_config_signal> on_config_reload;
-    void reload_input_options();
+
+    /**
+     * Apply the keymap and repeat options from the config. If @async is true, the keymap is compiled in the
+     * background if necessary, and the keyboard uses its old keymap in the meantime.
+     */
+    void reload_input_options(bool async);
+    void set_keymap(xkb_keymap *keymap);
 
     wf::option_wrapper_t<std::string> model, variant, layout, options, rules;
     wf::option_wrapper_t<int> repeat_rate, repeat_delay;
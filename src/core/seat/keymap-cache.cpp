@@ -0,0 +1,268 @@
+#include "keymap-cache.hpp"
+
+#include <tuple>
+#include <algorithm>
+#include <chrono>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <wayland-server-core.h>
+
+#include <wayfire/core.hpp>
+#include <wayfire/debug.hpp>
+#include <wayfire/util/log.hpp>
+
+/**
+ * The maximal number of keymaps kept in the cache. Keyboards hold their own reference to the keymap they
+ * use, so evicting a keymap from the cache only means that it has to be compiled again if requested.
+ */
+static constexpr size_t MAX_CACHED_KEYMAPS = 8;
+
+bool wf::keymap_names_t::operator <(const keymap_names_t& other) const
+{
+    return std::tie(rules, model, layout, variant, options) <
+           std::tie(other.rules, other.model, other.layout, other.variant, other.options);
+}
+
+bool wf::keymap_names_t::operator ==(const keymap_names_t& other) const
+{
+    return std::tie(rules, model, layout, variant, options) ==
+           std::tie(other.rules, other.model, other.layout, other.variant, other.options);
+}
+
+static std::string describe(const wf::keymap_names_t& names)
+{
+    return "rules=\"" + names.rules + "\" model=\"" + names.model + "\" layout=\"" + names.layout +
+           "\" variant=\"" + names.variant + "\" options=\"" + names.options + "\"";
+}
+
+/**
+ * Compile a keymap. Does not use any global state, so it can run in any thread as long as @context is not
+ * used concurrently.
+ */
+static xkb_keymap *compile_keymap(xkb_context *context, const wf::keymap_names_t& names)
+{
+    xkb_rule_names rmlvo;
+    rmlvo.rules   = names.rules.c_str();
+    rmlvo.model   = names.model.c_str();
+    rmlvo.layout  = names.layout.c_str();
+    rmlvo.variant = names.variant.c_str();
+    rmlvo.options = names.options.c_str();
+    return xkb_keymap_new_from_names(context, &rmlvo, XKB_KEYMAP_COMPILE_NO_FLAGS);
+}
+
+wf::keymap_cache_t::keymap_cache_t()
+{
+    context   = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+    notify_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (notify_fd < 0)
+    {
+        LOGE("Failed to create eventfd, keymaps will be compiled synchronously.");
+        return;
+    }
+
+    notify_source = wl_event_loop_add_fd(wf::get_core().ev_loop, notify_fd, WL_EVENT_READABLE,
+        handle_compiled, this);
+}
+
+wf::keymap_cache_t::~keymap_cache_t()
+{
+    if (notify_source)
+    {
+        wl_event_source_remove(notify_source);
+    }
+
+    for (auto& [names, future] : compiling)
+    {
+        if (auto keymap = future.get())
+        {
+            xkb_keymap_unref(keymap);
+        }
+    }
+
+    if (notify_fd >= 0)
+    {
+        close(notify_fd);
+    }
+
+    for (auto& [names, entry] : keymaps)
+    {
+        xkb_keymap_unref(entry.keymap);
+    }
+
+    xkb_context_unref(context);
+}
+
+wf::keymap_cache_t::cache_entry_t*wf::keymap_cache_t::find_cached(const keymap_names_t& names)
+{
+    auto it = keymaps.find(names);
+    if (it == keymaps.end())
+    {
+        return nullptr;
+    }
+
+    it->second.last_used = ++use_counter;
+    return &it->second;
+}
+
+xkb_keymap*wf::keymap_cache_t::add_to_cache(const keymap_names_t& names, xkb_keymap *keymap)
+{
+    if (keymap)
+    {
+        LOGC(KBD, "Compiled keymap ", describe(names));
+    } else
+    {
+        LOGE("Could not create keymap with given configuration: ", describe(names));
+
+        // Cache the fallback under the invalid names too, so that they are not compiled again for every new
+        // keyboard and config reload.
+        if (!(names == keymap_names_t{}))
+        {
+            keymap = get_keymap({});
+            if (keymap)
+            {
+                xkb_keymap_ref(keymap);
+            }
+        }
+    }
+
+    if (keymaps.size() >= MAX_CACHED_KEYMAPS)
+    {
+        auto lru = std::min_element(keymaps.begin(), keymaps.end(), [] (const auto& a, const auto& b)
+        {
+            return a.second.last_used < b.second.last_used;
+        });
+
+        xkb_keymap_unref(lru->second.keymap);
+        keymaps.erase(lru);
+    }
+
+    keymaps[names] = cache_entry_t{keymap, ++use_counter};
+    return keymap;
+}
+
+xkb_keymap*wf::keymap_cache_t::get_keymap(const keymap_names_t& names)
+{
+    if (auto entry = find_cached(names))
+    {
+        return entry->keymap;
+    }
+
+    auto it = compiling.find(names);
+    if (it != compiling.end())
+    {
+        // Already being compiled in the background, waiting for it is faster than compiling it again.
+        auto keymap = it->second.get();
+        compiling.erase(it);
+        return add_to_cache(names, keymap);
+    }
+
+    return add_to_cache(names, compile_keymap(context, names));
+}
+
+void wf::keymap_cache_t::get_keymap_async(const void *owner, const keymap_names_t& names,
+    callback_t callback)
+{
+    cancel(owner);
+    if (auto entry = find_cached(names))
+    {
+        callback(entry->keymap);
+        return;
+    }
+
+    if (!notify_source)
+    {
+        callback(get_keymap(names));
+        return;
+    }
+
+    waiting[owner] = {names, std::move(callback)};
+    if (compiling.count(names))
+    {
+        return;
+    }
+
+    compiling[names] = std::async(std::launch::async, [names, fd = notify_fd] ()
+    {
+        // xkb contexts are not thread-safe, so use a separate one.
+        auto context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+        auto keymap  = compile_keymap(context, names);
+        xkb_context_unref(context);
+
+        // Can fail only if the counter overflows, in which case the event loop is woken up anyway.
+        uint64_t done = 1;
+        ssize_t written = write(fd, &done, sizeof(done));
+        (void)written;
+
+        return keymap;
+    });
+}
+
+void wf::keymap_cache_t::cancel(const void *owner)
+{
+    waiting.erase(owner);
+}
+
+int wf::keymap_cache_t::handle_compiled(int fd, uint32_t mask, void *data)
+{
+    uint64_t count;
+    if (read(fd, &count, sizeof(count)) < 0)
+    {
+        return 0;
+    }
+
+    static_cast<keymap_cache_t*>(data)->dispatch_compiled();
+    return 0;
+}
+
+void wf::keymap_cache_t::dispatch_compiled()
+{
+    // Hold a reference to the results until the callbacks are done, in case they are evicted in the meantime.
+    std::map<keymap_names_t, xkb_keymap*> compiled;
+    for (auto it = compiling.begin(); it != compiling.end();)
+    {
+        if (it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            if (auto keymap = add_to_cache(it->first, it->second.get()))
+            {
+                compiled[it->first] = xkb_keymap_ref(keymap);
+            }
+
+            it = compiling.erase(it);
+        } else
+        {
+            ++it;
+        }
+    }
+
+    // The callbacks may issue new requests, so collect the ready ones first.
+    std::vector<std::pair<xkb_keymap*, callback_t>> ready;
+    for (auto it = waiting.begin(); it != waiting.end();)
+    {
+        if (compiling.count(it->second.first))
+        {
+            ++it;
+            continue;
+        }
+
+        // The keymap may also have been compiled by a synchronous get_keymap() call in the meantime.
+        const auto& names = it->second.first;
+        if (!compiled.count(names))
+        {
+            auto entry = find_cached(names);
+            compiled[names] = (entry && entry->keymap) ? xkb_keymap_ref(entry->keymap) : nullptr;
+        }
+
+        ready.emplace_back(compiled[names], std::move(it->second.second));
+        it = waiting.erase(it);
+    }
+
+    for (auto& [keymap, callback] : ready)
+    {
+        callback(keymap);
+    }
+
+    for (auto& [names, keymap] : compiled)
+    {
+        xkb_keymap_unref(keymap);
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <vector>
+#include <future>
+#include <functional>
+#include <xkbcommon/xkbcommon.h>
+
+struct wl_event_source;
+
+namespace wf
+{
+/**
+ * The RMLVO names from which a keymap is compiled.
+ */
+struct keymap_names_t
+{
+    std::string rules;
+    std::string model;
+    std::string layout;
+    std::string variant;
+    std::string options;
+
+    bool operator <(const keymap_names_t& other) const;
+    bool operator ==(const keymap_names_t& other) const;
+};
+
+/**
+ * Keymap compilation is slow (tens of milliseconds), and typically all keyboards use the same configuration.
+ * The keymap cache compiles each configuration once and shares the resulting keymap between all keyboards.
+ *
+ * Setting the same xkb_keymap on a wlr_keyboard which already uses it is a no-op in keyboard_t, so keyboards
+ * which share a keymap also skip re-serializing it for clients on config reload.
+ */
+class keymap_cache_t
+{
+  public:
+    keymap_cache_t();
+    ~keymap_cache_t();
+
+    keymap_cache_t(const keymap_cache_t&) = delete;
+    keymap_cache_t(keymap_cache_t&&) = delete;
+    keymap_cache_t& operator =(const keymap_cache_t&) = delete;
+    keymap_cache_t& operator =(keymap_cache_t&&) = delete;
+
+    using callback_t = std::function<void (xkb_keymap*)>;
+
+    /**
+     * Get the keymap for the given names, compiling it if necessary.
+     *
+     * If the names are invalid, the default keymap is returned instead, and the failure is cached like a
+     * keymap. The returned keymap is owned by the cache and must be referenced by the caller if it is to be
+     * kept.
+     */
+    xkb_keymap *get_keymap(const keymap_names_t& names);
+
+    /**
+     * Like get_keymap(), but if the keymap has to be compiled, compile it in a background thread and call
+     * @callback from the event loop once it is ready. Otherwise, @callback is called immediately.
+     *
+     * Only the last request of each @owner is kept: a new request or cancel() discards a pending one.
+     */
+    void get_keymap_async(const void *owner, const keymap_names_t& names, callback_t callback);
+
+    /** Discard a pending request from get_keymap_async(). */
+    void cancel(const void *owner);
+
+  private:
+    struct cache_entry_t
+    {
+        // The compiled keymap, or the fallback keymap if the names are invalid. nullptr only if the default
+        // keymap could not be compiled either.
+        xkb_keymap *keymap;
+        uint64_t last_used;
+    };
+
+    xkb_context *context;
+    std::map<keymap_names_t, cache_entry_t> keymaps;
+    uint64_t use_counter = 0;
+
+    std::map<keymap_names_t, std::future<xkb_keymap*>> compiling;
+    std::map<const void*, std::pair<keymap_names_t, callback_t>> waiting;
+
+    int notify_fd = -1;
+    wl_event_source *notify_source = nullptr;
+    static int handle_compiled(int fd, uint32_t mask, void *data);
+    void dispatch_compiled();
+
+    /** Add a compiled keymap (or nullptr, if compilation failed) to the cache and return the keymap to use. */
+    xkb_keymap *add_to_cache(const keymap_names_t& names, xkb_keymap *keymap);
+    cache_entry_t *find_cached(const keymap_names_t& names);
+};
+}
@@ -6,6 +6,7 @@
 #include "wayfire/scene.hpp"
 #include "wayfire/signal-definitions.hpp"
 
+#include <wayfire/alloc-profiling.hpp>
 #include <wayfire/debug.hpp>
 #include <wayfire/util/log.hpp>
 #include <wayfire/core.hpp>
@@ -70,6 +71,7 @@ bool wf::pointer_t::focus_enabled() const
 
 void wf::pointer_t::update_cursor_position(int64_t time_msec)
 {
+    wf::alloc_profiling::scope_t alloc_scope{"input:pointer-motion"};
     wf::pointf_t gc   = seat->priv->cursor->get_cursor_position();
     const auto& scene = wf::get_core().scene();
     auto isec    = scene->find_node_at(gc);
@@ -280,6 +282,7 @@ wf::input_grab_kind_t wf::pointer_t::get_current_grab_kind() const
 void wf::pointer_t::handle_pointer_button(wlr_pointer_button_event *ev,
     input_event_processing_mode_t mode)
 {
+    wf::alloc_profiling::scope_t alloc_scope{"input:pointer-button"};
     seat->priv->break_mod_bindings();
     bool handled_in_binding = (mode != input_event_processing_mode_t::FULL);
 
@@ -417,6 +420,7 @@ void wf::pointer_t::handle_pointer_motion_absolute(
 void wf::pointer_t::handle_pointer_axis(wlr_pointer_axis_event *ev,
     input_event_processing_mode_t mode)
 {
+    wf::alloc_profiling::scope_t alloc_scope{"input:pointer-axis"};
     bool handled_in_binding = wf::get_core().bindings->handle_axis(
         seat->priv->get_modifiers(), ev);
     seat->priv->break_mod_bindings();
@@ -18,6 +18,7 @@ namespace wf
 {
 struct cursor_t;
 class keyboard_t;
+class keymap_cache_t;
 
 class input_device_impl_t : public wf::input_device_t
 {
@@ -113,6 +114,9 @@ struct seat_t::impl
     wf::signal::connection_t<wf::input_device_added_signal> on_new_device;
     wf::signal::connection_t<wf::input_device_removed_signal> on_remove_device;
 
+    /** Compiled keymaps shared by the keyboards, must outlive them */
+    std::unique_ptr<wf::keymap_cache_t> keymap_cache;
+
     /** A list of all keyboards in this seat */
     std::vector<std::unique_ptr<wf::keyboard_t>> keyboards;
 
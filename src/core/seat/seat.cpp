@@ -5,6 +5,7 @@
 #include "../core-impl.hpp"
 #include "../view/view-impl.hpp"
 #include "keyboard.hpp"
+#include "keymap-cache.hpp"
 #include "pointer.hpp"
 #include "touch.hpp"
 #include "tablet.hpp"
@@ -264,6 +265,7 @@ wf::seat_t::seat_t(wl_display *display, std::string name) : seat(wlr_seat_create
 {
     priv = std::make_unique<impl>();
     priv->seat     = seat;
+    priv->keymap_cache = std::make_unique<wf::keymap_cache_t>();
     priv->cursor   = std::make_unique<wf::cursor_t>(this);
     priv->lpointer = std::make_unique<wf::pointer_t>(
         wf::get_core_impl().input, nonstd::make_observer(this));
@@ -349,7 +351,7 @@ wf::seat_t::seat_t(wl_display *display, std::string name) : seat(wlr_seat_create
         {
           case WLR_INPUT_DEVICE_KEYBOARD:
             this->priv->keyboards.emplace_back(std::make_unique<wf::keyboard_t>(
-                ev->device->get_wlr_handle()));
+                ev->device->get_wlr_handle(), priv->keymap_cache.get()));
             if (this->priv->current_keyboard == nullptr)
             {
                 priv->set_keyboard(priv->keyboards.back().get());
@@ -0,0 +1,239 @@
+#include "spawn.hpp"
+#include <wayfire/core.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/util/log.hpp>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+static int pidfd_open(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+wf::process_spawner_t::process_spawner_t(wl_event_loop *loop)
+{
+    this->loop = loop;
+}
+
+wf::process_spawner_t::~process_spawner_t()
+{
+    // The children which are still running are reparented to init (or the nearest subreaper) when the
+    // compositor exits, so there is nothing to do for them.
+    for (auto& [_, child] : children)
+    {
+        if (child->source)
+        {
+            wl_event_source_remove(child->source);
+        }
+
+        if (child->pidfd >= 0)
+        {
+            close(child->pidfd);
+        }
+    }
+}
+
+pid_t wf::process_spawner_t::spawn(const spawn_params_t& params)
+{
+    // Build the environment of the new process: the compositor's own environment, with the given variables
+    // replacing any existing values.
+    std::vector<std::string> env_storage;
+    for (char **var = environ; var && *var; var++)
+    {
+        std::string_view entry = *var;
+        std::string_view key   = entry.substr(0, entry.find('='));
+        bool overridden = false;
+        for (auto& [name, _] : params.env)
+        {
+            overridden |= (key == name);
+        }
+
+        if (!overridden)
+        {
+            env_storage.emplace_back(entry);
+        }
+    }
+
+    for (auto& [name, value] : params.env)
+    {
+        env_storage.push_back(name + "=" + value);
+    }
+
+    std::vector<char*> envp;
+    for (auto& entry : env_storage)
+    {
+        envp.push_back(entry.data());
+    }
+
+    envp.push_back(nullptr);
+
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    if (params.discard_output)
+    {
+        posix_spawn_file_actions_addopen(&file_actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        posix_spawn_file_actions_adddup2(&file_actions, STDOUT_FILENO, STDERR_FILENO);
+    }
+
+    // Clients should not inherit the signal mask of the compositor or its ignored SIGPIPE.
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask, defaults;
+    sigemptyset(&mask);
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    // The compositor raises its own RLIMIT_NOFILE, but clients should get the original limit. Changing the
+    // limit of the compositor around posix_spawn() would affect its other threads too. Instead, a wrapper
+    // shell lowers the limit for itself and then execs `/bin/sh -c command`, so the command is run exactly
+    // as without the wrapper, in the same process.
+    std::vector<std::string> args = {"/bin/sh", "-c", params.command};
+    struct rlimit current;
+    if (params.nofile_limit && (getrlimit(RLIMIT_NOFILE, &current) == 0) &&
+        (current.rlim_cur != params.nofile_limit->rlim_cur))
+    {
+        const std::string limit = (params.nofile_limit->rlim_cur == RLIM_INFINITY) ?
+            "unlimited" : std::to_string(params.nofile_limit->rlim_cur);
+        args = {"/bin/sh", "-c", "ulimit -S -n " + limit + " 2>/dev/null; exec /bin/sh -c \"$1\"", "sh",
+            params.command};
+    }
+
+    std::vector<char*> argv;
+    for (auto& arg : args)
+    {
+        argv.push_back(arg.data());
+    }
+
+    argv.push_back(nullptr);
+
+    pid_t pid = 0;
+    int ret = posix_spawn(&pid, "/bin/sh", &file_actions, &attr, argv.data(), envp.data());
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&file_actions);
+
+    if (ret != 0)
+    {
+        LOGE("Failed to start \"", params.command, "\": ", strerror(ret));
+        return 0;
+    }
+
+    track_child(pid);
+    return pid;
+}
+
+void wf::process_spawner_t::track_child(pid_t pid)
+{
+    auto child = std::make_unique<child_t>();
+    child->self = this;
+    child->pid  = pid;
+
+    // The child cannot be reaped before we do it, so the PID is still valid even if it has already exited.
+    child->pidfd = pidfd_open(pid);
+    if (child->pidfd >= 0)
+    {
+        fcntl(child->pidfd, F_SETFD, FD_CLOEXEC);
+        child->source = wl_event_loop_add_fd(loop, child->pidfd, WL_EVENT_READABLE, handle_pidfd,
+            child.get());
+    } else
+    {
+        LOGD("pidfd_open() failed for PID ", pid, ": ", strerror(errno), ", polling for its exit instead.");
+        if (!poll_timer.is_connected())
+        {
+            static constexpr uint32_t POLL_INTERVAL_MS = 1000;
+            poll_timer.set_timeout(POLL_INTERVAL_MS, [=] ()
+            {
+                return poll_children();
+            });
+        }
+    }
+
+    children[pid] = std::move(child);
+}
+
+int wf::process_spawner_t::handle_pidfd(int fd, uint32_t mask, void *data)
+{
+    auto child = (child_t*)data;
+    int status = 0;
+    pid_t ret  = waitpid(child->pid, &status, WNOHANG);
+    if (ret == child->pid)
+    {
+        child->self->reap_child(child->pid, status);
+    } else if ((ret == -1) || (mask & (WL_EVENT_HANGUP | WL_EVENT_ERROR)))
+    {
+        // The child was reaped by someone else (for example a plugin calling waitpid(-1)).
+        child->self->reap_child(child->pid, 0);
+    }
+
+    return 0;
+}
+
+bool wf::process_spawner_t::poll_children()
+{
+    std::vector<std::pair<pid_t, int>> exited;
+    for (auto& [pid, child] : children)
+    {
+        int status = 0;
+        if ((child->pidfd < 0) && (waitpid(pid, &status, WNOHANG) != 0))
+        {
+            exited.push_back({pid, status});
+        }
+    }
+
+    for (auto& [pid, status] : exited)
+    {
+        reap_child(pid, status);
+    }
+
+    bool any_polled = false;
+    for (auto& [_, child] : children)
+    {
+        any_polled |= (child->pidfd < 0);
+    }
+
+    return any_polled;
+}
+
+void wf::process_spawner_t::reap_child(pid_t pid, int status)
+{
+    auto it = children.find(pid);
+    if (it == children.end())
+    {
+        return;
+    }
+
+    if (it->second->source)
+    {
+        wl_event_source_remove(it->second->source);
+    }
+
+    if (it->second->pidfd >= 0)
+    {
+        close(it->second->pidfd);
+    }
+
+    children.erase(it);
+
+    LOGD("Process ", pid, " exited with status ", status);
+    wf::command_exited_signal ev;
+    ev.pid    = pid;
+    ev.status = status;
+    wf::get_core().emit(&ev);
+}
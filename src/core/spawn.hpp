@@ -0,0 +1,70 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <wayland-server-core.h>
+#include <wayfire/util.hpp>
+
+namespace wf
+{
+/**
+ * Starts client processes for compositor_core_t::run().
+ *
+ * Processes are started with posix_spawn(), which uses vfork semantics on Linux, so the (potentially very
+ * large) address space of the compositor is never copied, and the main loop is blocked only until the
+ * shell has been executed.
+ *
+ * The started processes are children of the compositor. They are reaped from the event loop as soon as
+ * they exit, using a pidfd for each child, and command_exited_signal is emitted on core.
+ */
+class process_spawner_t
+{
+  public:
+    process_spawner_t(wl_event_loop *loop);
+    ~process_spawner_t();
+
+    struct spawn_params_t
+    {
+        std::string command;
+        // Variables to set in the environment of the new process, in addition to the compositor's.
+        std::vector<std::pair<std::string, std::string>> env;
+        // Redirect stdout and stderr to /dev/null.
+        bool discard_output = false;
+        // The RLIMIT_NOFILE limit to give the new process, if different from the compositor's.
+        const struct rlimit *nofile_limit = nullptr;
+    };
+
+    /**
+     * Start `/bin/sh -c command`. If a RLIMIT_NOFILE limit is given, a wrapper shell sets it and then execs
+     * `/bin/sh -c command` in the same process.
+     *
+     * @return The PID of the new process, or 0 on failure.
+     */
+    pid_t spawn(const spawn_params_t& params);
+
+  private:
+    struct child_t
+    {
+        process_spawner_t *self;
+        pid_t pid;
+        int pidfd = -1;
+        wl_event_source *source = nullptr;
+    };
+
+    wl_event_loop *loop;
+    std::map<pid_t, std::unique_ptr<child_t>> children;
+
+    // Used only when pidfds are not supported by the kernel.
+    wf::wl_timer<true> poll_timer;
+    // Reap the polled children which have exited, returns whether there are polled children left.
+    bool poll_children();
+
+    void track_child(pid_t pid);
+    void reap_child(pid_t pid, int status);
+    static int handle_pidfd(int fd, uint32_t mask, void *data);
+};
+}
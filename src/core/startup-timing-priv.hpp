@@ -0,0 +1,15 @@
+#pragma once
+
+#include <wayfire/startup-timing.hpp>
+
+namespace wf
+{
+namespace startup
+{
+/**
+ * Record the time to the first frame shown on any output and log a summary of all startup phases when it
+ * happens. Called by core at the end of post_init().
+ */
+void report_on_first_frame();
+}
+}
@@ -0,0 +1,173 @@
+#include <wayfire/startup-timing.hpp>
+#include <wayfire/core.hpp>
+#include <wayfire/debug.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/output-layout.hpp>
+#include <wayfire/render-manager.hpp>
+#include <wayfire/util/log.hpp>
+#include <map>
+
+#include "startup-timing-priv.hpp"
+
+namespace
+{
+struct startup_state_t
+{
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    std::vector<wf::startup::phase_t> phases;
+    // Indices into phases of the currently running phases, innermost last.
+    std::vector<size_t> running;
+    // Indices into phases of the currently running asynchronous phases.
+    std::map<std::string, size_t> running_async;
+    std::optional<std::chrono::microseconds> first_frame;
+
+    wf::signal::connection_t<wf::frame_done_signal> on_frame_done;
+    wf::signal::connection_t<wf::output_added_signal> on_output_added;
+};
+
+startup_state_t& get_state()
+{
+    // The first call happens at the very start of main(), which makes it the origin of all timestamps.
+    static startup_state_t state;
+    return state;
+}
+
+std::chrono::microseconds time_since_start()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - get_state().origin);
+}
+
+double to_ms(std::chrono::microseconds us)
+{
+    return us.count() / 1000.0;
+}
+
+void log_summary()
+{
+    auto& state = get_state();
+    LOGI("Startup finished, first frame shown after ", to_ms(*state.first_frame), "ms");
+    for (auto& phase : state.phases)
+    {
+        std::string indent(2 * phase.depth, ' ');
+        if (phase.finished)
+        {
+            LOGC(STARTUP, indent, phase.name, ": started at ", to_ms(phase.start),
+                "ms, took ", to_ms(phase.duration), "ms");
+        } else
+        {
+            LOGC(STARTUP, indent, phase.name, ": started at ", to_ms(phase.start), "ms, still running");
+        }
+    }
+}
+}
+
+void wf::startup::begin_phase(std::string name)
+{
+    auto& state = get_state();
+    phase_t phase;
+    phase.name  = std::move(name);
+    phase.depth = (int)state.running.size();
+    phase.start = time_since_start();
+
+    state.running.push_back(state.phases.size());
+    state.phases.push_back(std::move(phase));
+}
+
+void wf::startup::end_phase()
+{
+    auto& state = get_state();
+    if (state.running.empty())
+    {
+        LOGE("Ending a startup phase, but no phase is running!");
+        return;
+    }
+
+    auto& phase = state.phases[state.running.back()];
+    state.running.pop_back();
+    phase.duration = time_since_start() - phase.start;
+    phase.finished = true;
+}
+
+void wf::startup::begin_async_phase(std::string name)
+{
+    auto& state = get_state();
+    phase_t phase;
+    phase.name  = name;
+    phase.depth = (int)state.running.size();
+    phase.start = time_since_start();
+
+    state.running_async[std::move(name)] = state.phases.size();
+    state.phases.push_back(std::move(phase));
+}
+
+void wf::startup::end_async_phase(const std::string& name)
+{
+    auto& state = get_state();
+    auto it = state.running_async.find(name);
+    if (it == state.running_async.end())
+    {
+        LOGE("Ending startup phase ", name, ", but it is not running!");
+        return;
+    }
+
+    auto& phase = state.phases[it->second];
+    state.running_async.erase(it);
+    phase.duration = time_since_start() - phase.start;
+    phase.finished = true;
+}
+
+void wf::startup::mark(std::string name)
+{
+    auto& state = get_state();
+    phase_t phase;
+    phase.name     = std::move(name);
+    phase.depth    = (int)state.running.size();
+    phase.start    = time_since_start();
+    phase.finished = true;
+    state.phases.push_back(std::move(phase));
+}
+
+wf::startup::scoped_phase_t::scoped_phase_t(std::string name)
+{
+    begin_phase(std::move(name));
+}
+
+wf::startup::scoped_phase_t::~scoped_phase_t()
+{
+    end_phase();
+}
+
+const std::vector<wf::startup::phase_t>& wf::startup::get_phases()
+{
+    return get_state().phases;
+}
+
+std::optional<std::chrono::microseconds> wf::startup::get_time_to_first_frame()
+{
+    return get_state().first_frame;
+}
+
+void wf::startup::report_on_first_frame()
+{
+    auto& state = get_state();
+    state.on_frame_done = [&state] (wf::frame_done_signal*)
+    {
+        state.on_frame_done.disconnect();
+        state.on_output_added.disconnect();
+        state.first_frame = time_since_start();
+        mark("first-frame");
+        log_summary();
+    };
+
+    state.on_output_added = [&state] (wf::output_added_signal *ev)
+    {
+        ev->output->connect(&state.on_frame_done);
+    };
+
+    wf::get_core().output_layout->connect(&state.on_output_added);
+    for (auto& wo : wf::get_core().output_layout->get_outputs())
+    {
+        wo->connect(&state.on_frame_done);
+    }
+}
@@ -0,0 +1,305 @@
+#include "toplevel-capture.hpp"
+
+#include <cstdlib>
+#include <ctime>
+#include <sys/stat.h>
+#include <drm_fourcc.h>
+
+#include <wayfire/core.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/render.hpp>
+#include <wayfire/scene-operations.hpp>
+#include <wayfire/util/log.hpp>
+#include "ext-image-copy-capture-v1-protocol.h"
+
+extern "C"
+{
+#include <wlr/types/wlr_ext_foreign_toplevel_list_v1.h>
+}
+
+namespace wf
+{
+/**
+ * The wlroots source object, together with a pointer back to the Wayfire source.
+ * Since the source is the first member, the source pointers passed to the callbacks can be cast back.
+ */
+struct capture_source_handle_t
+{
+    wlr_ext_image_capture_source_v1 base;
+    toplevel_capture_source_t *self;
+};
+
+class toplevel_capture_source_t
+{
+  public:
+    toplevel_capture_source_t(wf::view_interface_t *view) : view(view->shared_from_this())
+    {
+        handle.self = this;
+        wlr_ext_image_capture_source_v1_init(&handle.base, &source_impl);
+
+        // Clients receive the buffer constraints as soon as they start a session, so we need a buffer with
+        // the right size and format already.
+        update_buffer();
+    }
+
+    ~toplevel_capture_source_t()
+    {
+        wlr_ext_image_capture_source_v1_finish(&handle.base);
+    }
+
+    wlr_ext_image_capture_source_v1 *get_source()
+    {
+        return &handle.base;
+    }
+
+  private:
+    capture_source_handle_t handle;
+    std::shared_ptr<wf::view_interface_t> view;
+
+    int active_sessions = 0;
+    std::unique_ptr<wf::scene::render_instance_manager_t> instances;
+
+    wf::auxilliary_buffer_t buffer;
+    wf::geometry_t last_bbox = {0, 0, 0, 0};
+    float last_scale = 0.0;
+
+    /** Damage since the last frame, in the same coordinates as the view's surface root node. */
+    wf::region_t pending_damage;
+    bool frame_requested = false;
+    wf::wl_idle_call idle_send_frame;
+
+    static toplevel_capture_source_t *from_source(wlr_ext_image_capture_source_v1 *source)
+    {
+        return reinterpret_cast<capture_source_handle_t*>(source)->self;
+    }
+
+    static void handle_start(wlr_ext_image_capture_source_v1 *source, bool with_cursors)
+    {
+        auto self = from_source(source);
+        if (self->active_sessions++ == 0)
+        {
+            self->instances = std::make_unique<wf::scene::render_instance_manager_t>(
+                std::vector<wf::scene::node_ptr>{self->view->get_surface_root_node()},
+                [self] (const wf::region_t& damage) { self->add_damage(damage); },
+                self->view->get_output());
+
+            // The buffer contents are stale, because we did not track damage while nobody was capturing.
+            self->pending_damage |= self->last_bbox;
+        }
+    }
+
+    static void handle_stop(wlr_ext_image_capture_source_v1 *source)
+    {
+        auto self = from_source(source);
+        if (--self->active_sessions == 0)
+        {
+            self->instances.reset();
+            self->idle_send_frame.disconnect();
+            self->frame_requested = false;
+        }
+    }
+
+    static void handle_schedule_frame(wlr_ext_image_capture_source_v1 *source)
+    {
+        auto self = from_source(source);
+        self->frame_requested = true;
+        if (!self->pending_damage.empty())
+        {
+            self->schedule_send_frame();
+        }
+    }
+
+    static void handle_copy_frame(wlr_ext_image_capture_source_v1 *source,
+        wlr_ext_image_copy_capture_frame_v1 *frame, wlr_ext_image_capture_source_v1_frame_event *event)
+    {
+        auto self = from_source(source);
+        if (!self->buffer.get_buffer())
+        {
+            wlr_ext_image_copy_capture_frame_v1_fail(frame,
+                EXT_IMAGE_COPY_CAPTURE_FRAME_V1_FAILURE_REASON_UNKNOWN);
+            return;
+        }
+
+        // The helper fails the frame itself if copying is not possible.
+        if (wlr_ext_image_copy_capture_frame_v1_copy_buffer(frame, self->buffer.get_buffer(),
+            wf::get_core().renderer))
+        {
+            timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            wlr_ext_image_copy_capture_frame_v1_ready(frame, WL_OUTPUT_TRANSFORM_NORMAL, &now);
+        }
+    }
+
+    static constexpr wlr_ext_image_capture_source_v1_interface source_impl = {
+        .start = handle_start,
+        .stop  = handle_stop,
+        .schedule_frame = handle_schedule_frame,
+        .copy_frame     = handle_copy_frame,
+    };
+
+    void add_damage(const wf::region_t& damage)
+    {
+        pending_damage |= damage;
+        if (frame_requested)
+        {
+            schedule_send_frame();
+        }
+    }
+
+    void schedule_send_frame()
+    {
+        // Coalesce damage from all surfaces of the view which commit in the same event loop iteration.
+        idle_send_frame.run_once([=] () { send_frame(); });
+    }
+
+    float get_scale()
+    {
+        auto output = view->get_output();
+        return output ? output->handle->scale : 1.0;
+    }
+
+    /**
+     * Make sure the buffer matches the current size of the view.
+     * If the buffer is reallocated, the buffer constraints are sent again and the whole view is damaged.
+     */
+    bool update_buffer()
+    {
+        auto bbox  = view->get_surface_root_node()->get_bounding_box();
+        auto scale = get_scale();
+        if ((bbox == last_bbox) && (scale == last_scale) && buffer.get_buffer())
+        {
+            return true;
+        }
+
+        auto result = buffer.allocate(wf::dimensions(bbox), scale);
+        if (result == wf::buffer_reallocation_result_t::FAILED)
+        {
+            return false;
+        }
+
+        // Damage is relative to the view's position, so a move invalidates everything too.
+        pending_damage |= bbox;
+        last_bbox  = bbox;
+        last_scale = scale;
+
+        if (result == wf::buffer_reallocation_result_t::REALLOCATED)
+        {
+            update_constraints();
+        }
+
+        return true;
+    }
+
+    void update_constraints()
+    {
+        auto source = &handle.base;
+        auto size   = buffer.get_size();
+        source->width  = size.width;
+        source->height = size.height;
+
+        free(source->shm_formats);
+        source->shm_formats     = nullptr;
+        source->shm_formats_len = 0;
+        uint32_t shm_format = wlr_texture_preferred_read_format(buffer.get_texture());
+        if (shm_format != DRM_FORMAT_INVALID)
+        {
+            source->shm_formats    = (uint32_t*)calloc(1, sizeof(uint32_t));
+            source->shm_formats[0] = shm_format;
+            source->shm_formats_len = 1;
+        }
+
+        wlr_drm_format_set_finish(&source->dmabuf_formats);
+        source->dmabuf_formats = {};
+
+        wlr_dmabuf_attributes attribs;
+        struct stat dev_stat;
+        int drm_fd = wlr_renderer_get_drm_fd(wf::get_core().renderer);
+        if ((drm_fd >= 0) && (fstat(drm_fd, &dev_stat) == 0) &&
+            wlr_buffer_get_dmabuf(buffer.get_buffer(), &attribs))
+        {
+            source->dmabuf_device = dev_stat.st_rdev;
+            wlr_drm_format_set_add(&source->dmabuf_formats, attribs.format, attribs.modifier);
+        }
+
+        wl_signal_emit_mutable(&source->events.constraints_update, NULL);
+    }
+
+    void send_frame()
+    {
+        if (!instances || !frame_requested || !update_buffer())
+        {
+            return;
+        }
+
+        wf::render_target_t target{buffer};
+        target.geometry = last_bbox;
+        target.scale    = last_scale;
+        // Clients expect the usual sRGB-encoded pixels, not the linear encoding of auxiliary buffers.
+        target.set_color_transform(nullptr, WLR_COLOR_TRANSFER_FUNCTION_SRGB);
+
+        wf::render_pass_params_t params;
+        params.background_color = {0, 0, 0, 0};
+        params.damage    = pending_damage & last_bbox;
+        params.target    = target;
+        params.instances = &instances->get_instances();
+        params.flags     = wf::RPASS_CLEAR_BACKGROUND;
+        wf::render_pass_t::run(params);
+
+        wf::region_t buffer_damage = target.framebuffer_region_from_geometry_region(params.damage);
+        pending_damage.clear();
+        frame_requested = false;
+
+        wlr_ext_image_capture_source_v1_frame_event event = {
+            .damage = buffer_damage.to_pixman(),
+        };
+        wl_signal_emit_mutable(&handle.base.events.frame, &event);
+
+        // Views which are not visible on any output do not get frame events from the outputs, so let them
+        // draw the next frame for the capture.
+        if (auto surface = view->get_wlr_surface())
+        {
+            wlr_surface_for_each_surface(surface, [] (wlr_surface *surface, int, int, void*)
+            {
+                timespec now;
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                wlr_surface_send_frame_done(surface, &now);
+            }, nullptr);
+        }
+    }
+};
+}
+
+wf::toplevel_capture_manager_t::toplevel_capture_manager_t(
+    wlr_ext_foreign_toplevel_image_capture_source_manager_v1 *manager)
+{
+    on_new_request.set_callback([=] (void *data)
+    {
+        auto request =
+            static_cast<wlr_ext_foreign_toplevel_image_capture_source_manager_v1_request*>(data);
+
+        // Set by the foreign toplevel list protocol implementation.
+        auto view = static_cast<wf::view_interface_t*>(request->toplevel_handle->data);
+        if (!view || !view->is_mapped())
+        {
+            LOGW("Cannot capture foreign toplevel without a mapped view!");
+            return;
+        }
+
+        auto& source = sources[view];
+        if (!source)
+        {
+            source = std::make_unique<toplevel_capture_source_t>(view);
+        }
+
+        wlr_ext_foreign_toplevel_image_capture_source_manager_v1_request_accept(request, source->get_source());
+    });
+    on_new_request.connect(&manager->events.new_request);
+
+    on_view_unmapped = [=] (wf::view_unmapped_signal *ev)
+    {
+        sources.erase(ev->view.get());
+    };
+    wf::get_core().connect(&on_view_unmapped);
+}
+
+wf::toplevel_capture_manager_t::~toplevel_capture_manager_t() = default;
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <wayfire/nonstd/wlroots-full.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/util.hpp>
+#include <wayfire/view.hpp>
+
+namespace wf
+{
+class toplevel_capture_source_t;
+
+/**
+ * Implements ext-image-capture-source-v1 sources for foreign toplevels (ext-foreign-toplevel-list-v1
+ * handles), so that clients can capture a single window instead of a whole output.
+ *
+ * Each source renders only the view's surfaces into an offscreen buffer, independently of the outputs, so
+ * capturing works even if the view is occluded or on another workspace. The buffer is updated only where
+ * the view is damaged, and only when a client is waiting for a frame.
+ */
+class toplevel_capture_manager_t
+{
+  public:
+    toplevel_capture_manager_t(wlr_ext_foreign_toplevel_image_capture_source_manager_v1 *manager);
+    ~toplevel_capture_manager_t();
+
+  private:
+    std::map<wf::view_interface_t*, std::unique_ptr<toplevel_capture_source_t>> sources;
+    wf::wl_listener_wrapper on_new_request;
+    wf::signal::connection_t<wf::view_unmapped_signal> on_view_unmapped;
+};
+}
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <wayfire/txn/transaction-manager.hpp>
 #include <wayfire/debug.hpp>
+#include <wayfire/alloc-profiling.hpp>
 
 static bool transactions_intersect(const wf::txn::transaction_uptr& a, const wf::txn::transaction_uptr& b)
 {
@@ -123,6 +124,8 @@ struct wf::txn::transaction_manager_t::impl
 
     wf::signal::connection_t<transaction_applied_signal> on_tx_apply = [&] (transaction_applied_signal *ev)
     {
+        wf::alloc_profiling::scope_t alloc_scope{"transaction:apply"};
+
         // Move transactions which are done from committed to done.
         // They will be freed on next idle.
         auto it = std::find_if(committed.begin(), committed.end(), [&] (auto& existing)
@@ -1,4 +1,5 @@
 #include <memory>
+#include <wayfire/alloc-profiling.hpp>
 #include <wayfire/txn/transaction-manager.hpp>
 #include "transaction-manager-impl.hpp"
 #include "wayfire/debug.hpp"
@@ -13,6 +14,7 @@ wf::txn::transaction_manager_t::~transaction_manager_t() = default;
 
 void wf::txn::transaction_manager_t::schedule_transaction(wf::txn::transaction_uptr tx)
 {
+    wf::alloc_profiling::scope_t alloc_scope{"transaction:schedule"};
     new_transaction_signal ev;
     ev.tx = tx.get();
     this->emit(&ev);
@@ -47,3 +49,8 @@ bool wf::txn::transaction_manager_t::is_object_committed(transaction_object_sptr
         return is_contained(committed->get_objects(), object);
     });
 }
+
+bool wf::txn::transaction_manager_t::is_object_waiting(transaction_object_sptr object) const
+{
+    return is_object_pending(object) || is_object_committed(object);
+}
@@ -0,0 +1,199 @@
+#include "vrr-policy.hpp"
+
+#include <algorithm>
+
+#include <wayfire/core.hpp>
+#include <wayfire/debug.hpp>
+#include <wayfire/render-manager.hpp>
+#include <wayfire/toplevel-view.hpp>
+#include <wayfire/workspace-set.hpp>
+#include <wayfire/nonstd/wlroots-full.hpp>
+
+/** The frame interval of idle outputs, in milliseconds. */
+static constexpr int IDLE_FRAME_INTERVAL = 50;
+
+/** The number of frames in a row at the idle frame interval after which an idle output is active again. */
+static constexpr int IDLE_EXIT_FRAMES = 3;
+
+wf::vrr_policy_t::vrr_policy_t(wf::output_t *output, std::function<void()> on_changed)
+{
+    this->output     = output;
+    this->on_changed = std::move(on_changed);
+
+    on_root_node_updated = [=] (wf::scene::root_node_update_signal *ev)
+    {
+        using namespace wf::scene::update_flag;
+        // Views were mapped, unmapped, minimized, restacked or moved (which includes workspace changes).
+        if (ev->flags & (CHILDREN_LIST | ENABLED | GEOMETRY))
+        {
+            schedule_update();
+        }
+    };
+    wf::get_core().scene()->connect(&on_root_node_updated);
+
+    on_view_fullscreen   = [=] (wf::view_fullscreen_signal*) { schedule_update(); };
+    on_workspace_changed = [=] (wf::workspace_changed_signal*) { schedule_update(); };
+    output->connect(&on_view_fullscreen);
+    output->connect(&on_workspace_changed);
+
+    on_output_commit.set_callback([=] (void *data)
+    {
+        auto ev = static_cast<wlr_output_event_commit*>(data);
+        if (ev->state->committed & WLR_OUTPUT_STATE_BUFFER)
+        {
+            const int64_t now = wf::get_current_time();
+            if (idle)
+            {
+                // The frame was shown as soon as the idle frame interval allowed, so the content is animated.
+                busy_frames = (now - last_frame <= IDLE_FRAME_INTERVAL * 3 / 2) ? busy_frames + 1 : 0;
+                if (busy_frames >= IDLE_EXIT_FRAMES)
+                {
+                    set_idle(false);
+                }
+            }
+
+            last_frame = now;
+            restart_idle_timer();
+        }
+    });
+    on_output_commit.connect(&output->handle->events.commit);
+
+    // The content type is double-buffered surface state, so it can change only when the surface commits.
+    on_surface_commit.set_callback([=] (void*)
+    {
+        if (check_content_type() != content_wants_vrr)
+        {
+            schedule_update();
+        }
+    });
+
+    on_surface_destroy.set_callback([=] (void*)
+    {
+        track_surface(nullptr);
+        schedule_update();
+    });
+
+    update();
+    last_result = wants_vrr();
+}
+
+wf::vrr_policy_t::~vrr_policy_t()
+{
+    set_idle(false);
+}
+
+bool wf::vrr_policy_t::wants_vrr() const
+{
+    return content_wants_vrr || (idle_timeout > 0);
+}
+
+bool wf::vrr_policy_t::is_idle() const
+{
+    return idle;
+}
+
+void wf::vrr_policy_t::set_idle_timeout(int timeout_ms)
+{
+    idle_timeout = std::max(timeout_ms, 0);
+    restart_idle_timer();
+    schedule_update();
+}
+
+void wf::vrr_policy_t::restart_idle_timer()
+{
+    if (idle_timeout == 0)
+    {
+        idle_timer.disconnect();
+        set_idle(false);
+        return;
+    }
+
+    // This runs on every frame, but re-arming an already connected timer only updates its timerfd.
+    idle_timer.set_timeout(idle_timeout, [=] ()
+    {
+        set_idle(true);
+    });
+}
+
+void wf::vrr_policy_t::set_idle(bool idle)
+{
+    if (this->idle == idle)
+    {
+        return;
+    }
+
+    this->idle  = idle;
+    busy_frames = 0;
+    output->render->set_min_frame_interval(idle ? IDLE_FRAME_INTERVAL : 0);
+    LOGC(OUTPUT, "Output ", output->handle->name, idle ? " is idle" : " is active");
+}
+
+void wf::vrr_policy_t::schedule_update()
+{
+    // Many views may change in the same event loop iteration, we want to check the stacking order only once.
+    idle_update.run_once([=] ()
+    {
+        update();
+        if (wants_vrr() != last_result)
+        {
+            last_result = wants_vrr();
+            LOGC(OUTPUT, "Adaptive sync policy on output ", output->handle->name, ": ",
+                last_result ? "enable" : "disable");
+            this->on_changed();
+        }
+    });
+}
+
+void wf::vrr_policy_t::update()
+{
+    wlr_surface *surface = nullptr;
+    auto views = output->wset()->get_views(wf::WSET_MAPPED_ONLY | wf::WSET_EXCLUDE_MINIMIZED |
+        wf::WSET_CURRENT_WORKSPACE | wf::WSET_SORT_STACKING);
+    for (auto& view : views)
+    {
+        if (view->toplevel()->current().fullscreen)
+        {
+            surface = view->get_wlr_surface();
+            break;
+        }
+    }
+
+    track_surface(surface);
+    content_wants_vrr = check_content_type();
+}
+
+void wf::vrr_policy_t::track_surface(wlr_surface *surface)
+{
+    if (surface == fullscreen_surface)
+    {
+        return;
+    }
+
+    on_surface_commit.disconnect();
+    on_surface_destroy.disconnect();
+    fullscreen_surface = surface;
+    if (surface)
+    {
+        on_surface_commit.connect(&surface->events.commit);
+        on_surface_destroy.connect(&surface->events.destroy);
+    }
+}
+
+bool wf::vrr_policy_t::check_content_type()
+{
+    auto manager = wf::get_core().protocols.content_type;
+    if (!fullscreen_surface || !manager)
+    {
+        return false;
+    }
+
+    switch (wlr_surface_get_content_type_v1(manager, fullscreen_surface))
+    {
+      case WP_CONTENT_TYPE_V1_TYPE_GAME:
+      case WP_CONTENT_TYPE_V1_TYPE_VIDEO:
+        return true;
+
+      default:
+        return false;
+    }
+}
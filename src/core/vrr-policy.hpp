@@ -0,0 +1,79 @@
+#pragma once
+
+#include <functional>
+#include <wayfire/output.hpp>
+#include <wayfire/scene.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/util.hpp>
+
+namespace wf
+{
+/**
+ * Decides whether adaptive sync should be enabled on an output depending on what is shown on it.
+ *
+ * Adaptive sync is wanted when the topmost fullscreen view on the current workspace has the content type
+ * "game" or "video" (content-type-v1), because these clients present frames at their own pace. In all
+ * other cases it is disabled, because a varying refresh rate may cause flicker on some panels when the
+ * desktop is animated.
+ *
+ * Optionally, the policy also lowers the refresh rate while the screen is mostly static. In this case,
+ * adaptive sync stays enabled all the time, since toggling it causes flicker as well. Once the output has
+ * not shown a new frame for a while, it becomes idle and its frame interval is lengthened, so that
+ * occasional updates (a blinking cursor, a clock) do not bring the panel back to its full refresh rate.
+ * The output stops being idle when it shows new frames as fast as the idle frame interval allows.
+ */
+class vrr_policy_t
+{
+  public:
+    /**
+     * @param on_changed Called (from an idle callback) whenever the result of wants_vrr() changes.
+     */
+    vrr_policy_t(wf::output_t *output, std::function<void()> on_changed);
+    ~vrr_policy_t();
+
+    /** Whether adaptive sync should be enabled on the output right now. */
+    bool wants_vrr() const;
+
+    /** Whether the output is idle, so that its frame interval is lengthened. */
+    bool is_idle() const;
+
+    /**
+     * Set how long the output needs to go without new frames before it becomes idle.
+     * A timeout of 0 disables idle detection.
+     */
+    void set_idle_timeout(int timeout_ms);
+
+  private:
+    wf::output_t *output;
+    std::function<void()> on_changed;
+
+    bool content_wants_vrr = false;
+    bool idle = false;
+    int idle_timeout = 0;
+    bool last_result   = false;
+
+    /** The time of the last frame, and the number of consecutive frames shown at the idle frame interval. */
+    int64_t last_frame = 0;
+    int busy_frames    = 0;
+
+    /** The main surface of the fullscreen view which is currently tracked, if any. */
+    wlr_surface *fullscreen_surface = nullptr;
+
+    wf::wl_idle_call idle_update;
+    wf::wl_timer<false> idle_timer;
+    wf::wl_listener_wrapper on_output_commit;
+    wf::wl_listener_wrapper on_surface_commit;
+    wf::wl_listener_wrapper on_surface_destroy;
+
+    wf::signal::connection_t<wf::scene::root_node_update_signal> on_root_node_updated;
+    wf::signal::connection_t<wf::view_fullscreen_signal> on_view_fullscreen;
+    wf::signal::connection_t<wf::workspace_changed_signal> on_workspace_changed;
+
+    void schedule_update();
+    void update();
+    void track_surface(wlr_surface *surface);
+    bool check_content_type();
+    void restart_idle_timer();
+    void set_idle(bool idle);
+};
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace wf
+{
+namespace vk
+{
+/**
+ * Read the pipeline cache stored at @path.
+ * Drivers are supposed to reject incompatible data themselves, but not all of them do, so an empty cache is
+ * returned if the file was not created by the device with the given properties (or does not exist).
+ */
+std::vector<char> read_pipeline_cache_file(const std::string& path,
+    const VkPhysicalDeviceProperties& properties);
+
+/**
+ * Write the pipeline cache data to @path, creating its parent directories if necessary.
+ * The data is written to a temporary file first, so that a crash in the middle never leaves a truncated cache.
+ *
+ * @return Whether the cache was written successfully.
+ */
+bool write_pipeline_cache_file(const std::string& path, const std::vector<char>& data);
+
+/**
+ * A pipeline compilation which is queued on the background thread of the context, but which the compositor
+ * thread may take over as long as the background thread has not started it yet. This way, a pipeline which
+ * is needed right away never waits behind the rest of the warm-up queue.
+ */
+class pipeline_compile_job_t
+{
+  public:
+    pipeline_compile_job_t(std::function<VkPipeline()> compile);
+
+    /** Compile the pipeline on the calling thread, unless another thread has already started it. */
+    void run();
+
+    /**
+     * Get the compiled pipeline. If no thread has started the compilation yet, it happens on the calling
+     * thread, otherwise this waits for the thread which is compiling it.
+     */
+    VkPipeline get();
+
+    /**
+     * Make sure the job is never run.
+     * @return true if the job was cancelled, false if it has already started, in which case get() should be
+     *   used to wait for it.
+     */
+    bool cancel();
+
+  private:
+    std::function<VkPipeline()> compile;
+    std::atomic<bool> claimed = false;
+    std::promise<VkPipeline> result;
+    std::shared_future<VkPipeline> future;
+};
+}
+}
@@ -1,10 +1,18 @@
 #include "core/core-impl.hpp"
+#include "core/vulkan-priv.hpp"
 #include "wayfire/opengl.hpp"
+#include "wayfire/debug.hpp"
 #include <wayfire/vulkan.hpp>
 #include <fstream>
+#include <filesystem>
 #include <wayfire/util/log.hpp>
 #include <drm_fourcc.h>
 #include <cstring>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <glm/gtc/matrix_transform.hpp>
 
 extern "C"
@@ -201,6 +209,94 @@ void command_buffer_t::for_each_scissor_rect(const wf::render_target_t& target,
     wlr_vk_render_pass_mark_updated(wlr_pass, buffer_damage.to_pixman());
 }
 
+/**
+ * A single background thread which executes jobs in submission order.
+ * Used for compiling pipelines and writing the pipeline cache without blocking the compositor thread.
+ */
+struct context_t::background_worker_t
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> jobs;
+    bool stopping = false;
+    std::thread thread;
+
+    // Whether a pipeline cache save has been scheduled but not executed yet.
+    std::atomic<bool> save_pending = false;
+
+    background_worker_t()
+    {
+        thread = std::thread([this] { loop(); });
+    }
+
+    ~background_worker_t()
+    {
+        {
+            std::lock_guard lock{mutex};
+            stopping = true;
+        }
+
+        cv.notify_one();
+        thread.join();
+    }
+
+    void submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard lock{mutex};
+            jobs.push_back(std::move(job));
+        }
+
+        cv.notify_one();
+    }
+
+    void loop()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock lock{mutex};
+                cv.wait(lock, [&] { return stopping || !jobs.empty(); });
+                if (jobs.empty())
+                {
+                    // Stopping and all work has been finished
+                    return;
+                }
+
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            job();
+        }
+    }
+};
+
+static std::string get_pipeline_cache_path()
+{
+    const char *disable = getenv("WAYFIRE_DISABLE_VK_PIPELINE_CACHE");
+    if (disable && strcmp(disable, "0"))
+    {
+        LOGC(RENDER, "Vulkan pipeline cache disabled by environment variable.");
+        return "";
+    }
+
+    std::string cache_home;
+    if (const char *xdg_cache = getenv("XDG_CACHE_HOME"))
+    {
+        cache_home = xdg_cache;
+    } else if (const char *home = getenv("HOME"))
+    {
+        cache_home = std::string(home) + "/.cache";
+    } else
+    {
+        return "";
+    }
+
+    return cache_home + "/wayfire/vulkan-pipeline-cache";
+}
+
 context_t::context_t(wlr_renderer *renderer) : renderer(renderer)
 {
     this->device = wlr_vk_renderer_get_device(renderer);
@@ -209,10 +305,168 @@ context_t::context_t(wlr_renderer *renderer) : renderer(renderer)
 
     // Get the graphics queue
     vkGetDeviceQueue(device, queue_family, 0, &queue);
+
+    this->pipeline_cache_path = get_pipeline_cache_path();
+    load_pipeline_cache();
+    this->worker = std::make_unique<background_worker_t>();
 }
 
 context_t::~context_t()
-{}
+{
+    // Finish all pending compilations and cache writes first.
+    worker.reset();
+    save_pipeline_cache();
+    if (pipeline_cache != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineCache(device, pipeline_cache, nullptr);
+    }
+}
+
+void context_t::run_in_background(std::function<void()> job)
+{
+    worker->submit(std::move(job));
+}
+
+void context_t::schedule_pipeline_cache_save()
+{
+    if (pipeline_cache_path.empty() || worker->save_pending.exchange(true))
+    {
+        return;
+    }
+
+    run_in_background([this]
+    {
+        worker->save_pending = false;
+        save_pipeline_cache();
+    });
+}
+
+std::vector<char> read_pipeline_cache_file(const std::string& path,
+    const VkPhysicalDeviceProperties& properties)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+    VkPipelineCacheHeaderVersionOne header;
+    if (data.size() < sizeof(header))
+    {
+        return {};
+    }
+
+    std::memcpy(&header, data.data(), sizeof(header));
+    if ((header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) ||
+        (header.vendorID != properties.vendorID) || (header.deviceID != properties.deviceID) ||
+        std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE))
+    {
+        LOGC(RENDER, "Ignoring incompatible vulkan pipeline cache ", path);
+        return {};
+    }
+
+    return data;
+}
+
+bool write_pipeline_cache_file(const std::string& path, const std::vector<char>& data)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), data.size());
+        if (!file)
+        {
+            LOGW("Failed to write vulkan pipeline cache to ", tmp_path);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec)
+    {
+        LOGW("Failed to write vulkan pipeline cache to ", path, ": ", ec.message());
+        return false;
+    }
+
+    return true;
+}
+
+pipeline_compile_job_t::pipeline_compile_job_t(std::function<VkPipeline()> compile) :
+    compile(std::move(compile))
+{
+    future = result.get_future().share();
+}
+
+void pipeline_compile_job_t::run()
+{
+    if (!claimed.exchange(true))
+    {
+        result.set_value(compile());
+    }
+}
+
+VkPipeline pipeline_compile_job_t::get()
+{
+    run();
+    return future.get();
+}
+
+bool pipeline_compile_job_t::cancel()
+{
+    return !claimed.exchange(true);
+}
+
+void context_t::load_pipeline_cache()
+{
+    std::vector<char> initial_data;
+    if (!pipeline_cache_path.empty())
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physical_device, &properties);
+        initial_data = read_pipeline_cache_file(pipeline_cache_path, properties);
+    }
+
+    VkPipelineCacheCreateInfo cache_info{};
+    cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cache_info.initialDataSize = initial_data.size();
+    cache_info.pInitialData    = initial_data.empty() ? nullptr : initial_data.data();
+    if (vkCreatePipelineCache(device, &cache_info, nullptr, &pipeline_cache) != VK_SUCCESS)
+    {
+        // Retry without the data from disk, in case it was corrupted.
+        cache_info.initialDataSize = 0;
+        cache_info.pInitialData    = nullptr;
+        if (vkCreatePipelineCache(device, &cache_info, nullptr, &pipeline_cache) != VK_SUCCESS)
+        {
+            LOGE("Failed to create vulkan pipeline cache");
+            pipeline_cache = VK_NULL_HANDLE;
+        }
+    } else
+    {
+        LOGC(RENDER, "Loaded vulkan pipeline cache with ", initial_data.size(), " bytes");
+    }
+}
+
+void context_t::save_pipeline_cache()
+{
+    if ((pipeline_cache == VK_NULL_HANDLE) || pipeline_cache_path.empty())
+    {
+        return;
+    }
+
+    size_t size = 0;
+    if ((vkGetPipelineCacheData(device, pipeline_cache, &size, nullptr) != VK_SUCCESS) || (size == 0))
+    {
+        return;
+    }
+
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(device, pipeline_cache, &size, data.data()) != VK_SUCCESS)
+    {
+        return;
+    }
+
+    data.resize(size);
+    write_pipeline_cache_file(pipeline_cache_path, data);
+}
 
 VkShaderModule context_t::load_shader_module(std::string_view path)
 {
@@ -361,11 +615,21 @@ graphics_pipeline_t::graphics_pipeline_t(std::shared_ptr<context_t> ctx, const p
 
 graphics_pipeline_t::~graphics_pipeline_t()
 {
+    // Background jobs reference our shader modules and parameters. Cancel those which have not started yet
+    // and wait for the rest to finish.
+    for (auto& [key, pending] : pending_pipelines)
+    {
+        pipelines[key] = {pending.layout, pending.job->cancel() ? VK_NULL_HANDLE : pending.job->get()};
+    }
+
     // Destroy all pipelines and render passes
     for (auto& [pass, pf] : pipelines)
     {
         vkDestroyPipelineLayout(context->get_device(), pf.first, nullptr);
-        vkDestroyPipeline(context->get_device(), pf.second, nullptr);
+        if (pf.second != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(context->get_device(), pf.second, nullptr);
+        }
     }
 
     // Destroy loaded shader modules
@@ -378,11 +642,11 @@ graphics_pipeline_t::~graphics_pipeline_t()
     }
 }
 
-std::pair<VkPipelineLayout, VkPipeline> graphics_pipeline_t::pipeline_for(const command_buffer_t& cmd_buf,
-    const pipeline_specialization_t& specialization)
+std::vector<VkDescriptorSetLayout> graphics_pipeline_t::get_texture_layouts(const command_buffer_t& cmd_buf,
+    const std::vector<std::shared_ptr<wf::texture_t>>& textures)
 {
     std::vector<VkDescriptorSetLayout> specialization_filters;
-    for (const auto& texture : specialization.specialized_textures)
+    for (const auto& texture : textures)
     {
         auto dsl = wlr_vk_render_pass_get_texture_ds_layout(cmd_buf.wlr_pass, texture->get_wlr_texture(),
             texture->get_filter_mode().value_or(WLR_SCALE_FILTER_BILINEAR),
@@ -390,13 +654,11 @@ std::pair<VkPipelineLayout, VkPipeline> graphics_pipeline_t::pipeline_for(const
         specialization_filters.push_back(dsl);
     }
 
-    pipeline_key_t key{cmd_buf.current_pass, specialization.get_data(), specialization_filters};
-    auto it = pipelines.find(key);
-    if (it != pipelines.end())
-    {
-        return it->second;
-    }
+    return specialization_filters;
+}
 
+VkPipelineLayout graphics_pipeline_t::create_layout(const std::vector<VkDescriptorSetLayout>& texture_layouts)
+{
     // Create pipeline layout from descriptor set layouts and push constants
     VkPipelineLayout layout = VK_NULL_HANDLE;
     std::vector<VkDescriptorSetLayout> specialized_layouts;
@@ -406,13 +668,13 @@ std::pair<VkPipelineLayout, VkPipeline> graphics_pipeline_t::pipeline_for(const
         if (std::holds_alternative<VkDescriptorSetLayout>(layout_variant))
         {
             specialized_layouts.push_back(std::get<VkDescriptorSetLayout>(layout_variant));
-        } else if (specialized_idx < specialization_filters.size())
+        } else if (specialized_idx < texture_layouts.size())
         {
-            specialized_layouts.push_back(specialization_filters[specialized_idx++]);
+            specialized_layouts.push_back(texture_layouts[specialized_idx++]);
         } else
         {
             LOGE("Not enough specialization filters provided for pipeline specialization");
-            return {VK_NULL_HANDLE, VK_NULL_HANDLE};
+            return VK_NULL_HANDLE;
         }
     }
 
@@ -425,18 +687,26 @@ std::pair<VkPipelineLayout, VkPipeline> graphics_pipeline_t::pipeline_for(const
     if (vkCreatePipelineLayout(context->get_device(), &layout_info, nullptr, &layout) != VK_SUCCESS)
     {
         LOGE("Failed to create pipeline layout");
-        return {VK_NULL_HANDLE, VK_NULL_HANDLE};
+        return VK_NULL_HANDLE;
     }
 
+    return layout;
+}
+
+VkPipeline graphics_pipeline_t::create_pipeline(VkPipelineLayout layout, VkRenderPass render_pass,
+    const std::vector<VkSpecializationMapEntry>& entries, const std::vector<std::byte>& data) const
+{
+    // Note: this function may run on the background thread, so it must only read immutable state.
+
     // Build VkSpecializationInfo if we have specialization constants
     VkSpecializationInfo spec_info{};
-    const bool has_specialization = !specialization.get_entries().empty();
+    const bool has_specialization = !entries.empty();
     if (has_specialization)
     {
-        spec_info.mapEntryCount = specialization.get_entries().size();
-        spec_info.pMapEntries   = specialization.get_entries().data();
-        spec_info.dataSize = specialization.get_data().size();
-        spec_info.pData    = specialization.get_data().data();
+        spec_info.mapEntryCount = entries.size();
+        spec_info.pMapEntries   = entries.data();
+        spec_info.dataSize = data.size();
+        spec_info.pData    = data.data();
     }
 
     // --- Pipeline creation ---
@@ -536,20 +806,160 @@ std::pair<VkPipelineLayout, VkPipeline> graphics_pipeline_t::pipeline_for(const
     pipeline_info.pMultisampleState   = &multisampling;
     pipeline_info.pColorBlendState    = &color_blending;
     pipeline_info.layout     = layout;
-    pipeline_info.renderPass = cmd_buf.current_pass;
+    pipeline_info.renderPass = render_pass;
     pipeline_info.subpass    = 0;
     pipeline_info.pDynamicState = &dynamic_state_info;
 
     VkPipeline pipeline;
-    if (vkCreateGraphicsPipelines(
-        context->get_device(), VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline) != VK_SUCCESS)
+    if (vkCreateGraphicsPipelines(context->get_device(), context->get_pipeline_cache(), 1, &pipeline_info,
+        nullptr, &pipeline) != VK_SUCCESS)
+    {
+        LOGE("Failed to create graphics pipeline for pass: ", render_pass);
+        return VK_NULL_HANDLE;
+    }
+
+    return pipeline;
+}
+
+void graphics_pipeline_t::compile_in_background(const pipeline_key_t& key,
+    const std::vector<VkSpecializationMapEntry>& entries)
+{
+    if (pipelines.count(key) || pending_pipelines.count(key))
+    {
+        return;
+    }
+
+    const auto& [render_pass, data, texture_layouts] = key;
+    VkPipelineLayout layout = create_layout(texture_layouts);
+    if (layout == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    auto job = std::make_shared<pipeline_compile_job_t>([=, pass = render_pass, spec_data = data] ()
+    {
+        return create_pipeline(layout, pass, entries, spec_data);
+    });
+
+    pending_pipelines[key] = {layout, job};
+    context->run_in_background([job] { job->run(); });
+}
+
+void graphics_pipeline_t::add_known_specialization(const specialization_key_t& key,
+    const std::vector<VkSpecializationMapEntry>& entries)
+{
+    if (known_specializations.count(key))
+    {
+        return;
+    }
+
+    known_specializations[key] = entries;
+    for (auto pass : seen_passes)
+    {
+        compile_in_background({pass, key.first, key.second}, entries);
+    }
+}
+
+void graphics_pipeline_t::declare_specialization(const pipeline_specialization_t& specialization)
+{
+    if (specialization.specialized_textures.empty())
+    {
+        add_known_specialization({specialization.get_data(), {}}, specialization.get_entries());
+        return;
+    }
+
+    // Bound the number of textures kept alive if the pipeline is not used for a while.
+    static constexpr size_t max_unresolved_declarations = 16;
+    if (unresolved_declarations.size() >= max_unresolved_declarations)
+    {
+        unresolved_declarations.erase(unresolved_declarations.begin());
+    }
+
+    unresolved_declarations.push_back({specialization.get_entries(), specialization.get_data(),
+        specialization.specialized_textures});
+}
+
+void graphics_pipeline_t::warm_up(const command_buffer_t& cmd_buf)
+{
+    seen_passes.insert(cmd_buf.current_pass);
+    for (const auto& [spec_key, entries] : known_specializations)
+    {
+        compile_in_background({cmd_buf.current_pass, spec_key.first, spec_key.second}, entries);
+    }
+}
+
+std::pair<VkPipelineLayout, VkPipeline> graphics_pipeline_t::pipeline_for(const command_buffer_t& cmd_buf,
+    const pipeline_specialization_t& specialization)
+{
+    // The descriptor set layouts depend only on the renderer and the textures, so any command buffer will
+    // do for the declarations, even one for a different render pass.
+    for (auto& declared : unresolved_declarations)
+    {
+        add_known_specialization({declared.data, get_texture_layouts(cmd_buf, declared.textures)},
+            declared.entries);
+    }
+
+    unresolved_declarations.clear();
+
+    auto specialization_filters = get_texture_layouts(cmd_buf, specialization.specialized_textures);
+    pipeline_key_t key{cmd_buf.current_pass, specialization.get_data(), specialization_filters};
+    auto it = pipelines.find(key);
+    if (it != pipelines.end())
+    {
+        return it->second;
+    }
+
+    // Compile the pipeline needed for this frame first, so that it does not wait behind the warm-up of the
+    // other specializations and render passes.
+    auto result = compile_now(cmd_buf, specialization, key);
+    add_known_specialization({specialization.get_data(), specialization_filters},
+        specialization.get_entries());
+    if (!seen_passes.count(cmd_buf.current_pass))
+    {
+        warm_up(cmd_buf);
+    }
+
+    return result;
+}
+
+std::pair<VkPipelineLayout, VkPipeline> graphics_pipeline_t::compile_now(const command_buffer_t& cmd_buf,
+    const pipeline_specialization_t& specialization, const pipeline_key_t& key)
+{
+    // If the pipeline is queued in the background, take it over or wait for it if it is already being
+    // compiled. In the common case, it has been warmed up long before it was needed and this does not block.
+    auto pending_it = pending_pipelines.find(key);
+    if (pending_it != pending_pipelines.end())
+    {
+        auto [layout, job] = pending_it->second;
+        pending_pipelines.erase(pending_it);
+        VkPipeline pipeline = job->get();
+        if (pipeline != VK_NULL_HANDLE)
+        {
+            context->schedule_pipeline_cache_save();
+            pipelines[key] = {layout, pipeline};
+            return {layout, pipeline};
+        }
+
+        vkDestroyPipelineLayout(context->get_device(), layout, nullptr);
+        return {VK_NULL_HANDLE, VK_NULL_HANDLE};
+    }
+
+    VkPipelineLayout layout = create_layout(std::get<2>(key));
+    if (layout == VK_NULL_HANDLE)
+    {
+        return {VK_NULL_HANDLE, VK_NULL_HANDLE};
+    }
+
+    VkPipeline pipeline = create_pipeline(layout, cmd_buf.current_pass,
+        specialization.get_entries(), specialization.get_data());
+    if (pipeline == VK_NULL_HANDLE)
     {
-        LOGE("Failed to create graphics pipeline for pass: ", cmd_buf.current_pass);
         vkDestroyPipelineLayout(context->get_device(), layout, nullptr);
         return {VK_NULL_HANDLE, VK_NULL_HANDLE};
     }
 
     // Store the pipeline keyed by (render pass, specialization data)
+    context->schedule_pipeline_cache_save();
     pipelines[key] = {layout, pipeline};
     return {layout, pipeline};
 }
@@ -8,6 +8,8 @@
 #include <wayfire/util.hpp> // Added for wl_timer
 
 #include <cstring>
+#include <map>
+#include <set>
 #include <sys/inotify.h>
 #include <filesystem>
 #include <unistd.h>
@@ -26,9 +28,50 @@ static void add_watch(int fd)
     wd_cfg_file = inotify_add_watch(fd, config_file.c_str(), IN_CLOSE_WRITE);
 }
 
-static void reload_config()
+using option_values_t = std::map<std::string, std::string>;
+
+static option_values_t get_option_values()
+{
+    option_values_t values;
+    for (auto& section : cfg_manager->get_all_sections())
+    {
+        for (auto& opt : section->get_registered_options())
+        {
+            values[section->get_name() + "/" + opt->get_name()] = opt->get_value_str();
+        }
+    }
+
+    return values;
+}
+
+/**
+ * Reload the config file and return the names of the options which changed, were added or removed.
+ */
+static std::set<std::string> reload_config()
 {
+    auto old_values = get_option_values();
     wf::config::load_configuration_options_from_file(*cfg_manager, config_file);
+    auto new_values = get_option_values();
+
+    std::set<std::string> changed;
+    for (auto& [name, value] : new_values)
+    {
+        auto it = old_values.find(name);
+        if ((it == old_values.end()) || (it->second != value))
+        {
+            changed.insert(name);
+        }
+    }
+
+    for (auto& [name, _] : old_values)
+    {
+        if (!new_values.count(name))
+        {
+            changed.insert(name);
+        }
+    }
+
+    return changed;
 }
 
 static const char *CONFIG_FILE_ENV = "WAYFIRE_CONFIG_FILE";
@@ -137,14 +180,22 @@ class dynamic_ini_config_t : public wf::config_backend_t
     }
 
     /**
-     * Performs the actual configuration reload and emits the signal.
+     * Performs the actual configuration reload and emits the signal if any option changed.
      * This is called by the wl_timer after the delay.
      */
     void do_reload_config()
     {
         LOGD("Reloading configuration file now!");
-        reload_config();
+        auto changed = reload_config();
+        if (changed.empty())
+        {
+            LOGD("No options changed in the configuration file.");
+            return;
+        }
+
+        LOGD("Configuration file reloaded, ", changed.size(), " options changed.");
         wf::reload_config_signal ev;
+        ev.changed_options = std::move(changed);
         wf::get_core().emit(&ev);
         check_auto_reload_option(); // Re-check auto-reload option after config has been reloaded
     }
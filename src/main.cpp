@@ -15,6 +15,7 @@
 #include "wayfire/config-backend.hpp"
 #include "core/plugin-loader.hpp"
 #include "core/core-impl.hpp"
+#include "core/startup-timing-priv.hpp"
 #include <wayfire/nonstd/wlroots.hpp>
 
 static std::string get_version_string()
@@ -229,6 +230,12 @@ static std::string_view get_category_name(wf::log::logging_category category)
       case wf::log::logging_category::OUTPUT:
         return "output";
 
+      case wf::log::logging_category::STARTUP:
+        return "startup";
+
+      case wf::log::logging_category::ALLOC:
+        return "alloc";
+
       default:
         wf::dassert(false);
         return "unknown";
@@ -279,6 +286,7 @@ void parse_extended_debugging(const std::vector<std::string>& categories)
 //
 int main(int argc, char *argv[])
 {
+    wf::startup::mark("main");
     wf::log::log_level_t log_level = wf::log::LOG_LEVEL_INFO;
     struct option opts[] = {
         {
@@ -419,6 +427,7 @@ int main(int argc, char *argv[])
     /** TODO: move this to core_impl constructor */
     core.display = display;
     core.ev_loop = wl_display_get_event_loop(core.display);
+    wf::startup::begin_phase("backend-create");
     core.backend = wlr_backend_autocreate(core.ev_loop, &core.session);
 
     int drm_fd = -1;
@@ -467,6 +476,8 @@ int main(int argc, char *argv[])
         assert(core.egl);
     }
 
+    wf::startup::end_phase();
+
     if (!allow_root && !drop_permissions())
     {
         wl_display_destroy_clients(core.display);
@@ -475,6 +486,7 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
+    wf::startup::begin_phase("config-backend-load");
     auto backend = load_backend(config_backend);
     if (!backend)
     {
@@ -487,7 +499,11 @@ int main(int argc, char *argv[])
     LOGD("Using configuration backend: ", config_backend);
     core.config_backend = std::unique_ptr<wf::config_backend_t>(backend);
     core.config_backend->init(display, *core.config, config_file);
+    wf::startup::end_phase();
+
+    wf::startup::begin_phase("core-init");
     core.init();
+    wf::startup::end_phase();
 
     auto socket = choose_socket(core.display);
     if (!socket)
@@ -499,6 +515,7 @@ int main(int argc, char *argv[])
 
     core.wayland_display = socket.value();
     LOGI("Using socket name ", core.wayland_display);
+    wf::startup::begin_phase("backend-start");
     if (!wlr_backend_start(core.backend))
     {
         LOGE("Failed to initialize backend, exiting");
@@ -508,8 +525,12 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    wf::startup::end_phase();
+
     setenv("WAYLAND_DISPLAY", core.wayland_display.c_str(), 1);
+    wf::startup::begin_phase("core-post-init");
     core.post_init();
+    wf::startup::end_phase();
 
     wl_display_run(core.display);
     if (exit_because_signal == SIGINT)
@@ -1,4 +1,5 @@
 #include "wayfire/render-manager.hpp"
+#include "wayfire/alloc-profiling.hpp"
 #include "pixman.h"
 #include "wayfire/config-backend.hpp"
 #include "wayfire/scene-operations.hpp"
@@ -35,6 +36,8 @@ namespace wf
 struct swapchain_damage_manager_t
 {
     wf::option_wrapper_t<bool> force_frame_sync{"workarounds/force_frame_sync"};
+    wf::option_wrapper_t<int> damage_max_rects{"core/damage_max_rects"};
+    wf::option_wrapper_t<double> damage_max_waste{"core/damage_max_waste"};
     wf::wl_listener_wrapper on_needs_frame;
     wf::wl_listener_wrapper on_damage;
     wf::wl_listener_wrapper on_gamma_changed;
@@ -45,6 +48,7 @@ struct swapchain_damage_manager_t
     output_t *wo;
 
     bool pending_gamma_lut = false;
+    damage_stats_t damage_stats;
 
     std::unique_ptr<wf::scene::render_instance_manager_t> instance_manager;
     void start_rendering()
@@ -54,7 +58,8 @@ struct swapchain_damage_manager_t
             // Damage is pushed up to the root in root coordinate system,
             // we need it in output-buffer-local coordinate system.
             region += -wf::origin(wo->get_layout_geometry());
-            region  =
+            emit_damage(region);
+            region =
                 wo->render->get_target_framebuffer().framebuffer_region_from_geometry_region(region);
             this->damage_buffer(region, true);
         };
@@ -118,6 +123,28 @@ struct swapchain_damage_manager_t
         instance_manager->set_visibility_region(wo->get_layout_geometry());
     };
 
+    /**
+     * Emit output_damage_signal for damage in output-local coordinates. Damage is very frequent, so nothing
+     * is done unless somebody listens for it.
+     */
+    void emit_damage(const wf::region_t& region)
+    {
+        if (!region.empty() && wo->has_connections<output_damage_signal>())
+        {
+            output_damage_signal ev;
+            ev.region = &region;
+            wo->emit(&ev);
+        }
+    }
+
+    void emit_damage(const wf::geometry_t& box)
+    {
+        if (wo->has_connections<output_damage_signal>())
+        {
+            emit_damage(wf::region_t{box});
+        }
+    }
+
     /**
      * Damage the given region
      */
@@ -324,6 +351,37 @@ struct swapchain_damage_manager_t
         {
             frame_damage |= get_buffer_extents();
         }
+
+        simplify_frame_damage();
+    }
+
+    /**
+     * Merge the rectangles of fragmented frame damage (for example many small text updates), because every
+     * rectangle costs at least one draw call or scissor per render instance.
+     */
+    void simplify_frame_damage()
+    {
+        int max_rects    = damage_max_rects;
+        double max_waste = damage_max_waste;
+        // The software renderer pays mostly per pixel, the GPU renderers mostly per rectangle.
+        if (max_rects < 0)
+        {
+            max_rects = wf::get_core().is_pixman() ? 128 : 32;
+        }
+
+        if (max_waste < 0)
+        {
+            max_waste = wf::get_core().is_pixman() ? 0.25 : 0.5;
+        }
+
+        const uint64_t rects_before = frame_damage.end() - frame_damage.begin();
+        frame_damage = wf::simplify_region(frame_damage, max_rects, max_waste);
+        const uint64_t rects_after = frame_damage.end() - frame_damage.begin();
+
+        damage_stats.frames++;
+        damage_stats.simplified_frames += (rects_after != rects_before);
+        damage_stats.rects_before += rects_before;
+        damage_stats.rects_after  += rects_after;
     }
 
     /**
@@ -371,6 +429,7 @@ struct swapchain_damage_manager_t
      */
     void damage_whole()
     {
+        emit_damage(wo->get_relative_geometry());
         damage_buffer(get_buffer_extents(), true);
     }
 
@@ -818,6 +877,7 @@ class wf::render_manager::impl
     };
 
     wf::wl_listener_wrapper on_frame;
+    wf::wl_listener_wrapper on_commit;
     wf::wl_timer<false> repaint_timer;
 
     output_t *output;
@@ -832,6 +892,21 @@ class wf::render_manager::impl
     std::unique_ptr<wf::render_pass_t> current_pass;
     wf::option_wrapper_t<std::string> icc_profile;
     wf::option_wrapper_t<bool> hdr;
+    wf::option_wrapper_t<bool> allow_tearing;
+
+    /**
+     * Whether the last frame was presented with a tearing page-flip. In this case, the client is
+     * latency-sensitive and we skip the repaint delay.
+     */
+    bool tearing_active = false;
+
+    /** Whether the last commit on the output requested a tearing page-flip. */
+    bool last_commit_tearing = false;
+
+    /** See render_manager::set_min_frame_interval(). */
+    int min_frame_interval = 0;
+    /** The time when the last frame with a new buffer was committed, in milliseconds. */
+    int64_t last_frame_commit = 0;
 
     /**
      * The output color transform that matches the output's currently-committed image description.
@@ -956,12 +1031,23 @@ class wf::render_manager::impl
                 return;
             }
 
+            int64_t throttle = 0;
+            if (min_frame_interval > 0)
+            {
+                throttle = last_frame_commit + min_frame_interval - get_current_time();
+                if (throttle >= 1)
+                {
+                    // The delay manager would consider the throttled frame as missed.
+                    delay_manager->skip_frame();
+                }
+            }
+
             delay_manager->start_frame();
 
-            auto repaint_delay = delay_manager->get_delay();
+            auto repaint_delay = std::max<int64_t>(delay_manager->get_delay(), throttle);
             // Leave a bit of time for clients to render, see
             // https://github.com/swaywm/sway/pull/4588
-            if (repaint_delay < 1)
+            if ((repaint_delay < 1) || tearing_active)
             {
                 output->handle->frame_pending = false;
                 paint();
@@ -981,6 +1067,17 @@ class wf::render_manager::impl
 
         on_frame.connect(&output->handle->events.frame);
 
+        on_commit.set_callback([=] (void *data)
+        {
+            auto ev = static_cast<wlr_output_event_commit*>(data);
+            last_commit_tearing = ev->state->tearing_page_flip;
+            if (ev->state->committed & WLR_OUTPUT_STATE_BUFFER)
+            {
+                last_frame_commit = get_current_time();
+            }
+        });
+        on_commit.connect(&output->handle->events.commit);
+
         background_color_opt.load_option("core/background_color");
         background_color_opt.set_callback([=] ()
         {
@@ -1007,9 +1104,24 @@ class wf::render_manager::impl
             damage_manager->damage_whole_idle();
         });
 
+        allow_tearing.load_option(section, "allow_tearing");
+
         reload_icc_profile();
     }
 
+    bool should_tear(wlr_surface *surface)
+    {
+        auto hint = wlr_tearing_control_manager_v1_surface_hint_from_surface(
+            wf::get_core().protocols.tearing_control, surface);
+
+        output_tearing_request_signal ev;
+        ev.output  = output;
+        ev.surface = surface;
+        ev.allow_tearing = allow_tearing && (hint == WP_TEARING_CONTROL_V1_PRESENTATION_HINT_ASYNC);
+        output->emit(&ev);
+        return ev.allow_tearing;
+    }
+
     wlr_buffer_pass_options pass_opts{};
 
     void reload_icc_profile()
@@ -1097,6 +1209,7 @@ class wf::render_manager::impl
      */
     bool do_direct_scanout()
     {
+        tearing_active = false;
         const bool can_scanout = !output_inhibit_counter && effects->can_scanout() &&
             postprocessing->can_scanout() && wlr_output_is_direct_scanout_allowed(output->handle) &&
             (icc_color_transform == nullptr);
@@ -1106,9 +1219,18 @@ class wf::render_manager::impl
             return false;
         }
 
+        last_commit_tearing = false;
         auto result = scene::try_scanout_from_list(
             damage_manager->instance_manager->get_instances(), output);
-        return result == scene::direct_scanout::SUCCESS;
+        if (result != scene::direct_scanout::SUCCESS)
+        {
+            return false;
+        }
+
+        // The scanout surface may have fallen back to a regular page-flip if the output does not support
+        // tearing, so check what was actually committed.
+        tearing_active = last_commit_tearing;
+        return true;
     }
 
     /**
@@ -1192,6 +1314,8 @@ class wf::render_manager::impl
      */
     void paint()
     {
+        wf::alloc_profiling::scope_t alloc_scope{"frame"};
+
         /* Part 1: frame setup: query damage, etc. */
         effects->run_effects(OUTPUT_EFFECT_PRE);
         effects->run_effects(OUTPUT_EFFECT_DAMAGE);
@@ -1427,6 +1551,16 @@ wf::region_t render_manager::get_scheduled_damage()
     return pimpl->damage_manager->get_scheduled_damage(get_target_framebuffer());
 }
 
+damage_stats_t render_manager::get_damage_stats()
+{
+    return pimpl->damage_manager->damage_stats;
+}
+
+void render_manager::reset_damage_stats()
+{
+    pimpl->damage_manager->damage_stats = {};
+}
+
 void render_manager::damage_whole()
 {
     pimpl->damage_manager->damage_whole();
@@ -1440,12 +1574,14 @@ void render_manager::damage_whole_idle()
 void render_manager::damage(const wlr_box& box, bool repaint)
 {
     auto fb = pimpl->postprocessing->get_target_framebuffer();
+    pimpl->damage_manager->emit_damage(box);
     pimpl->damage_manager->damage_buffer(fb.framebuffer_box_from_geometry_box(box), repaint);
 }
 
 void render_manager::damage(const wf::region_t& region, bool repaint)
 {
     auto fb = pimpl->postprocessing->get_target_framebuffer();
+    pimpl->damage_manager->emit_damage(region);
     pimpl->damage_manager->damage_buffer(fb.framebuffer_region_from_geometry_region(region), repaint);
 }
 
@@ -1474,6 +1610,16 @@ wf::render_pass_t*render_manager::get_current_pass()
     return pimpl->current_pass.get();
 }
 
+void render_manager::set_min_frame_interval(int interval_ms)
+{
+    pimpl->min_frame_interval = std::max(interval_ms, 0);
+}
+
+bool render_manager::should_tear(wlr_surface *surface)
+{
+    return pimpl->should_tear(surface);
+}
+
 void priv_render_manager_clear_instances(wf::render_manager *manager)
 {
     manager->pimpl->damage_manager->instance_manager.reset();
@@ -1,5 +1,7 @@
 #include <wayfire/region.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
+#include <algorithm>
+#include <vector>
 
 /* Pixman helpers */
 wlr_box wlr_box_from_pixman_box(const pixman_box32_t& box)
@@ -325,3 +327,90 @@ const pixman_box32_t*wf::region_t::end() const
 
     return data + n;
 }
+
+wf::region_t wf::simplify_region(const wf::region_t& region, int max_rects, double max_waste)
+{
+    if ((max_rects <= 0) || (region.end() - region.begin() <= max_rects))
+    {
+        return region;
+    }
+
+    struct cluster_t
+    {
+        pixman_box32_t box;
+        // The area of the original rectangles in the cluster. They are disjoint, so this is exact.
+        int64_t covered;
+    };
+
+    const auto& area = [] (const pixman_box32_t& box)
+    {
+        return int64_t(box.x2 - box.x1) * (box.y2 - box.y1);
+    };
+
+    const auto& try_merge = [&] (cluster_t& into, const cluster_t& other)
+    {
+        pixman_box32_t merged = {
+            std::min(into.box.x1, other.box.x1), std::min(into.box.y1, other.box.y1),
+            std::max(into.box.x2, other.box.x2), std::max(into.box.y2, other.box.y2),
+        };
+
+        const int64_t merged_area = area(merged);
+        const int64_t covered     = into.covered + other.covered;
+        if (merged_area - covered > max_waste * merged_area)
+        {
+            return false;
+        }
+
+        into.box     = merged;
+        into.covered = covered;
+        return true;
+    };
+
+    // Pixman sorts the rectangles in bands from top to bottom, so neighbouring rectangles are usually close
+    // in the list as well.
+    std::vector<cluster_t> clusters;
+    for (auto& box : region)
+    {
+        cluster_t next{box, area(box)};
+        auto it = std::find_if(clusters.rbegin(), clusters.rend(),
+            [&] (cluster_t& cluster) { return try_merge(cluster, next); });
+        if (it == clusters.rend())
+        {
+            clusters.push_back(next);
+        }
+    }
+
+    // Merging grows the clusters, after which they may be merged with each other too.
+    bool merged_any = true;
+    while (merged_any && (clusters.size() > 1))
+    {
+        merged_any = false;
+        for (size_t i = 0; i < clusters.size(); i++)
+        {
+            for (size_t j = i + 1; j < clusters.size();)
+            {
+                if (try_merge(clusters[i], clusters[j]))
+                {
+                    clusters.erase(clusters.begin() + j);
+                    merged_any = true;
+                } else
+                {
+                    j++;
+                }
+            }
+        }
+    }
+
+    wf::region_t result;
+    for (auto& cluster : clusters)
+    {
+        result |= wlr_box_from_pixman_box(cluster.box);
+    }
+
+    if (result.end() - result.begin() > max_rects)
+    {
+        return wf::region_t{wlr_box_from_pixman_box(region.get_extents())};
+    }
+
+    return result;
+}
@@ -1,5 +1,6 @@
 #include <wayfire/render.hpp>
 #include "core/core-impl.hpp"
+#include "core/pixman-tiled-pass.hpp"
 #include "wayfire/dassert.hpp"
 #include "wayfire/nonstd/reverse.hpp"
 #include "wayfire/opengl.hpp"
@@ -181,6 +182,11 @@ wlr_texture*wf::texture_t::get_wlr_texture() const
     return texture;
 }
 
+wlr_buffer*wf::texture_t::get_buffer() const
+{
+    return buffer;
+}
+
 int32_t wf::texture_t::get_width() const
 {
     return texture->width;
@@ -667,6 +673,7 @@ wf::render_pass_t::render_pass_t(const render_pass_params_t& p)
     this->params.renderer = p.renderer ?: wf::get_core().renderer;
     this->params.pass_opts.color_transform = p.pass_opts.color_transform ?: p.target.get_color_transform();
     wf::dassert(p.target.get_buffer(), "Cannot run a render pass without a valid target!");
+    this->tiled_pass = pixman_tiled_pass_t::create(this->params.renderer);
 }
 
 wf::region_t wf::render_pass_t::run(const wf::render_pass_params_t& params)
@@ -741,9 +748,22 @@ wlr_renderer*wf::render_pass_t::get_wlr_renderer() const
 
 wlr_render_pass*wf::render_pass_t::get_wlr_pass()
 {
+    // Operations added to the wlroots pass directly must come after the recorded ones.
+    flush_tiled_pass();
     return _get_pass();
 }
 
+void wf::render_pass_t::flush_tiled_pass()
+{
+    if (tiled_pass && tiled_pass->has_pending())
+    {
+        if (auto pass = _get_pass())
+        {
+            tiled_pass->flush(pass, params.renderer, params.target.get_buffer());
+        }
+    }
+}
+
 void wf::render_pass_t::clear(const wf::region_t& region, const wf::color_t& color)
 {
     auto box    = wf::construct_box({0, 0}, params.target.get_size());
@@ -760,6 +780,12 @@ void wf::render_pass_t::clear(const wf::region_t& region, const wf::color_t& col
         .a = static_cast<float>(color.a),
     };
 
+    if (tiled_pass)
+    {
+        tiled_pass->add_rect(opts);
+        return;
+    }
+
     wlr_render_pass_add_rect(_get_pass(), &opts);
 }
 
@@ -815,6 +841,11 @@ void wf::render_pass_t::add_texture(const std::shared_ptr<wf::texture_t>& textur
         opts.luminance_multiplier = &luminance_multiplier;
     }
 
+    if (tiled_pass && tiled_pass->add_texture(texture, opts))
+    {
+        return;
+    }
+
     wlr_render_pass_add_texture(get_wlr_pass(), &opts);
 }
 
@@ -834,6 +865,12 @@ void wf::render_pass_t::add_rect(const wf::color_t& color, const wf::render_targ
     opts.box  = fbox_to_geometry(adjusted_target.framebuffer_box_from_geometry_box(geometry));
     wf::dassert(opts.box.width >= 0);
     wf::dassert(opts.box.height >= 0);
+    if (tiled_pass)
+    {
+        tiled_pass->add_rect(opts);
+        return;
+    }
+
     wlr_render_pass_add_rect(_get_pass(), &opts);
 }
 
@@ -852,6 +889,7 @@ void wf::render_pass_t::add_rect(const wf::color_t& color, const wf::render_targ
 
 bool wf::render_pass_t::submit()
 {
+    flush_tiled_pass();
     if (!this->_pass)
     {
         // No pass currently running.
@@ -888,6 +926,7 @@ wf::render_pass_t& wf::render_pass_t::operator =(render_pass_t&& other)
     other._pass  = NULL;
     this->params = other.params;
     this->needs_restart = other.needs_restart;
+    this->tiled_pass    = std::move(other.tiled_pass);
     return *this;
 }
 
@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <cstring>
 #include <cstdlib>
+#include <optional>
 
 #include <wayfire/seat.hpp>
 #include <wayfire/workarea.hpp>
@@ -50,6 +51,9 @@ class wayfire_layer_shell_view : public wf::view_interface_t
     /** The output geometry of the view */
     wf::geometry_t geometry{100, 100, 0, 0};
 
+    /** The size sent with the last configure event since the view was last unmapped */
+    std::optional<wf::dimensions_t> last_configured_size;
+
     std::string app_id;
     friend class wf::tracking_allocator_t<view_interface_t>;
     wayfire_layer_shell_view(wlr_layer_surface_v1 *lsurf);
@@ -180,7 +184,7 @@ struct wf_layer_shell_manager
     void handle_map(wayfire_layer_shell_view *view)
     {
         layers[view->lsurface->current.layer].push_back(view);
-        arrange_layers(view->get_output());
+        arrange_view(view);
     }
 
     void remove_view_from_layer(wayfire_layer_shell_view *view, uint32_t layer)
@@ -205,9 +209,12 @@ struct wf_layer_shell_manager
 
     void handle_unmap(wayfire_layer_shell_view *view)
     {
-        view->remove_anchored(false);
         remove_view_from_layer(view, view->lsurface->current.layer);
-        arrange_layers(view->get_output());
+        if (view->anchored_area)
+        {
+            view->remove_anchored(false);
+            reflow_reserved_areas(view->get_output());
+        }
     }
 
     layer_t filter_views(wf::output_t *output, int layer)
@@ -360,6 +367,58 @@ struct wf_layer_shell_manager
         view->get_output()->workarea->reflow_reserved_areas();
     }
 
+    /**
+     * Recalculate the reserved areas on the output. The views without an exclusive zone depend only on the
+     * resulting workarea, so they are repositioned only if it changed.
+     *
+     * @return Whether the workarea changed.
+     */
+    bool reflow_reserved_areas(wf::output_t *output)
+    {
+        auto old_workarea = output->workarea->get_workarea();
+        output->workarea->reflow_reserved_areas();
+        if (output->workarea->get_workarea() == old_workarea)
+        {
+            return false;
+        }
+
+        LOGC(LSHELL, "Workarea changed from ", old_workarea, " to ", output->workarea->get_workarea());
+        for (auto layer : {ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, ZWLR_LAYER_SHELL_V1_LAYER_TOP,
+            ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM, ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND})
+        {
+            arrange_floating(output, layer);
+        }
+
+        return true;
+    }
+
+    /**
+     * Arrange a single mapped view after its state changed. Unlike arrange_layers(), the reserved areas are
+     * reflowed only if the view has or had an exclusive zone, and the rest of the views are repositioned
+     * only if their available area changed.
+     */
+    void arrange_view(wayfire_layer_shell_view *view)
+    {
+        auto output = view->get_output();
+        if (view->lsurface->pending.exclusive_zone > 0)
+        {
+            // The view is pinned when its anchored area is reflowed.
+            set_exclusive_zone(view);
+            reflow_reserved_areas(output);
+        } else if (view->anchored_area)
+        {
+            LOGC(LSHELL, "Unset anchored area for ", view->self());
+            view->remove_anchored(false);
+            if (!reflow_reserved_areas(output))
+            {
+                pin_view(view, output->workarea->get_workarea());
+            }
+        } else
+        {
+            pin_view(view, output->workarea->get_workarea());
+        }
+    }
+
     void arrange_layers(wf::output_t *output)
     {
         const auto layers = {
@@ -530,6 +589,24 @@ void wayfire_layer_shell_view::unmap()
     emit_view_unmap();
     priv->set_enabled(false);
     wf_layer_shell_manager::get_instance().handle_unmap(this);
+    last_configured_size.reset();
+}
+
+/**
+ * Check whether the committed state changes the position, size or reserved area of the layer surface.
+ * Panels and OSDs commit frequently (e.g. for every new frame), and most of these commits change only the
+ * buffer contents.
+ */
+static bool layout_state_changed(const wlr_layer_surface_v1_state& prev, const wlr_layer_surface_v1_state& next)
+{
+    return (prev.anchor != next.anchor) ||
+           (prev.exclusive_zone != next.exclusive_zone) ||
+           (prev.desired_width != next.desired_width) ||
+           (prev.desired_height != next.desired_height) ||
+           (prev.margin.top != next.margin.top) ||
+           (prev.margin.right != next.margin.right) ||
+           (prev.margin.bottom != next.margin.bottom) ||
+           (prev.margin.left != next.margin.left);
 }
 
 void wayfire_layer_shell_view::commit()
@@ -557,10 +634,10 @@ void wayfire_layer_shell_view::commit()
             wf::scene::readd_front(get_output()->node_for_layer(get_layer()), get_root_node());
             /* Will also trigger reflowing */
             wf_layer_shell_manager::get_instance().handle_move_layer(this);
-        } else
+        } else if (layout_state_changed(prev_state, *state))
         {
             /* Reflow reserved areas and positions */
-            wf_layer_shell_manager::get_instance().arrange_layers(get_output());
+            wf_layer_shell_manager::get_instance().arrange_view(this);
         }
 
         if (prev_state.keyboard_interactive != state->keyboard_interactive)
@@ -636,6 +713,13 @@ void wayfire_layer_shell_view::configure(wf::geometry_t box)
     // TODO: transactions here could make sense, since we want to change x,y,w,h together, but have to wait
     // for the client to resize.
     move(box.x, box.y);
+    if (is_mapped() && last_configured_size && (*last_configured_size == wf::dimensions(box)))
+    {
+        // Each configure makes the client commit again, avoid sending them when nothing changed.
+        return;
+    }
+
+    last_configured_size = wf::dimensions(box);
     wlr_layer_surface_v1_configure(lsurface, box.width, box.height);
 }
 
@@ -98,6 +98,22 @@ core_vulkan_state_t& core_ensure_vk(wf::vulkan_render_state_t& state)
     state.store_data<core_vulkan_state_t>(std::move(data));
     return *ptr;
 }
+
+/**
+ * Declare the specialization for the current contents of a view which is about to be transformed, so that
+ * the pipeline for them is compiled in the background instead of in the first transformed frame.
+ */
+void core_declare_texture(const std::shared_ptr<wf::texture_t>& texture)
+{
+    if (!texture || !wf::get_core().is_vulkan())
+    {
+        return;
+    }
+
+    wf::vk::pipeline_specialization_t specialization{};
+    specialization.add_specialization_for_texture(texture);
+    core_ensure_vk(wf::vulkan_render_state_t::get()).pipeline->declare_specialization(specialization);
+}
 }
 
 #endif
@@ -252,7 +268,13 @@ class view_2d_render_instance_t :
     public transformer_render_instance_t<view_2d_transformer_t>
 {
   public:
-    using transformer_render_instance_t::transformer_render_instance_t;
+    view_2d_render_instance_t(view_2d_transformer_t *self, damage_callback push_damage,
+        wf::output_t *shown_on) : transformer_render_instance_t(self, push_damage, shown_on)
+    {
+#if WF_HAS_VULKANFX
+        vk::core_declare_texture(zero_copy_texture());
+#endif
+    }
 
     void transform_damage_region(wf::region_t& damage) override
     {
@@ -261,6 +283,7 @@ class view_2d_render_instance_t :
 
     void render(const wf::scene::render_instruction_t& data) override
     {
+        self->set_content_scale(std::max(std::abs(self->get_scale_x()), std::abs(self->get_scale_y())));
         if (std::abs(self->get_angle()) < 1e-3)
         {
             // No rotation, we can use render-agnostic functions.
@@ -516,8 +539,13 @@ class view_3d_render_instance_t :
     public transformer_render_instance_t<view_3d_transformer_t>
 {
   public:
-    using transformer_render_instance_t::transformer_render_instance_t;
-
+    view_3d_render_instance_t(view_3d_transformer_t *self, damage_callback push_damage,
+        wf::output_t *shown_on) : transformer_render_instance_t(self, push_damage, shown_on)
+    {
+#if WF_HAS_VULKANFX
+        vk::core_declare_texture(zero_copy_texture());
+#endif
+    }
 
     void transform_damage_region(wf::region_t& damage) override
     {
@@ -621,6 +649,8 @@ uint32_t transformer_base_node_t::optimize_update(uint32_t flags)
 std::shared_ptr<wf::texture_t> transformer_base_node_t::get_updated_contents(const wf::geometry_t& bbox,
     float scale, std::vector<scene::render_instance_uptr>& children, wf::output_t *output)
 {
+    // A different content scale changes the buffer size, so the reallocation below damages everything.
+    scale *= content_scale;
     if (inner_content.allocate(wf::dimensions(bbox), scale,
         wf::buffer_allocation_hints_t{.hdr_linear = output && output->is_hdr()}) !=
         buffer_reallocation_result_t::SAME)
@@ -644,6 +674,23 @@ std::shared_ptr<wf::texture_t> transformer_base_node_t::get_updated_contents(con
     return wf::texture_t::from_aux(inner_content);
 }
 
+void transformer_base_node_t::set_content_scale(float scale)
+{
+    // Quantize to a few fixed levels, so that the buffer is not reallocated and fully repainted on every
+    // frame of an animation which changes the scale.
+    static constexpr float MIN_CONTENT_SCALE = 1.0 / 8;
+    content_scale = 1.0;
+    while ((content_scale / 2 >= std::abs(scale)) && (content_scale > MIN_CONTENT_SCALE))
+    {
+        content_scale /= 2;
+    }
+}
+
+float transformer_base_node_t::get_content_scale() const
+{
+    return content_scale;
+}
+
 void transformer_base_node_t::release_buffers()
 {
     inner_content.free();
@@ -0,0 +1,143 @@
+#include <wayfire/view-snapshot.hpp>
+#include <cmath>
+#include <wayfire/output.hpp>
+#include <wayfire/unstable/translation-node.hpp>
+#include <wayfire/unstable/wlr-surface-node.hpp>
+#include <wayfire/nonstd/wlroots-full.hpp>
+
+void wf::view_snapshot_t::capture(wayfire_view view, std::optional<wf::geometry_t> region)
+{
+    reset();
+
+    auto root = view->get_surface_root_node();
+    this->region = region.value_or(root->get_bounding_box());
+
+    // The root node itself is translated by its parent, but the translation nodes below it are part of the
+    // view's layout.
+    if (dynamic_cast<wf::scene::translation_node_t*>(root.get()) && collect_surfaces(root.get(), root.get()))
+    {
+        zero_copy = true;
+        return;
+    }
+
+    // Drop the surfaces collected before we found out that we need to render.
+    surfaces.clear();
+    render_to_buffer(view);
+}
+
+bool wf::view_snapshot_t::collect_surfaces(wf::scene::node_t *node, wf::scene::node_t *root)
+{
+    for (auto& child : node->get_children())
+    {
+        if (!child->is_enabled())
+        {
+            continue;
+        }
+
+        if (auto surface_node = dynamic_cast<wf::scene::wlr_surface_node_t*>(child.get()))
+        {
+            if (!surface_node->get_children().empty())
+            {
+                return false;
+            }
+
+            auto texture = surface_node->to_texture();
+            if (!texture)
+            {
+                continue;
+            }
+
+            auto box = surface_node->get_bounding_box();
+            wf::pointf_t origin = {1.0 * box.x, 1.0 * box.y};
+            for (auto parent = surface_node->parent(); parent; parent = parent->parent())
+            {
+                origin = parent->to_global(origin);
+                if (parent == root)
+                {
+                    break;
+                }
+            }
+
+            box.x = std::round(origin.x);
+            box.y = std::round(origin.y);
+            surfaces.push_back({texture, box});
+        } else if (dynamic_cast<wf::scene::translation_node_t*>(child.get()))
+        {
+            if (!collect_surfaces(child.get(), root))
+            {
+                return false;
+            }
+        } else
+        {
+            // Custom nodes may render anything, we need to render them to get their contents.
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void wf::view_snapshot_t::render_to_buffer(wayfire_view view)
+{
+    auto root_node = view->get_surface_root_node();
+    auto output    = view->get_output();
+    const float scale = output ? output->handle->scale : 1.0;
+    buffer.allocate(wf::dimensions(region), scale,
+        wf::buffer_allocation_hints_t{.hdr_linear = output && output->is_hdr()});
+
+    wf::render_target_t target{buffer};
+    target.geometry = region;
+    target.scale    = scale;
+
+    std::vector<scene::render_instance_uptr> instances;
+    root_node->gen_render_instances(instances, [] (auto) {}, output);
+
+    render_pass_params_t params;
+    params.background_color = {0, 0, 0, 0};
+    params.damage    = region;
+    params.target    = target;
+    params.instances = &instances;
+    params.flags     = RPASS_CLEAR_BACKGROUND;
+    render_pass_t::run(params);
+}
+
+void wf::view_snapshot_t::reset()
+{
+    surfaces.clear();
+    buffer.free();
+    zero_copy = false;
+}
+
+wf::geometry_t wf::view_snapshot_t::get_region() const
+{
+    return region;
+}
+
+bool wf::view_snapshot_t::is_zero_copy() const
+{
+    return zero_copy;
+}
+
+void wf::view_snapshot_t::render(const wf::scene::render_instruction_t& data, wf::geometry_t geometry,
+    float alpha)
+{
+    if (!zero_copy)
+    {
+        if (buffer.get_buffer())
+        {
+            data.pass->add_texture(wf::texture_t::from_aux(buffer), data.target, geometry, data.damage,
+                alpha);
+        }
+
+        return;
+    }
+
+    // Surfaces may extend beyond the captured region, for example client-side shadows.
+    const wf::region_t damage = data.damage & geometry;
+    for (auto it = surfaces.rbegin(); it != surfaces.rend(); ++it)
+    {
+        wlr_fbox box = wf::scale_fbox(wf::geometry_to_fbox(region), wf::geometry_to_fbox(geometry),
+            wf::geometry_to_fbox(it->geometry));
+        data.pass->add_texture(it->texture, data.target, box, damage, alpha);
+    }
+}
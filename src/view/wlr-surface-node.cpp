@@ -1,4 +1,5 @@
 #include "wayfire/unstable/wlr-surface-node.hpp"
+#include "wayfire/debug.hpp"
 #include "wayfire/geometry.hpp"
 #include "wayfire/render-manager.hpp"
 #include "wayfire/scene-render.hpp"
@@ -7,6 +8,7 @@
 #include "wlr-surface-touch-interaction.cpp"
 #include "wayfire/output-layout.hpp"
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -169,6 +171,12 @@ wf::scene::wlr_surface_node_t::wlr_surface_node_t(wlr_surface *surface, bool aut
 
     this->on_surface_commit.set_callback([=] (void*)
     {
+        if (this->throttled)
+        {
+            handle_throttled_commit();
+            return;
+        }
+
         if (this->autocommit)
         {
             apply_current_surface_state();
@@ -204,7 +212,16 @@ void wf::scene::wlr_surface_node_t::apply_state(surface_state_t&& state)
     }
 
     this->current_state = std::move(state);
-    wf::scene::damage_node(this, current_state.accumulated_damage);
+    if (throttled)
+    {
+        // Nobody can see the damage, so we damage the whole surface once it becomes visible again.
+        damage_on_unthrottle = true;
+        current_state.accumulated_damage.clear();
+    } else
+    {
+        wf::scene::damage_node(this, current_state.accumulated_damage);
+    }
+
     if (size_changed)
     {
         scene::update(this->shared_from_this(), scene::update_flag::GEOMETRY);
@@ -289,9 +306,126 @@ void wf::scene::wlr_surface_node_t::send_frame_done(bool delay_until_vblank)
     }
 }
 
+bool wf::scene::wlr_surface_node_t::is_throttled() const
+{
+    return throttled;
+}
+
+void wf::scene::wlr_surface_node_t::update_instance_visibility(instance_visibility_t old_state,
+    instance_visibility_t new_state)
+{
+    auto get_counter = [&] (instance_visibility_t state) -> int*
+    {
+        switch (state)
+        {
+          case instance_visibility_t::UNKNOWN:
+            return &unknown_instances;
+
+          case instance_visibility_t::VISIBLE:
+            return &visible_instances;
+
+          case instance_visibility_t::HIDDEN:
+            return &hidden_instances;
+
+          default:
+            return nullptr;
+        }
+    };
+
+    if (auto counter = get_counter(old_state))
+    {
+        --*counter;
+    }
+
+    if (auto counter = get_counter(new_state))
+    {
+        ++*counter;
+    }
+
+    if (visible_instances > 0)
+    {
+        // Stop throttling immediately, so that the next frame shows the current contents.
+        throttle_update_timer.disconnect();
+        set_throttled(false);
+        return;
+    }
+
+    // Render instances are regenerated whenever the scenegraph structure changes, and their visibility is
+    // recomputed on the next idle. Wait until things settle down, so that we do not toggle throttling (and
+    // the suspended state of the client) every time this happens. Instances which never compute their
+    // visibility (offscreen rendering by plugins, for example) prevent throttling.
+    static constexpr uint32_t THROTTLE_DELAY_MS = 250;
+    throttle_update_timer.set_timeout(THROTTLE_DELAY_MS, [=] ()
+    {
+        static wf::option_wrapper_t<bool> throttle_hidden_surfaces{"core/throttle_hidden_surfaces"};
+        set_throttled(throttle_hidden_surfaces && (visible_instances == 0) && (unknown_instances == 0) &&
+            (hidden_instances > 0));
+    });
+}
+
+void wf::scene::wlr_surface_node_t::set_throttled(bool throttled)
+{
+    if (this->throttled == throttled)
+    {
+        return;
+    }
+
+    this->throttled = throttled;
+    throttled_frame_timer.disconnect();
+    if (!throttled && surface)
+    {
+        if (autocommit)
+        {
+            apply_current_surface_state();
+        }
+
+        if (damage_on_unthrottle)
+        {
+            damage_on_unthrottle = false;
+            wf::scene::damage_node(this, get_bounding_box());
+        }
+
+        // The client may be waiting for a frame callback since it was hidden.
+        send_frame_done(true);
+    }
+
+    surface_throttled_signal ev;
+    ev.throttled = throttled;
+    this->emit(&ev);
+}
+
+void wf::scene::wlr_surface_node_t::handle_throttled_commit()
+{
+    if (throttled_frame_timer.is_connected())
+    {
+        return;
+    }
+
+    // Clients which draw only in response to frame callbacks (most toolkits) will wait for the next
+    // callback, clients which draw on their own timers keep committing, but their commits are cheap, since
+    // we do not repaint. In both cases we pick up the latest state at a low rate.
+    static wf::option_wrapper_t<int> hidden_surface_frame_rate{"core/hidden_surface_frame_rate"};
+    const int rate = std::max(1, (int)hidden_surface_frame_rate);
+    throttled_frame_timer.set_timeout(1000 / rate, [=] ()
+    {
+        if (!surface)
+        {
+            return;
+        }
+
+        if (autocommit)
+        {
+            apply_current_surface_state();
+        }
+
+        send_frame_done(false);
+    });
+}
+
 class wf::scene::wlr_surface_node_t::wlr_surface_render_instance_t : public render_instance_t
 {
     std::shared_ptr<wlr_surface_node_t> self;
+    instance_visibility_t visibility_state = instance_visibility_t::UNKNOWN;
     wf::signal::connection_t<wf::frame_done_signal> on_frame_done = [=] (wf::frame_done_signal *ev)
     {
         self->send_frame_done(false);
@@ -341,11 +475,13 @@ class wf::scene::wlr_surface_node_t::wlr_surface_render_instance_t : public rend
         this->push_damage = push_damage;
         this->visible_on  = visible_on;
         self->connect(&on_surface_damage);
+        self->update_instance_visibility(instance_visibility_t::NONE, visibility_state);
         this->last_visibility |= wlr_box{INT_MIN / 2, INT_MIN / 2, INT_MAX, INT_MAX};
     }
 
     ~wlr_surface_render_instance_t()
     {
+        self->update_instance_visibility(visibility_state, instance_visibility_t::NONE);
         if (visible_on)
         {
             self->handle_leave(visible_on);
@@ -433,6 +569,16 @@ class wf::scene::wlr_surface_node_t::wlr_surface_render_instance_t : public rend
         wlr_output_state state;
         wlr_output_state_init(&state);
         wlr_output_state_set_buffer(&state, &wlr_surf->buffer->base);
+        if (output->render->should_tear(wlr_surf))
+        {
+            state.tearing_page_flip = true;
+            if (!wlr_output_test_state(output->handle, &state))
+            {
+                LOGC(SCANOUT, "Output ", output->to_string(), " does not support tearing page-flips.");
+                state.tearing_page_flip = false;
+            }
+        }
+
         wlr_presentation_surface_scanned_out_on_output(wlr_surf, output->handle);
 
         if (wlr_output_commit_state(output->handle, &state))
@@ -461,7 +607,8 @@ class wf::scene::wlr_surface_node_t::wlr_surface_render_instance_t : public rend
             "workarounds/enable_opaque_region_damage_optimizations"
         };
 
-        if (!(visible & our_box).empty())
+        const bool is_visible = !(visible & our_box).empty();
+        if (is_visible)
         {
             // We are visible on the given output => send wl_surface.frame on output frame, so that clients
             // can draw the next frame.
@@ -471,6 +618,13 @@ class wf::scene::wlr_surface_node_t::wlr_surface_render_instance_t : public rend
                 visible ^= self->current_state.opaque_region;
             }
         }
+
+        auto new_state = is_visible ? instance_visibility_t::VISIBLE : instance_visibility_t::HIDDEN;
+        if (new_state != visibility_state)
+        {
+            self->update_instance_visibility(visibility_state, new_state);
+            visibility_state = new_state;
+        }
     }
 };
 
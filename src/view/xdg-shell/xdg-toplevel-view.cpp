@@ -178,6 +178,19 @@ wf::xdg_toplevel_view_t::xdg_toplevel_view_t(wlr_xdg_toplevel *tlvl) : xdg_tople
         this->handle_toplevel_state_changed(ev->old_state);
     };
 
+    // Hint to the client that it is not visible, so that it can stop animations and rendering altogether.
+    this->on_surface_throttled = [&] (scene::surface_throttled_signal *ev)
+    {
+        if (xdg_toplevel && xdg_toplevel->base->surface->mapped)
+        {
+            wlr_xdg_toplevel_set_suspended(xdg_toplevel, ev->throttled);
+        } else if (xdg_toplevel)
+        {
+            xdg_toplevel->pending.suspended = ev->throttled;
+        }
+    };
+    this->main_surface->connect(&this->on_surface_throttled);
+
     on_show_window_menu.set_callback([&] (void *data)
     {
         wlr_xdg_toplevel_show_window_menu_event *event =
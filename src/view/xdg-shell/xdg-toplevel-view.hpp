@@ -48,6 +48,7 @@ class xdg_toplevel_view_t : public xdg_toplevel_view_base_t, public wf::toplevel
 
     std::shared_ptr<wf::xdg_toplevel_t> wtoplevel;
     wf::signal::connection_t<xdg_toplevel_applied_state_signal> on_toplevel_applied;
+    wf::signal::connection_t<scene::surface_throttled_signal> on_surface_throttled;
 
     void map() override;
     void destroy() override;
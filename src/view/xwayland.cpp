@@ -6,6 +6,7 @@
 #include <wayfire/view.hpp>
 #include <wayfire/nonstd/tracking-allocator.hpp>
 #include <wayfire/option-wrapper.hpp>
+#include <wayfire/startup-timing.hpp>
 
 #include "wayfire/unstable/wlr-view-events.hpp"
 #include "wayfire/util.hpp"
@@ -233,8 +234,23 @@ void wf::init_xwayland(bool lazy)
         }
     });
 
-    on_xwayland_ready.set_callback([&] (void *data)
+    on_xwayland_ready.set_callback([lazy] (void *data)
     {
+        static bool first_start = true;
+        if (first_start)
+        {
+            if (lazy)
+            {
+                // With lazy startup, this happens only once the first X11 client connects.
+                wf::startup::mark("xwayland-ready");
+            } else
+            {
+                wf::startup::end_async_phase("xwayland-startup");
+            }
+
+            first_start = false;
+        }
+
         if (!wf::xw::load_basic_atoms(xwayland_handle->display_name))
         {
             LOGE("Failed to load Xwayland atoms.");
@@ -255,8 +271,21 @@ void wf::init_xwayland(bool lazy)
         }
     });
 
+    if (!lazy)
+    {
+        // The server is started right away, the phase ends once it is ready.
+        wf::startup::begin_async_phase("xwayland-startup");
+    }
+
+    wf::startup::begin_phase("xwayland-init");
     xwayland_handle = wlr_xwayland_create(wf::get_core().display,
         wf::get_core_impl().compositor, lazy);
+    wf::startup::end_phase();
+
+    if (!xwayland_handle && !lazy)
+    {
+        wf::startup::end_async_phase("xwayland-startup");
+    }
 
     if (xwayland_handle)
     {
@@ -0,0 +1,613 @@
+/**
+ * End-to-end benchmark of the compositor on the headless backend.
+ *
+ * The benchmark starts Wayfire with the headless test harness, connects a number of synthetic xdg-shell
+ * clients which commit buffers at a fixed rate, drives synthetic input devices (like the stipc plugin does)
+ * and reports per-frame compositor CPU time, the latency from a surface commit to the presentation of the
+ * frame containing it, and the number of C++ heap allocations on the main thread per frame.
+ *
+ * Usage: wayfire-benchmark [--scenario NAME] [--duration SECONDS] [--clients N] [--rate HZ] [--size WxH]
+ *        wayfire-benchmark --list
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <linux/input-event-codes.h>
+
+#include <wayfire/alloc-profiling.hpp>
+#include <wayfire/core.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/toplevel-view.hpp>
+#include <wayfire/util.hpp>
+#include <wayfire/nonstd/wlroots-full.hpp>
+
+extern "C"
+{
+#include <wlr/interfaces/wlr_keyboard.h>
+#include <wlr/interfaces/wlr_pointer.h>
+}
+
+#include "../support/headless-core-harness.hpp"
+#include "../support/wayland-xdg-client.hpp"
+
+#if !WF_ALLOC_PROFILING
+namespace
+{
+// Thread-local like the counter of allocation profiling builds, so that only the allocations of the main
+// thread are measured, and not those of background threads (software rendering, keymap compilation, ...).
+thread_local uint64_t thread_allocations = 0;
+}
+
+void*operator new(std::size_t size)
+{
+    ++thread_allocations;
+    if (void *ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+#endif
+
+namespace
+{
+/**
+ * The number of C++ heap allocations on the main thread so far. Builds with allocation profiling already
+ * replace operator new, so we reuse their counter.
+ */
+uint64_t get_allocation_count()
+{
+#if WF_ALLOC_PROFILING
+    return wf::alloc_profiling::get_thread_allocations();
+#else
+    return thread_allocations;
+#endif
+}
+
+int64_t get_time_nsec(clockid_t clock = CLOCK_MONOTONIC)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1'000'000'000ll + ts.tv_nsec;
+}
+
+struct options_t
+{
+    std::string scenario = "many-windows";
+    double duration = 5.0;
+
+    /* Overrides for the scenario defaults, negative if unset. */
+    int clients = -1;
+    double rate = -1;
+    int width   = -1;
+    int height  = -1;
+};
+
+class sample_stats_t
+{
+  public:
+    void add(double sample)
+    {
+        samples.push_back(sample);
+    }
+
+    void print(const std::string& name) const
+    {
+        if (samples.empty())
+        {
+            std::printf("%-34s no samples\n", name.c_str());
+            return;
+        }
+
+        auto sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&] (double p)
+        {
+            return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))];
+        };
+
+        double sum = 0;
+        for (auto s : sorted)
+        {
+            sum += s;
+        }
+
+        std::printf("%-34s mean %9.1f  p50 %9.1f  p95 %9.1f  p99 %9.1f  max %9.1f  (n=%zu)\n",
+            name.c_str(), sum / sorted.size(), percentile(0.5), percentile(0.95), percentile(0.99),
+            sorted.back(), sorted.size());
+    }
+
+  private:
+    std::vector<double> samples;
+};
+
+const wlr_pointer_impl benchmark_pointer_impl = {
+    .name = "benchmark-pointer",
+};
+
+void benchmark_led_update(wlr_keyboard*, uint32_t)
+{}
+
+const wlr_keyboard_impl benchmark_keyboard_impl = {
+    .name = "benchmark-keyboard",
+    .led_update = benchmark_led_update,
+};
+
+/**
+ * A synthetic pointer and keyboard, created the same way as the input devices of the stipc plugin.
+ */
+class synthetic_input_t
+{
+  public:
+    synthetic_input_t()
+    {
+        auto backend = wf::get_core().backend;
+        wlr_pointer_init(&pointer, &benchmark_pointer_impl, "benchmark-pointer");
+        wlr_keyboard_init(&keyboard, &benchmark_keyboard_impl, "benchmark-keyboard");
+        wl_signal_emit_mutable(&backend->events.new_input, &pointer.base);
+        wl_signal_emit_mutable(&backend->events.new_input, &keyboard.base);
+    }
+
+    ~synthetic_input_t()
+    {
+        wlr_pointer_finish(&pointer);
+        wlr_keyboard_finish(&keyboard);
+    }
+
+    synthetic_input_t(const synthetic_input_t&) = delete;
+    synthetic_input_t(synthetic_input_t&&) = delete;
+    synthetic_input_t& operator =(const synthetic_input_t&) = delete;
+    synthetic_input_t& operator =(synthetic_input_t&&) = delete;
+
+    void key(uint32_t key, bool pressed)
+    {
+        wlr_keyboard_key_event ev;
+        ev.keycode = key;
+        ev.state   = pressed ? WL_KEYBOARD_KEY_STATE_PRESSED : WL_KEYBOARD_KEY_STATE_RELEASED;
+        ev.update_state = true;
+        ev.time_msec    = wf::get_current_time();
+        wlr_keyboard_notify_key(&keyboard, &ev);
+    }
+
+    void button(uint32_t button, bool pressed)
+    {
+        wlr_pointer_button_event ev;
+        ev.pointer   = &pointer;
+        ev.button    = button;
+        ev.state     = pressed ? WL_POINTER_BUTTON_STATE_PRESSED : WL_POINTER_BUTTON_STATE_RELEASED;
+        ev.time_msec = wf::get_current_time();
+        wl_signal_emit(&pointer.events.button, &ev);
+        wl_signal_emit(&pointer.events.frame, NULL);
+    }
+
+    void move_to(double x, double y)
+    {
+        auto cursor = wf::get_core().get_cursor_position();
+
+        wlr_pointer_motion_event ev;
+        ev.pointer   = &pointer;
+        ev.time_msec = wf::get_current_time();
+        ev.delta_x   = ev.unaccel_dx = x - cursor.x;
+        ev.delta_y   = ev.unaccel_dy = y - cursor.y;
+        wl_signal_emit(&pointer.events.motion, &ev);
+        wl_signal_emit(&pointer.events.frame, NULL);
+    }
+
+  private:
+    wlr_pointer pointer;
+    wlr_keyboard keyboard;
+};
+
+/**
+ * Collects the measurements. Compositor work is accounted to the frame which the output commits during
+ * the same event loop dispatch, or to the next frame if no frame is committed.
+ */
+class frame_tracker_t
+{
+  public:
+    sample_stats_t frame_cpu_usec;
+    sample_stats_t frame_allocations;
+    sample_stats_t latency_usec;
+
+    int frames = 0;
+    int64_t total_cpu_nsec = 0;
+    uint64_t total_allocations = 0;
+
+    frame_tracker_t(wf::output_t *output)
+    {
+        on_output_commit.set_callback([=] (void *data)
+        {
+            auto ev = static_cast<wlr_output_event_commit*>(data);
+            if (ev->state->committed & WLR_OUTPUT_STATE_BUFFER)
+            {
+                ++frames_in_dispatch;
+            }
+        });
+        on_output_commit.connect(&output->handle->events.commit);
+
+        on_present.set_callback([=] (void *data)
+        {
+            auto ev = static_cast<wlr_output_event_present*>(data);
+            int64_t when = ev->when.tv_sec * 1'000'000'000ll + ev->when.tv_nsec;
+            for (auto commit_time : pending_commits)
+            {
+                latency_usec.add((when - commit_time) / 1000.0);
+            }
+
+            pending_commits.clear();
+        });
+        on_present.connect(&output->handle->events.present);
+
+        on_view_mapped = [=] (wf::view_mapped_signal *ev)
+        {
+            track_surface(ev->view->get_wlr_surface());
+        };
+        on_view_unmapped = [=] (wf::view_unmapped_signal *ev)
+        {
+            surface_commits.erase(ev->view->get_wlr_surface());
+        };
+        wf::get_core().connect(&on_view_mapped);
+        wf::get_core().connect(&on_view_unmapped);
+    }
+
+    void track_surface(wlr_surface *surface)
+    {
+        if (!surface)
+        {
+            return;
+        }
+
+        auto& listener = surface_commits[surface];
+        listener = std::make_unique<wf::wl_listener_wrapper>();
+        listener->set_callback([=] (void*)
+        {
+            if (surface->current.committed & WLR_SURFACE_STATE_BUFFER)
+            {
+                pending_commits.push_back(get_time_nsec());
+            }
+        });
+        listener->connect(&surface->events.commit);
+    }
+
+    /** Run one iteration of the compositor's event loop and account the work done in it. */
+    void dispatch(wf::test::headless_core_harness_t& harness, int timeout_ms)
+    {
+        frames_in_dispatch = 0;
+        const uint64_t allocations_before = get_allocation_count();
+        const int64_t cpu_before = get_time_nsec(CLOCK_PROCESS_CPUTIME_ID);
+        harness.dispatch_once(timeout_ms);
+        const int64_t cpu = get_time_nsec(CLOCK_PROCESS_CPUTIME_ID) - cpu_before;
+        const uint64_t allocations = get_allocation_count() - allocations_before;
+        pending_cpu_nsec    += cpu;
+        pending_allocations += allocations;
+        total_cpu_nsec += cpu;
+        total_allocations += allocations;
+
+        if (frames_in_dispatch > 0)
+        {
+            frames += frames_in_dispatch;
+            frame_cpu_usec.add(pending_cpu_nsec / 1000.0 / frames_in_dispatch);
+            frame_allocations.add(1.0 * pending_allocations / frames_in_dispatch);
+            pending_cpu_nsec    = 0;
+            pending_allocations = 0;
+        }
+    }
+
+  private:
+    int frames_in_dispatch = 0;
+    int64_t pending_cpu_nsec = 0;
+    uint64_t pending_allocations = 0;
+    std::vector<int64_t> pending_commits;
+
+    wf::wl_listener_wrapper on_output_commit;
+    wf::wl_listener_wrapper on_present;
+    std::map<wlr_surface*, std::unique_ptr<wf::wl_listener_wrapper>> surface_commits;
+    wf::signal::connection_t<wf::view_mapped_signal> on_view_mapped;
+    wf::signal::connection_t<wf::view_unmapped_signal> on_view_unmapped;
+};
+
+struct benchmark_t;
+
+struct scenario_t
+{
+    std::string name;
+    std::string description;
+    int clients;
+    double rate;
+    int width;
+    int height;
+    /** The plugins to load, in the format of core/plugins. */
+    std::string plugins;
+    /** The plugin which start() activates on the output, if any. */
+    std::string active_plugin;
+
+    /** Called once all clients are mapped. */
+    std::function<void(benchmark_t&)> start = [] (benchmark_t&) {};
+    /** Called on each iteration of the main loop, with the time in seconds since start() was called. */
+    std::function<void(benchmark_t&, double)> step = [] (benchmark_t&, double) {};
+};
+
+struct benchmark_t
+{
+    wf::test::headless_core_harness_t& harness;
+    synthetic_input_t& input;
+    std::vector<wayfire_toplevel_view> views;
+
+    /** Move the pointer along a Lissajous curve over the whole output. */
+    void sweep_pointer(double t)
+    {
+        auto size = harness.output()->get_screen_size();
+        input.move_to(size.width * (0.5 + 0.45 * std::sin(t * 1.3)),
+            size.height * (0.5 + 0.45 * std::sin(t * 1.7)));
+    }
+
+    /** Press and release a key combination with the super modifier. */
+    void press_super_combo(uint32_t key)
+    {
+        input.key(KEY_LEFTMETA, true);
+        input.key(key, true);
+        input.key(key, false);
+        input.key(KEY_LEFTMETA, false);
+    }
+};
+
+std::vector<scenario_t> get_scenarios()
+{
+    std::vector<scenario_t> scenarios;
+    scenarios.push_back({
+        .name = "idle",
+        .description = "A single static window, no input",
+        .clients = 1, .rate = 0, .width = 640, .height = 480,
+        .plugins = "",
+    });
+
+    scenarios.push_back({
+        .name = "many-windows",
+        .description = "Many windows committing at 60Hz while the pointer moves over them",
+        .clients = 32, .rate = 60, .width = 320, .height = 240,
+        .plugins = "",
+        .step    = [] (benchmark_t& b, double t) { b.sweep_pointer(t); },
+    });
+
+    scenarios.push_back({
+        .name = "scale",
+        .description = "Scale is active while windows commit at 30Hz",
+        .clients = 16, .rate = 30, .width = 400, .height = 300,
+        .plugins = "scale",
+        .active_plugin = "scale",
+        .start   = [] (benchmark_t& b) { b.press_super_combo(KEY_P); },
+        .step    = [] (benchmark_t& b, double t) { b.sweep_pointer(t); },
+    });
+
+    scenarios.push_back({
+        .name = "expo",
+        .description = "Expo is active while windows commit at 30Hz",
+        .clients = 16, .rate = 30, .width = 400, .height = 300,
+        .plugins = "expo",
+        .active_plugin = "expo",
+        .start   = [] (benchmark_t& b) { b.press_super_combo(KEY_E); },
+        .step    = [] (benchmark_t& b, double t) { b.sweep_pointer(t); },
+    });
+
+    scenarios.push_back({
+        .name = "heavy-resize",
+        .description = "Interactive resize of a window with the pointer, clients follow every configure",
+        .clients = 4, .rate = 60, .width = 400, .height = 300,
+        .plugins = "resize",
+        .active_plugin = "resize",
+        .start   = [] (benchmark_t& b)
+        {
+            auto geometry = b.views.front()->get_geometry();
+            b.input.move_to(geometry.x + geometry.width - 10, geometry.y + geometry.height - 10);
+            b.input.key(KEY_LEFTMETA, true);
+            b.input.button(BTN_RIGHT, true);
+        },
+        .step = [] (benchmark_t& b, double t)
+        {
+            auto geometry = b.views.front()->get_geometry();
+            b.input.move_to(geometry.x + 400 + 200 * std::sin(t * 3), geometry.y + 300 + 150 * std::cos(t * 3));
+        },
+    });
+
+    return scenarios;
+}
+
+bool parse_size(const std::string& value, int& width, int& height)
+{
+    return std::sscanf(value.c_str(), "%dx%d", &width, &height) == 2;
+}
+
+void run_scenario(scenario_t scenario, const options_t& options)
+{
+    scenario.clients = (options.clients >= 0) ? options.clients : scenario.clients;
+    scenario.rate    = (options.rate >= 0) ? options.rate : scenario.rate;
+    scenario.width   = (options.width > 0) ? options.width : scenario.width;
+    scenario.height  = (options.height > 0) ? options.height : scenario.height;
+
+    wf::test::headless_core_harness_t harness{"[core]\nplugins = " + scenario.plugins + "\n",
+        wf::log::LOG_LEVEL_ERROR};
+    harness.post_init();
+    synthetic_input_t input;
+    frame_tracker_t tracker{harness.output()};
+    benchmark_t benchmark{harness, input, {}};
+
+    wf::signal::connection_t<wf::view_mapped_signal> on_mapped = [&] (wf::view_mapped_signal *ev)
+    {
+        if (auto toplevel = wf::toplevel_cast(ev->view))
+        {
+            benchmark.views.push_back(toplevel);
+        }
+    };
+    wf::get_core().connect(&on_mapped);
+
+    std::vector<std::unique_ptr<wf::test::wayland_xdg_client_t>> clients;
+    for (int i = 0; i < scenario.clients; i++)
+    {
+        auto client = std::make_unique<wf::test::wayland_xdg_client_t>(harness.socket_name());
+        harness.run_until([&] { client->dispatch_once(); return client->has_required_globals(); });
+        client->create_toplevel("benchmark client " + std::to_string(i), "org.wayfire.Benchmark");
+        harness.run_until([&] { client->dispatch_once(); return client->has_pending_configure(); });
+        client->commit_frame(scenario.width, scenario.height);
+        clients.push_back(std::move(client));
+    }
+
+    if (!harness.run_until([&] { return (int)benchmark.views.size() == scenario.clients; }))
+    {
+        std::cerr << "Not all clients were mapped, aborting." << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    // Arrange the views in a grid, overlapping if there are many.
+    auto screen  = harness.output()->get_screen_size();
+    int columns  = std::max(1, (int)std::ceil(std::sqrt(scenario.clients)));
+    for (size_t i = 0; i < benchmark.views.size(); i++)
+    {
+        benchmark.views[i]->move(i % columns * screen.width / columns, i / columns * screen.height / columns);
+    }
+
+    harness.roundtrip();
+    scenario.start(benchmark);
+    harness.roundtrip();
+    if (!scenario.active_plugin.empty() && !harness.output()->is_plugin_active(scenario.active_plugin))
+    {
+        std::cerr << "The " << scenario.active_plugin << " plugin is not active, aborting." << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    const int64_t period = scenario.rate > 0 ? 1'000'000'000 / scenario.rate : 0;
+    const int64_t start  = get_time_nsec();
+    const int64_t end    = start + options.duration * 1'000'000'000;
+    std::vector<int64_t> next_commit(clients.size(), start);
+
+    int64_t now;
+    while ((now = get_time_nsec()) < end)
+    {
+        for (size_t i = 0; (period > 0) && (i < clients.size()); i++)
+        {
+            if (now < next_commit[i])
+            {
+                continue;
+            }
+
+            auto& client = clients[i];
+            int width  = client->configured_width() > 0 ? client->configured_width() : scenario.width;
+            int height = client->configured_height() > 0 ? client->configured_height() : scenario.height;
+            client->commit_frame(width, height);
+
+            // Do not try to catch up if the client fell behind, real clients skip frames too.
+            next_commit[i] = std::max(next_commit[i] + period, now);
+        }
+
+        scenario.step(benchmark, (now - start) / 1e9);
+        for (auto& client : clients)
+        {
+            client->dispatch_once();
+        }
+
+        tracker.dispatch(harness, 1);
+    }
+
+    const double seconds = (now - start) / 1e9;
+    std::printf("scenario: %s (%s)\n", scenario.name.c_str(), scenario.description.c_str());
+    std::printf("clients: %d, rate: %.1f Hz, size: %dx%d, duration: %.1f s\n",
+        scenario.clients, scenario.rate, scenario.width, scenario.height, seconds);
+    std::printf("frames: %d (%.1f fps)\n", tracker.frames, tracker.frames / seconds);
+    std::printf("compositor cpu: %.1f ms/s, C++ allocations: %.0f/s\n",
+        tracker.total_cpu_nsec / 1e6 / seconds, tracker.total_allocations / seconds);
+    tracker.frame_cpu_usec.print("frame cpu time (us)");
+    tracker.latency_usec.print("commit-to-present latency (us)");
+    tracker.frame_allocations.print("C++ allocations per frame");
+    std::printf("\n");
+}
+
+void print_usage(const char *argv0)
+{
+    std::printf("Usage: %s [--scenario NAME|all] [--duration SECONDS] [--clients N] [--rate HZ] [--size WxH]\n"
+                "       %s --list\n", argv0, argv0);
+}
+}
+
+int main(int argc, char **argv)
+{
+    options_t options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool has_value  = i + 1 < argc;
+        if (arg == "--list")
+        {
+            for (auto& scenario : get_scenarios())
+            {
+                std::printf("%-14s %s\n", scenario.name.c_str(), scenario.description.c_str());
+            }
+
+            return EXIT_SUCCESS;
+        } else if ((arg == "--scenario") && has_value)
+        {
+            options.scenario = argv[++i];
+        } else if ((arg == "--duration") && has_value)
+        {
+            options.duration = std::atof(argv[++i]);
+        } else if ((arg == "--clients") && has_value)
+        {
+            options.clients = std::atoi(argv[++i]);
+        } else if ((arg == "--rate") && has_value)
+        {
+            options.rate = std::atof(argv[++i]);
+        } else if ((arg == "--size") && has_value && parse_size(argv[i + 1], options.width, options.height))
+        {
+            ++i;
+        } else
+        {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!getenv("WAYFIRE_PLUGIN_PATH"))
+    {
+        setenv("WAYFIRE_PLUGIN_PATH", BENCHMARK_PLUGIN_PATH, 1);
+    }
+
+    bool found = false;
+    for (auto& scenario : get_scenarios())
+    {
+        if ((options.scenario == "all") || (options.scenario == scenario.name))
+        {
+            found = true;
+            run_scenario(scenario, options);
+        }
+    }
+
+    if (!found)
+    {
+        std::cerr << "Unknown scenario " << options.scenario << ", see --list." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
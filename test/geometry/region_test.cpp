@@ -94,3 +94,39 @@ TEST_CASE("region edge expansion handles no-op growth and shrink")
     region.expand_edges(-3);
     REQUIRE(as_boxes(region) == std::vector<wlr_box>{{1, 1, 8, 8}});
 }
+
+TEST_CASE("region simplification merges fragmented rectangles")
+{
+    wf::region_t few;
+    few |= wlr_box{0, 0, 2, 2};
+    few |= wlr_box{10, 10, 2, 2};
+    REQUIRE(as_boxes(wf::simplify_region(few, 4, 0.5)) == as_boxes(few));
+
+    // A row of glyph-sized boxes, like a line of terminal output.
+    wf::region_t row;
+    for (int i = 0; i < 20; i++)
+    {
+        row |= wlr_box{4 * i, 0, 2, 2};
+    }
+
+    REQUIRE(as_boxes(wf::simplify_region(row, 0, 0.5)) == as_boxes(row));
+    REQUIRE(as_boxes(wf::simplify_region(row, 4, 0.5)) == std::vector<wlr_box>{{0, 0, 78, 2}});
+
+    // Two distant rows are not merged together.
+    wf::region_t rows = row | (row + wf::point_t{0, 100});
+    auto simplified   = wf::simplify_region(rows, 4, 0.5);
+    REQUIRE(as_boxes(simplified) == std::vector<wlr_box>{{0, 0, 78, 2}, {0, 100, 78, 2}});
+    REQUIRE((rows ^ simplified).empty());
+}
+
+TEST_CASE("region simplification falls back to the extents")
+{
+    wf::region_t scattered;
+    for (int i = 0; i < 10; i++)
+    {
+        scattered |= wlr_box{10 * i, 10 * i, 1, 1};
+    }
+
+    REQUIRE(as_boxes(wf::simplify_region(scattered, 4, 0.5)) == std::vector<wlr_box>{{0, 0, 91, 91}});
+    REQUIRE(as_boxes(wf::simplify_region(scattered, 16, 0.5)) == as_boxes(scattered));
+}
@@ -0,0 +1,61 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <memory>
+#include <wayfire/alloc-profiling.hpp>
+
+static const wf::alloc_profiling::scope_stats_t *find_scope(
+    const std::vector<wf::alloc_profiling::scope_stats_t>& stats, const std::string& name)
+{
+    for (auto& scope : stats)
+    {
+        if (scope.name == name)
+        {
+            return &scope;
+        }
+    }
+
+    return nullptr;
+}
+
+TEST_CASE("allocations are counted per scope")
+{
+    wf::alloc_profiling::reset();
+    for (int i = 0; i < 2; i++)
+    {
+        wf::alloc_profiling::scope_t outer{"outer"};
+        auto a = std::make_unique<int>(1);
+        {
+            wf::alloc_profiling::scope_t inner{"inner"};
+            auto b = std::make_unique<double>(2.0);
+            auto c = std::make_unique<double>(3.0);
+        }
+    }
+
+    auto stats = wf::alloc_profiling::get_stats();
+    if constexpr (!wf::alloc_profiling::enabled)
+    {
+        CHECK(stats.empty());
+        return;
+    }
+
+    auto outer = find_scope(stats, "outer");
+    auto inner = find_scope(stats, "inner");
+    REQUIRE(outer);
+    REQUIRE(inner);
+
+    CHECK(inner->count == 2);
+    CHECK(inner->allocations == 4);
+    CHECK(inner->bytes == 4 * sizeof(double));
+    CHECK(inner->max_allocations == 2);
+
+    // Nested scopes are included in the outer scope, the bookkeeping of the profiler is not.
+    CHECK(outer->count == 2);
+    CHECK(outer->allocations == 6);
+    CHECK(outer->max_allocations == 3);
+
+    CHECK(stats.front().name == "outer");
+
+    wf::alloc_profiling::reset();
+    CHECK(wf::alloc_profiling::get_stats().empty());
+}
@@ -0,0 +1,113 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <string>
+#include <vector>
+
+#include "../../src/core/seat/keymap-cache.hpp"
+#include "../support/headless-core-harness.hpp"
+
+namespace
+{
+wf::keymap_names_t layout(const std::string& name)
+{
+    return wf::keymap_names_t{"evdev", "pc105", name, "", ""};
+}
+
+const std::vector<std::string> LAYOUTS = {"us", "de", "fr", "it", "es", "pl", "cz", "se", "fi"};
+}
+
+TEST_CASE("Keymaps are shared and the least recently used one is evicted")
+{
+    wf::test::headless_core_harness_t harness;
+    wf::keymap_cache_t cache;
+
+    auto us = cache.get_keymap(layout("us"));
+    REQUIRE(us);
+    CHECK(cache.get_keymap(layout("us")) == us);
+
+    // Keep references, so that evicted keymaps are not freed and their address cannot be reused.
+    std::vector<xkb_keymap*> held;
+    for (auto& name : LAYOUTS)
+    {
+        auto keymap = cache.get_keymap(layout(name));
+        REQUIRE(keymap);
+        held.push_back(xkb_keymap_ref(keymap));
+
+        // Keep "us" recently used.
+        CHECK(cache.get_keymap(layout("us")) == us);
+    }
+
+    // The cache holds 8 keymaps: "us" survived, while "de" was the least recently used one.
+    CHECK(cache.get_keymap(layout("us")) == us);
+    CHECK(cache.get_keymap(layout("de")) != held[1]);
+    CHECK(cache.get_keymap(layout("se")) == held[7]);
+
+    for (auto keymap : held)
+    {
+        xkb_keymap_unref(keymap);
+    }
+}
+
+TEST_CASE("Invalid keymap names are not compiled again")
+{
+    wf::test::headless_core_harness_t harness;
+    wf::keymap_cache_t cache;
+
+    auto fallback = cache.get_keymap({});
+    REQUIRE(fallback);
+
+    auto invalid = layout("no-such-layout");
+    CHECK(cache.get_keymap(invalid) == fallback);
+
+    // The failure is cached, so an asynchronous request completes immediately with the fallback.
+    bool called = false;
+    cache.get_keymap_async(&called, invalid, [&] (xkb_keymap *keymap)
+    {
+        called = true;
+        CHECK(keymap == fallback);
+    });
+    CHECK(called);
+}
+
+TEST_CASE("Keymaps are compiled in the background")
+{
+    wf::test::headless_core_harness_t harness;
+    wf::keymap_cache_t cache;
+
+    int owner_a, owner_b, owner_cancelled, owner_invalid;
+    xkb_keymap *result_a = nullptr;
+    xkb_keymap *result_b = nullptr;
+    xkb_keymap *result_invalid = nullptr;
+    bool cancelled_called = false;
+
+    cache.get_keymap_async(&owner_a, layout("de"), [&] (xkb_keymap *keymap) { result_a = keymap; });
+    cache.get_keymap_async(&owner_b, layout("de"), [&] (xkb_keymap *keymap) { result_b = keymap; });
+    cache.get_keymap_async(&owner_cancelled, layout("fr"), [&] (xkb_keymap*) { cancelled_called = true; });
+    cache.get_keymap_async(&owner_invalid, layout("no-such-layout"),
+        [&] (xkb_keymap *keymap) { result_invalid = keymap; });
+    cache.cancel(&owner_cancelled);
+
+    // Nothing is compiled on the calling thread.
+    CHECK(!result_a);
+    CHECK(!result_b);
+    CHECK(!result_invalid);
+
+    REQUIRE(harness.run_until([&] () { return result_a && result_b && result_invalid; }, 1000));
+    CHECK(result_a == result_b);
+    CHECK(cache.get_keymap(layout("de")) == result_a);
+    CHECK(result_invalid == cache.get_keymap({}));
+
+    // The cancelled request does not call back, even when its keymap is ready.
+    harness.run_until([&] () { return cancelled_called; }, 20);
+    CHECK(!cancelled_called);
+
+    // A new request from the same owner replaces the old one.
+    bool replaced_called = false;
+    xkb_keymap *result_new = nullptr;
+    cache.get_keymap_async(&owner_a, layout("it"), [&] (xkb_keymap*) { replaced_called = true; });
+    cache.get_keymap_async(&owner_a, layout("us"), [&] (xkb_keymap *keymap) { result_new = keymap; });
+    REQUIRE(harness.run_until([&] () { return result_new != nullptr; }, 1000));
+    harness.run_until([&] () { return replaced_called; }, 20);
+    CHECK(!replaced_called);
+}
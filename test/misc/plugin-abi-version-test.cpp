@@ -0,0 +1,24 @@
+#include "wayfire/plugin.hpp"
+#include "../../src/core/plugin-loader.hpp"
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+// Same as what DECLARE_WAYFIRE_PLUGIN emits for the plugins.
+extern "C"
+{
+__attribute__((used, section(WAYFIRE_PLUGIN_ABI_SECTION)))
+const uint32_t wayfirePluginAbiVersion = WAYFIRE_API_ABI_VERSION;
+}
+
+TEST_CASE("ABI version is read from the ELF section")
+{
+    auto version = wf::read_plugin_abi_version("/proc/self/exe");
+    REQUIRE(version.has_value());
+    REQUIRE(*version == WAYFIRE_API_ABI_VERSION);
+}
+
+TEST_CASE("Files without ABI section are rejected")
+{
+    REQUIRE(!wf::read_plugin_abi_version("/nonexistent/libplugin.so").has_value());
+    REQUIRE(!wf::read_plugin_abi_version(TEST_SOURCE_FILE).has_value());
+}
@@ -0,0 +1,91 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include <wayfire/config-backend.hpp>
+#include <wayfire/config/config-manager.hpp>
+#include <wayfire/core.hpp>
+#include <wayfire/signal-definitions.hpp>
+
+#include "../support/headless-core-harness.hpp"
+
+// Provided by the default config backend, which is built into the test.
+extern "C" wf::config_backend_t *newInstance();
+
+namespace
+{
+void write_file(const std::filesystem::path& path, const std::string& contents)
+{
+    std::ofstream out{path, std::ios::trunc};
+    out << contents;
+}
+}
+
+TEST_CASE("reload_config_signal without a diff reports every option as changed")
+{
+    wf::reload_config_signal ev;
+    CHECK(ev.option_changed("core/plugins"));
+    CHECK(ev.section_changed("output"));
+}
+
+TEST_CASE("reload_config_signal matches changed options and sections")
+{
+    wf::reload_config_signal ev;
+    ev.changed_options = std::set<std::string>{"output:DP-1/scale", "input/cursor_size"};
+
+    CHECK(ev.option_changed("input/cursor_size"));
+    CHECK_FALSE(ev.option_changed("input/cursor_theme"));
+    CHECK_FALSE(ev.option_changed("core/plugins"));
+
+    CHECK(ev.section_changed("output"));
+    CHECK(ev.section_changed("output:DP-1"));
+    CHECK_FALSE(ev.section_changed("output:DP-2"));
+    CHECK(ev.section_changed("input"));
+    CHECK_FALSE(ev.section_changed("input-device"));
+    CHECK_FALSE(ev.section_changed("core"));
+}
+
+TEST_CASE("Reloading the config file emits only the options which changed")
+{
+    wf::test::headless_core_harness_t harness{"[workarounds]\nauto_reload_config = true\n"};
+
+    auto dir = std::filesystem::temp_directory_path() / ("wayfire-reload-test-" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+    const auto path = dir / "wayfire.ini";
+    const std::string contents = "[input]\ncursor_size = 24\n\n[core]\nvheight = 3\n";
+    write_file(path, contents);
+
+    wf::config::config_manager_t config;
+    std::unique_ptr<wf::config_backend_t> backend{newInstance()};
+    backend->init(wf::get_core().display, config, path.string());
+    REQUIRE(config.get_option("input/cursor_size"));
+
+    std::vector<std::set<std::string>> reloads;
+    wf::signal::connection_t<wf::reload_config_signal> on_reload = [&] (wf::reload_config_signal *ev)
+    {
+        REQUIRE(ev->changed_options.has_value());
+        reloads.push_back(*ev->changed_options);
+    };
+    wf::get_core().connect(&on_reload);
+
+    // Writing the same contents again changes nothing, so the signal is not emitted.
+    write_file(path, contents);
+    harness.run_until([&] () { return !reloads.empty(); }, 30);
+    CHECK(reloads.empty());
+
+    write_file(path, "[input]\ncursor_size = 32\n\n[core]\nvheight = 3\n");
+    REQUIRE(harness.run_until([&] () { return !reloads.empty(); }));
+    REQUIRE(reloads.size() == 1);
+    CHECK(reloads[0] == std::set<std::string>{"input/cursor_size"});
+    CHECK(config.get_option("input/cursor_size")->get_value_str() == "32");
+
+    backend.reset();
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,76 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/startup-timing.hpp>
+
+TEST_CASE("startup phases are nested and timed")
+{
+    wf::startup::mark("main");
+    wf::startup::begin_phase("outer");
+    {
+        wf::startup::scoped_phase_t inner{"inner"};
+        wf::startup::mark("event");
+    }
+
+    wf::startup::begin_phase("running");
+
+    auto& phases = wf::startup::get_phases();
+    REQUIRE(phases.size() == 5);
+
+    CHECK(phases[0].name == "main");
+    CHECK(phases[0].depth == 0);
+    CHECK(phases[0].finished);
+    CHECK(phases[0].duration.count() == 0);
+
+    CHECK(phases[1].name == "outer");
+    CHECK(phases[1].depth == 0);
+    CHECK(!phases[1].finished);
+
+    CHECK(phases[2].name == "inner");
+    CHECK(phases[2].depth == 1);
+    CHECK(phases[2].finished);
+    CHECK(phases[2].start >= phases[1].start);
+
+    CHECK(phases[3].name == "event");
+    CHECK(phases[3].depth == 2);
+
+    CHECK(phases[4].name == "running");
+    CHECK(phases[4].depth == 1);
+
+    wf::startup::end_phase();
+    wf::startup::end_phase();
+    CHECK(phases[1].finished);
+    CHECK(phases[4].finished);
+    CHECK(phases[1].start + phases[1].duration >= phases[4].start + phases[4].duration);
+    CHECK(!wf::startup::get_time_to_first_frame());
+}
+
+TEST_CASE("asynchronous startup phases end independently of the nested phases")
+{
+    auto& phases = wf::startup::get_phases();
+    const size_t first = phases.size();
+
+    wf::startup::begin_phase("outer");
+    wf::startup::begin_async_phase("async");
+    wf::startup::begin_phase("inner");
+    wf::startup::end_phase();
+    wf::startup::end_phase();
+
+    REQUIRE(phases.size() == first + 3);
+    CHECK(phases[first].finished);
+    CHECK(phases[first + 1].name == "async");
+    CHECK(phases[first + 1].depth == 1);
+    CHECK(!phases[first + 1].finished);
+    CHECK(phases[first + 2].name == "inner");
+    CHECK(phases[first + 2].depth == 1);
+    CHECK(phases[first + 2].finished);
+
+    wf::startup::end_async_phase("async");
+    CHECK(phases[first + 1].finished);
+    auto& async = phases[first + 1];
+    CHECK(async.start + async.duration >= phases[first].start + phases[first].duration);
+
+    // Ending it again does nothing.
+    wf::startup::end_async_phase("async");
+    CHECK(phases.size() == first + 3);
+}
@@ -0,0 +1,126 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <ctime>
+#include <map>
+
+#include <wayfire/core.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/util.hpp>
+#include <wayfire/nonstd/wlroots-full.hpp>
+
+#include "../support/headless-core-harness.hpp"
+#include "../support/wayland-xdg-client.hpp"
+#include "fifo-v1-client-protocol.h"
+#include "commit-timing-v1-client-protocol.h"
+
+namespace
+{
+int64_t get_time_nsec()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1'000'000'000ll + now.tv_nsec;
+}
+
+/**
+ * Records when each surface state was applied, and how many frames the output had presented by then.
+ */
+struct commit_recorder_t
+{
+    struct applied_t
+    {
+        int64_t time;
+        int presents;
+    };
+
+    std::map<uint32_t, applied_t> applied;
+    int presents = 0;
+
+    wlr_surface *surface;
+    wf::wl_listener_wrapper on_commit;
+    wf::wl_listener_wrapper on_present;
+
+    commit_recorder_t(wlr_surface *surface, wf::output_t *output)
+    {
+        this->surface = surface;
+        on_commit.set_callback([=] (void*)
+        {
+            applied[this->surface->current.seq] = {get_time_nsec(), presents};
+        });
+        on_commit.connect(&surface->events.commit);
+
+        on_present.set_callback([=] (void*) { ++presents; });
+        on_present.connect(&output->handle->events.present);
+    }
+};
+}
+
+TEST_CASE("fifo commits wait until the barrier is presented")
+{
+    wf::test::headless_core_harness_t harness;
+    wf::test::wayland_xdg_client_t client{harness.socket_name()};
+    auto view = wf::test::map_toplevel(harness, client, "frame pacing test");
+    REQUIRE(view);
+
+    auto manager = static_cast<wp_fifo_manager_v1*>(client.bind_global(&wp_fifo_manager_v1_interface, 1));
+    REQUIRE(manager);
+    auto fifo = wp_fifo_manager_v1_get_fifo(manager, client.get_surface());
+
+    auto surface = view->get_wlr_surface();
+    commit_recorder_t recorder{surface, harness.output()};
+    const uint32_t first = surface->current.seq + 1;
+
+    // Queue three frames at once, each waiting for the barrier of the previous one.
+    for (int i = 0; i < 3; i++)
+    {
+        wp_fifo_v1_wait_barrier(fifo);
+        wp_fifo_v1_set_barrier(fifo);
+        client.attach_and_commit(200, 120);
+    }
+
+    REQUIRE(harness.run_until([&] () { return recorder.applied.count(first + 2); }, 2000));
+
+    // The first frame does not wait, since no barrier was set yet. Each subsequent frame is applied only
+    // after the output presented a frame with the content of the previous one.
+    REQUIRE(recorder.applied.count(first));
+    CHECK(recorder.applied[first + 1].presents > recorder.applied[first].presents);
+    CHECK(recorder.applied[first + 2].presents > recorder.applied[first + 1].presents);
+
+    wp_fifo_v1_destroy(fifo);
+    wp_fifo_manager_v1_destroy(manager);
+}
+
+TEST_CASE("Timed commits are not applied before their target time")
+{
+    wf::test::headless_core_harness_t harness;
+    wf::test::wayland_xdg_client_t client{harness.socket_name()};
+    auto view = wf::test::map_toplevel(harness, client, "frame pacing test");
+    REQUIRE(view);
+
+    auto manager = static_cast<wp_commit_timing_manager_v1*>(
+        client.bind_global(&wp_commit_timing_manager_v1_interface, 1));
+    REQUIRE(manager);
+    auto timer = wp_commit_timing_manager_v1_get_timer(manager, client.get_surface());
+
+    auto surface = view->get_wlr_surface();
+    commit_recorder_t recorder{surface, harness.output()};
+    const uint32_t seq = surface->current.seq + 1;
+
+    const int64_t target = get_time_nsec() + 100'000'000;
+    const int64_t target_sec = target / 1'000'000'000;
+    wp_commit_timer_v1_set_timestamp(timer, target_sec >> 32, target_sec & 0xffffffff,
+        target % 1'000'000'000);
+    client.attach_and_commit(200, 120);
+
+    REQUIRE(harness.run_until([&] () { return recorder.applied.count(seq); }, 2000));
+
+    // The update is released in the repaint for the first vblank at or after the target, which starts at
+    // most one refresh cycle (60Hz on the headless backend) before the target.
+    const int64_t max_refresh_nsec = 17'000'000;
+    CHECK(recorder.applied[seq].time >= target - max_refresh_nsec);
+
+    wp_commit_timer_v1_destroy(timer);
+    wp_commit_timing_manager_v1_destroy(manager);
+}
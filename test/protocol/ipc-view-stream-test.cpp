@@ -0,0 +1,145 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <vector>
+
+#include <wayfire/core.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/toplevel-view.hpp>
+
+#include "ipc-view-stream.hpp"
+
+#include "../support/headless-core-harness.hpp"
+#include "../support/wayland-xdg-client.hpp"
+
+namespace
+{
+/** An IPC client which records the events sent to it. */
+class recording_client_t : public wf::ipc::client_interface_t
+{
+  public:
+    std::vector<wf::json_t> events;
+
+    bool send_json(wf::json_t json) override
+    {
+        events.push_back(json);
+        return true;
+    }
+
+    /** All changes received so far, in order. */
+    std::vector<wf::json_t> changes()
+    {
+        std::vector<wf::json_t> result;
+        for (auto& event : events)
+        {
+            for (size_t i = 0; i < event["changes"].size(); i++)
+            {
+                result.push_back(event["changes"][i]);
+            }
+        }
+
+        return result;
+    }
+};
+
+struct view_stream_t
+{
+    wf::ipc::method_repository_t repository;
+    wf::ipc_rules_view_stream_methods_t methods;
+
+    view_stream_t()
+    {
+        methods.init_view_stream(&repository);
+    }
+
+    ~view_stream_t()
+    {
+        methods.fini_view_stream(&repository);
+    }
+
+    wf::json_t subscribe(recording_client_t& client)
+    {
+        return repository.call_method("window-rules/list-views/subscribe", {}, &client);
+    }
+
+    wf::json_t unsubscribe(recording_client_t& client)
+    {
+        return repository.call_method("window-rules/list-views/unsubscribe", {}, &client);
+    }
+};
+}
+
+TEST_CASE("view list subscribers receive the snapshot and then diffs")
+{
+    wf::test::headless_core_harness_t harness;
+    view_stream_t stream;
+    recording_client_t ipc_client;
+
+    auto snapshot = stream.subscribe(ipc_client);
+    REQUIRE(snapshot["result"].as_string() == "ok");
+    CHECK(snapshot["views"].size() == 0);
+    const uint64_t first_sequence = snapshot["sequence"].as_uint64();
+    CHECK(stream.subscribe(ipc_client).has_member("error"));
+
+    wf::test::wayland_xdg_client_t client{harness.socket_name()};
+    auto view = wf::test::map_toplevel(harness, client, "view stream test");
+    REQUIRE(view);
+    REQUIRE(harness.run_until([&] () { return !ipc_client.changes().empty(); }));
+
+    // A burst of signals on map results in a single diff adding the view.
+    auto changes = ipc_client.changes();
+    REQUIRE(ipc_client.events.size() == 1);
+    CHECK(ipc_client.events[0]["event"].as_string() == "view-list-diff");
+    CHECK(ipc_client.events[0]["sequence"].as_uint64() == first_sequence + 1);
+    REQUIRE(changes.size() == 1);
+    CHECK(changes[0]["change"].as_string() == "added");
+    CHECK(changes[0]["id"].as_uint64() == view->get_id());
+    CHECK(changes[0]["view"]["title"].as_string() == "view stream test");
+
+    // Only the changed fields are sent.
+    view->move(100, 50);
+    REQUIRE(harness.run_until([&] () { return ipc_client.changes().size() == 2; }));
+    auto update = ipc_client.changes()[1];
+    CHECK(update["change"].as_string() == "updated");
+    CHECK(update["fields"].has_member("geometry"));
+    CHECK(!update["fields"].has_member("title"));
+    CHECK(!update["fields"].has_member("app-id"));
+    CHECK(ipc_client.events.back()["sequence"].as_uint64() == first_sequence + 2);
+
+    client.destroy_toplevel();
+    REQUIRE(harness.run_until([&]
+    {
+        auto all = ipc_client.changes();
+        return !all.empty() && (all.back()["change"].as_string() == "removed");
+    }));
+    CHECK(ipc_client.changes().back()["id"].as_uint64() == view->get_id());
+}
+
+TEST_CASE("view list subscribers stop receiving diffs after unsubscribing or disconnecting")
+{
+    wf::test::headless_core_harness_t harness;
+    view_stream_t stream;
+    recording_client_t unsubscribed, disconnected, subscribed;
+
+    CHECK(stream.unsubscribe(unsubscribed).has_member("error"));
+    REQUIRE(stream.subscribe(unsubscribed)["result"].as_string() == "ok");
+    REQUIRE(stream.subscribe(disconnected)["result"].as_string() == "ok");
+    REQUIRE(stream.subscribe(subscribed)["result"].as_string() == "ok");
+
+    CHECK(stream.unsubscribe(unsubscribed)["result"].as_string() == "ok");
+    wf::ipc::client_disconnected_signal ev;
+    ev.client = &disconnected;
+    stream.repository.emit(&ev);
+
+    wf::test::wayland_xdg_client_t client{harness.socket_name()};
+    REQUIRE(wf::test::map_toplevel(harness, client, "view stream test"));
+    REQUIRE(harness.run_until([&] () { return !subscribed.changes().empty(); }));
+    CHECK(unsubscribed.events.empty());
+    CHECK(disconnected.events.empty());
+
+    // A new subscriber gets the current views in its snapshot.
+    recording_client_t late;
+    auto snapshot = stream.subscribe(late);
+    CHECK(snapshot["views"].size() == 1);
+    CHECK(snapshot["sequence"].as_uint64() == subscribed.events.back()["sequence"].as_uint64());
+}
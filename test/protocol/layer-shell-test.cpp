@@ -2,6 +2,7 @@
 #include <doctest/doctest.h>
 
 #include <wayfire/core.hpp>
+#include <wayfire/output.hpp>
 #include <wayfire/seat.hpp>
 #include <wayfire/signal-definitions.hpp>
 
@@ -97,3 +98,65 @@ TEST_CASE("layer-shell popup with keyboard none does not steal focus")
 
     CHECK(wf::get_core().seat->get_active_view() == focused_view);
 }
+
+TEST_CASE("layer-shell commits without layout changes are not reconfigured")
+{
+    wf::test::headless_core_harness_t harness;
+
+    std::vector<wayfire_view> mapped;
+    wf::signal::connection_t<wf::view_mapped_signal> on_map = [&] (wf::view_mapped_signal *ev)
+    {
+        mapped.push_back(ev->view);
+    };
+
+    wf::get_core().connect(&on_map);
+
+    int workarea_changes = 0;
+    wf::signal::connection_t<wf::workarea_changed_signal> on_workarea_changed =
+        [&] (wf::workarea_changed_signal*)
+    {
+        workarea_changes++;
+    };
+
+    harness.output()->connect(&on_workarea_changed);
+
+    wf::test::wayland_layer_shell_client_t layer_client{harness.socket_name()};
+    REQUIRE(harness.run_until([&]
+    {
+        layer_client.dispatch_once();
+        return layer_client.has_required_globals();
+    }));
+
+    layer_client.create_layer_surface("regression-layer-shell-commits",
+        LAYER_OVERLAY,
+        LAYER_KEYBOARD_NONE,
+        120, 40,
+        LAYER_ANCHOR_BOTTOM | LAYER_ANCHOR_RIGHT);
+    REQUIRE(harness.run_until([&]
+    {
+        layer_client.dispatch_once();
+        return layer_client.has_pending_layer_configure();
+    }));
+
+    layer_client.attach_layer_and_commit(120, 40);
+    REQUIRE(harness.run_until([&]
+    {
+        layer_client.dispatch_once();
+        return mapped.size() == 1;
+    }));
+
+    const uint32_t mapped_serial = layer_client.last_layer_configure_serial();
+    for (int i = 0; i < 5; i++)
+    {
+        layer_client.attach_layer_and_commit(120, 40);
+        int iterations = 0;
+        REQUIRE(harness.run_until([&]
+        {
+            layer_client.dispatch_once();
+            return ++iterations >= 10;
+        }));
+    }
+
+    CHECK(layer_client.last_layer_configure_serial() == mapped_serial);
+    CHECK(workarea_changes == 0);
+}
@@ -0,0 +1,73 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/core.hpp>
+#include <wayfire/signal-definitions.hpp>
+
+#include <map>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "../support/headless-core-harness.hpp"
+
+TEST_CASE("run() starts commands with the compositor environment and reaps them")
+{
+    wf::test::headless_core_harness_t harness;
+
+    std::map<pid_t, int> exited;
+    wf::signal::connection_t<wf::command_exited_signal> on_exit = [&] (wf::command_exited_signal *ev)
+    {
+        exited[ev->pid] = ev->status;
+    };
+    wf::get_core().connect(&on_exit);
+
+    const std::string socket = harness.socket_name();
+    pid_t ok = wf::get_core().run("test \"$WAYLAND_DISPLAY\" = '" + socket + "'");
+    pid_t fail = wf::get_core().run("exit 3");
+    REQUIRE(ok > 0);
+    REQUIRE(fail > 0);
+
+    REQUIRE(harness.run_until([&] { return exited.count(ok) && exited.count(fail); }));
+    CHECK(WIFEXITED(exited[ok]));
+    CHECK(WEXITSTATUS(exited[ok]) == 0);
+    CHECK(WIFEXITED(exited[fail]));
+    CHECK(WEXITSTATUS(exited[fail]) == 3);
+
+    // The children have been reaped, so no zombies are left behind.
+    CHECK(waitpid(ok, nullptr, WNOHANG) == -1);
+    CHECK(waitpid(fail, nullptr, WNOHANG) == -1);
+}
+
+TEST_CASE("Commands get the original file descriptor limit without changing the compositor's")
+{
+    struct rlimit original;
+    REQUIRE(getrlimit(RLIMIT_NOFILE, &original) == 0);
+
+    wf::test::headless_core_harness_t harness;
+    struct rlimit raised;
+    REQUIRE(getrlimit(RLIMIT_NOFILE, &raised) == 0);
+
+    std::map<pid_t, int> exited;
+    wf::signal::connection_t<wf::command_exited_signal> on_exit = [&] (wf::command_exited_signal *ev)
+    {
+        exited[ev->pid] = ev->status;
+    };
+    wf::get_core().connect(&on_exit);
+
+    const std::string expected = (original.rlim_cur == RLIM_INFINITY) ?
+        "unlimited" : std::to_string(original.rlim_cur);
+    // The command is a list, which runs in the process whose PID run() returns.
+    pid_t pid = wf::get_core().run(
+        "test \"$(ulimit -S -n)\" = '" + expected + "' || exit 1; exit $(($$ % 100 + 10))");
+    REQUIRE(pid > 0);
+
+    // The limit of the compositor itself is never lowered.
+    struct rlimit current;
+    REQUIRE(getrlimit(RLIMIT_NOFILE, &current) == 0);
+    CHECK(current.rlim_cur == raised.rlim_cur);
+
+    REQUIRE(harness.run_until([&] { return exited.count(pid); }));
+    CHECK(WIFEXITED(exited[pid]));
+    CHECK(WEXITSTATUS(exited[pid]) == pid % 100 + 10);
+}
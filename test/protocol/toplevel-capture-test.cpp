@@ -0,0 +1,240 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <wayfire/core.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/nonstd/wlroots-full.hpp>
+#include <wayland-client-protocol.h>
+
+#include "../support/headless-core-harness.hpp"
+#include "../support/wayland-xdg-client.hpp"
+#include "ext-foreign-toplevel-list-v1-client-protocol.h"
+#include "ext-image-capture-source-v1-client-protocol.h"
+#include "ext-image-copy-capture-v1-client-protocol.h"
+
+extern "C"
+{
+#include <wlr/types/wlr_ext_foreign_toplevel_list_v1.h>
+}
+
+namespace
+{
+/** The client side of a capture session, which records the events it receives. */
+struct capture_session_t
+{
+    ext_image_copy_capture_session_v1 *session;
+    int width  = 0;
+    int height = 0;
+    uint32_t shm_format = 0;
+    bool has_constraints = false;
+    bool stopped = false;
+
+    wl_buffer *buffer = nullptr;
+    ext_image_copy_capture_frame_v1 *frame = nullptr;
+    int damage_rects = 0;
+    bool ready  = false;
+    bool failed = false;
+
+    static constexpr ext_image_copy_capture_session_v1_listener session_listener = {
+        .buffer_size = [] (void *data, ext_image_copy_capture_session_v1*, uint32_t width, uint32_t height)
+        {
+            auto self = static_cast<capture_session_t*>(data);
+            self->width  = width;
+            self->height = height;
+        },
+        .shm_format = [] (void *data, ext_image_copy_capture_session_v1*, uint32_t format)
+        {
+            static_cast<capture_session_t*>(data)->shm_format = format;
+        },
+        .dmabuf_device = [] (void*, ext_image_copy_capture_session_v1*, wl_array*) {},
+        .dmabuf_format = [] (void*, ext_image_copy_capture_session_v1*, uint32_t, wl_array*) {},
+        .done = [] (void *data, ext_image_copy_capture_session_v1*)
+        {
+            static_cast<capture_session_t*>(data)->has_constraints = true;
+        },
+        .stopped = [] (void *data, ext_image_copy_capture_session_v1*)
+        {
+            static_cast<capture_session_t*>(data)->stopped = true;
+        },
+    };
+
+    static constexpr ext_image_copy_capture_frame_v1_listener frame_listener = {
+        .transform = [] (void*, ext_image_copy_capture_frame_v1*, uint32_t) {},
+        .damage    = [] (void *data, ext_image_copy_capture_frame_v1*, int32_t, int32_t, int32_t, int32_t)
+        {
+            ++static_cast<capture_session_t*>(data)->damage_rects;
+        },
+        .presentation_time = [] (void*, ext_image_copy_capture_frame_v1*, uint32_t, uint32_t, uint32_t) {},
+        .ready = [] (void *data, ext_image_copy_capture_frame_v1*)
+        {
+            static_cast<capture_session_t*>(data)->ready = true;
+        },
+        .failed = [] (void *data, ext_image_copy_capture_frame_v1*, uint32_t)
+        {
+            static_cast<capture_session_t*>(data)->failed = true;
+        },
+    };
+
+    capture_session_t(ext_image_copy_capture_manager_v1 *manager, ext_image_capture_source_v1 *source)
+    {
+        session = ext_image_copy_capture_manager_v1_create_session(manager, source, 0);
+        ext_image_copy_capture_session_v1_add_listener(session, &session_listener, this);
+    }
+
+    ~capture_session_t()
+    {
+        if (frame)
+        {
+            ext_image_copy_capture_frame_v1_destroy(frame);
+        }
+
+        if (buffer)
+        {
+            wl_buffer_destroy(buffer);
+        }
+
+        ext_image_copy_capture_session_v1_destroy(session);
+    }
+
+    void create_buffer(wl_shm *shm)
+    {
+        const int stride  = width * 4;
+        const size_t size = stride * height;
+        int fd = memfd_create("wayfire-capture-test", MFD_CLOEXEC);
+        REQUIRE(fd >= 0);
+        REQUIRE(ftruncate(fd, size) == 0);
+
+        auto pool = wl_shm_create_pool(shm, fd, size);
+        buffer = wl_shm_pool_create_buffer(pool, 0, width, height, stride, shm_format);
+        wl_shm_pool_destroy(pool);
+        close(fd);
+    }
+
+    /** Request a new frame, which is sent once the source has damage. */
+    void capture()
+    {
+        if (frame)
+        {
+            ext_image_copy_capture_frame_v1_destroy(frame);
+        }
+
+        damage_rects = 0;
+        ready  = false;
+        failed = false;
+        frame  = ext_image_copy_capture_session_v1_create_frame(session);
+        ext_image_copy_capture_frame_v1_add_listener(frame, &frame_listener, this);
+        ext_image_copy_capture_frame_v1_attach_buffer(frame, buffer);
+        ext_image_copy_capture_frame_v1_damage_buffer(frame, 0, 0, width, height);
+        ext_image_copy_capture_frame_v1_capture(frame);
+    }
+};
+
+struct toplevel_listener_t
+{
+    ext_foreign_toplevel_handle_v1 *handle = nullptr;
+
+    static constexpr ext_foreign_toplevel_list_v1_listener listener = {
+        .toplevel = [] (void *data, ext_foreign_toplevel_list_v1*, ext_foreign_toplevel_handle_v1 *handle)
+        {
+            static_cast<toplevel_listener_t*>(data)->handle = handle;
+        },
+        .finished = [] (void*, ext_foreign_toplevel_list_v1*) {},
+    };
+};
+}
+
+TEST_CASE("Toplevel capture sends frames on view commits and stops on unmap")
+{
+    wf::test::headless_core_harness_t harness;
+
+    // The foreign toplevel list is provided by a plugin, so the test announces the view itself.
+    auto toplevel_list = wlr_ext_foreign_toplevel_list_v1_create(wf::get_core().display, 1);
+    wf::test::wayland_xdg_client_t client{harness.socket_name()};
+
+    wayfire_view view = wf::test::map_toplevel(harness, client, "capture test");
+    REQUIRE(view);
+
+    wlr_ext_foreign_toplevel_handle_v1_state state = {
+        .title  = "capture test",
+        .app_id = "org.wayfire.Test",
+    };
+    auto server_handle = wlr_ext_foreign_toplevel_handle_v1_create(toplevel_list, &state);
+    server_handle->data = view.get();
+
+    auto list = static_cast<ext_foreign_toplevel_list_v1*>(
+        client.bind_global(&ext_foreign_toplevel_list_v1_interface, 1));
+    auto source_manager = static_cast<ext_foreign_toplevel_image_capture_source_manager_v1*>(
+        client.bind_global(&ext_foreign_toplevel_image_capture_source_manager_v1_interface, 1));
+    auto copy_manager = static_cast<ext_image_copy_capture_manager_v1*>(
+        client.bind_global(&ext_image_copy_capture_manager_v1_interface, 1));
+    auto shm = static_cast<wl_shm*>(client.bind_global(&wl_shm_interface, 1));
+    REQUIRE(list);
+    REQUIRE(source_manager);
+    REQUIRE(copy_manager);
+    REQUIRE(shm);
+
+    toplevel_listener_t toplevels;
+    ext_foreign_toplevel_list_v1_add_listener(list, &toplevel_listener_t::listener, &toplevels);
+    REQUIRE(harness.run_until([&]
+    {
+        client.dispatch_once();
+        return toplevels.handle != nullptr;
+    }));
+
+    auto source = ext_foreign_toplevel_image_capture_source_manager_v1_create_source(source_manager,
+        toplevels.handle);
+    capture_session_t session{copy_manager, source};
+    REQUIRE(harness.run_until([&]
+    {
+        client.dispatch_once();
+        return session.has_constraints;
+    }));
+
+    CHECK(session.width == 200);
+    CHECK(session.height == 120);
+    session.create_buffer(shm);
+
+    // The first frame contains the whole view.
+    session.capture();
+    REQUIRE(harness.run_until([&]
+    {
+        client.dispatch_once();
+        return session.ready || session.failed;
+    }));
+    CHECK(session.ready);
+    CHECK(session.damage_rects > 0);
+
+    // Without damage, the next frame is not sent.
+    session.capture();
+    harness.run_until([&]
+    {
+        client.dispatch_once();
+        return session.ready || session.failed;
+    }, 20);
+    CHECK(!session.ready);
+    CHECK(!session.failed);
+
+    // A commit of the view damages the capture.
+    client.commit_frame(200, 120);
+    REQUIRE(harness.run_until([&]
+    {
+        client.dispatch_once();
+        return session.ready || session.failed;
+    }));
+    CHECK(session.ready);
+    CHECK(session.damage_rects > 0);
+
+    // Unmapping the view destroys the source, which stops the session.
+    client.destroy_toplevel();
+    REQUIRE(harness.run_until([&]
+    {
+        client.dispatch_once();
+        return session.stopped;
+    }));
+
+    wlr_ext_foreign_toplevel_handle_v1_destroy(server_handle);
+    ext_image_capture_source_v1_destroy(source);
+}
@@ -0,0 +1,120 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/core.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/toplevel-view.hpp>
+#include <wayfire/window-manager.hpp>
+
+#include "../../src/core/vrr-policy.hpp"
+#include "../support/headless-core-harness.hpp"
+#include "../support/wayland-xdg-client.hpp"
+#include "content-type-v1-client-protocol.h"
+
+namespace
+{
+void set_fullscreen(wf::test::headless_core_harness_t& harness, wf::test::wayland_xdg_client_t& client,
+    wayfire_toplevel_view view, bool fullscreen)
+{
+    wf::get_core().default_wm->fullscreen_request(view, harness.output(), fullscreen);
+    REQUIRE(harness.run_until([&]
+    {
+        client.dispatch_once();
+        if (view->toplevel()->current().fullscreen == fullscreen)
+        {
+            return true;
+        }
+
+        const int width  = client.configured_width() ?: 200;
+        const int height = client.configured_height() ?: 120;
+        client.commit_frame(width, height);
+        return false;
+    }));
+}
+}
+
+TEST_CASE("The content policy enables adaptive sync for fullscreen games and videos")
+{
+    wf::test::headless_core_harness_t harness;
+    wf::test::wayland_xdg_client_t client{harness.socket_name()};
+
+    int changes = 0;
+    wf::vrr_policy_t policy{harness.output(), [&] { ++changes; }};
+    CHECK(!policy.wants_vrr());
+
+    auto view = wf::test::map_toplevel(harness, client, "vrr policy test");
+    REQUIRE(view);
+    auto manager = static_cast<wp_content_type_manager_v1*>(
+        client.bind_global(&wp_content_type_manager_v1_interface, 1));
+    REQUIRE(manager);
+    auto content_type = wp_content_type_manager_v1_get_surface_content_type(manager, client.get_surface());
+
+    // Games which are not fullscreen do not get adaptive sync.
+    wp_content_type_v1_set_content_type(content_type, WP_CONTENT_TYPE_V1_TYPE_GAME);
+    client.commit_surface();
+    harness.run_until([&] () { client.dispatch_once(); return changes > 0; }, 20);
+    CHECK(!policy.wants_vrr());
+    CHECK(changes == 0);
+
+    set_fullscreen(harness, client, view, true);
+    REQUIRE(harness.run_until([&] () { return changes == 1; }));
+    CHECK(policy.wants_vrr());
+
+    // The content type is double-buffered, so it takes effect on the next commit.
+    wp_content_type_v1_set_content_type(content_type, WP_CONTENT_TYPE_V1_TYPE_PHOTO);
+    client.commit_surface();
+    REQUIRE(harness.run_until([&] () { client.dispatch_once(); return changes == 2; }));
+    CHECK(!policy.wants_vrr());
+
+    wp_content_type_v1_set_content_type(content_type, WP_CONTENT_TYPE_V1_TYPE_VIDEO);
+    client.commit_surface();
+    REQUIRE(harness.run_until([&] () { client.dispatch_once(); return changes == 3; }));
+    CHECK(policy.wants_vrr());
+
+    set_fullscreen(harness, client, view, false);
+    REQUIRE(harness.run_until([&] () { return changes == 4; }));
+    CHECK(!policy.wants_vrr());
+
+    wp_content_type_v1_destroy(content_type);
+    wp_content_type_manager_v1_destroy(manager);
+}
+
+TEST_CASE("Idle outputs keep adaptive sync enabled and lengthen their frame interval")
+{
+    wf::test::headless_core_harness_t harness;
+    wf::test::wayland_xdg_client_t client{harness.socket_name()};
+
+    int changes = 0;
+    wf::vrr_policy_t policy{harness.output(), [&] { ++changes; }};
+    policy.set_idle_timeout(100);
+    REQUIRE(harness.run_until([&] () { return changes == 1; }));
+    CHECK(policy.wants_vrr());
+
+    REQUIRE(wf::test::map_toplevel(harness, client, "vrr policy test"));
+
+    // Nothing is drawn, so the output becomes idle. Adaptive sync is not toggled.
+    REQUIRE(harness.run_until([&] () { return policy.is_idle(); }));
+    CHECK(policy.wants_vrr());
+
+    // A single frame does not end the idle state.
+    client.commit_frame(200, 120);
+    harness.run_until([&] () { return !policy.is_idle(); }, 10);
+    CHECK(policy.is_idle());
+
+    // Frames shown as fast as possible do.
+    REQUIRE(harness.run_until([&]
+    {
+        client.commit_frame(200, 120);
+        return !policy.is_idle();
+    }, 500));
+    CHECK(policy.wants_vrr());
+
+    harness.run_until([&] () { return false; }, 20);
+    CHECK(changes == 1);
+
+    policy.set_idle_timeout(0);
+    REQUIRE(harness.run_until([&] () { return changes == 2; }));
+    CHECK(!policy.wants_vrr());
+    CHECK(!policy.is_idle());
+}
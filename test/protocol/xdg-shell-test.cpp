@@ -3,6 +3,8 @@
 
 #include <wayfire/core.hpp>
 #include <wayfire/signal-definitions.hpp>
+#include <wayfire/toplevel-view.hpp>
+#include <wayfire/unstable/wlr-surface-node.hpp>
 
 #include <vector>
 
@@ -56,3 +58,41 @@ TEST_CASE("xdg toplevel maps after configure ack and buffer commit")
     REQUIRE(harness.run_until([&] () { return unmapped.size() == 1; }));
     CHECK(unmapped.front() == mapped.front());
 }
+
+static wf::scene::wlr_surface_node_t *find_surface_node(const wf::scene::node_ptr& root)
+{
+    if (auto surface_node = dynamic_cast<wf::scene::wlr_surface_node_t*>(root.get()))
+    {
+        return surface_node;
+    }
+
+    for (auto& child : root->get_children())
+    {
+        if (auto surface_node = find_surface_node(child))
+        {
+            return surface_node;
+        }
+    }
+
+    return nullptr;
+}
+
+TEST_CASE("hidden xdg toplevels are throttled")
+{
+    wf::test::headless_core_harness_t harness;
+
+    wf::test::wayland_xdg_client_t client{harness.socket_name()};
+    auto view = wf::test::map_toplevel(harness, client, "throttle test");
+    REQUIRE(view);
+
+    auto surface_node = find_surface_node(view->get_surface_root_node());
+    REQUIRE(surface_node);
+    CHECK(!surface_node->is_throttled());
+
+    // Move the view outside of the output, where no render instance can see it.
+    view->move(5000, 5000);
+    REQUIRE(harness.run_until([&] () { return surface_node->is_throttled(); }));
+
+    view->move(0, 0);
+    REQUIRE(harness.run_until([&] () { return !surface_node->is_throttled(); }));
+}
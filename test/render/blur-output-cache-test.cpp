@@ -0,0 +1,58 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/core.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/region.hpp>
+#include <wayfire/render-manager.hpp>
+
+#include "blur-output-cache.hpp"
+#include "../support/headless-core-harness.hpp"
+
+namespace
+{
+bool same_region(const wf::region_t& a, const wf::region_t& b)
+{
+    return (a ^ b).empty() && (b ^ a).empty();
+}
+}
+
+TEST_CASE("Damage on one output invalidates only the blur cache of that output")
+{
+    wf::test::headless_core_harness_t harness;
+    auto first  = harness.output();
+    auto second = harness.add_output();
+    REQUIRE(second);
+
+    wf::scene::blur_output_caches_t caches;
+    auto first_cache  = caches.get(first);
+    auto second_cache = caches.get(second);
+    REQUIRE(first_cache != second_cache);
+    CHECK(caches.get(first) == first_cache);
+
+    const wf::region_t cached{wf::geometry_t{0, 0, 400, 300}};
+    first_cache->valid  = cached;
+    second_cache->valid = cached;
+
+    // Damage from the view itself does not change what is behind it.
+    first_cache->pushing_own_damage = true;
+    first->render->damage(wf::geometry_t{100, 100, 50, 50});
+    first_cache->pushing_own_damage = false;
+    CHECK(first_cache->background_damage.empty());
+
+    first->render->damage(wf::geometry_t{100, 100, 50, 50});
+    CHECK(!first_cache->background_damage.empty());
+    CHECK(second_cache->background_damage.empty());
+
+    first_cache->invalidate_background_damage({0, 0}, 8);
+    second_cache->invalidate_background_damage({0, 0}, 8);
+    CHECK(same_region(first_cache->valid, cached ^ wf::geometry_t{92, 92, 66, 66}));
+    CHECK(same_region(second_cache->valid, cached));
+    CHECK(first_cache->background_damage.empty());
+
+    // The damage is in output-local coordinates, which are shifted to the coordinates of the node.
+    second->render->damage(wf::geometry_t{10, 10, 20, 20});
+    second_cache->invalidate_background_damage({100, 50}, 0);
+    CHECK(same_region(second_cache->valid, cached ^ wf::geometry_t{110, 60, 20, 20}));
+    CHECK(same_region(first_cache->valid, cached ^ wf::geometry_t{92, 92, 66, 66}));
+}
@@ -0,0 +1,90 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <map>
+#include <memory>
+
+#include <wayfire/core.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/scene-operations.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/toplevel-view.hpp>
+
+#include "../support/headless-core-harness.hpp"
+#include "../support/wayland-xdg-client.hpp"
+
+namespace
+{
+/** A node without contents, which counts how often each output generates render instances for it. */
+class counting_node_t : public wf::scene::node_t
+{
+  public:
+    std::map<wf::output_t*, int> generated;
+
+    counting_node_t() : node_t(false)
+    {}
+
+    void gen_render_instances(std::vector<wf::scene::render_instance_uptr>& instances,
+        wf::scene::damage_callback push_damage, wf::output_t *output) override
+    {
+        ++generated[output];
+    }
+};
+}
+
+TEST_CASE("Updates below one output do not regenerate the instances of other outputs")
+{
+    wf::test::headless_core_harness_t harness;
+    auto first = harness.output();
+    auto second = harness.add_output();
+    REQUIRE(second);
+
+    // Outside of the output nodes, so both outputs generate instances for it.
+    auto counter = std::make_shared<counting_node_t>();
+    wf::scene::add_front(wf::get_core().scene()->layers[(size_t)wf::scene::layer::TOP], counter);
+    REQUIRE(counter->generated[first] > 0);
+    REQUIRE(counter->generated[second] > 0);
+
+    auto before = counter->generated;
+    auto child  = std::make_shared<wf::scene::node_t>(false);
+    wf::scene::add_front(first->node_for_layer(wf::scene::layer::TOP), child);
+    CHECK(counter->generated[first] == before[first] + 1);
+    CHECK(counter->generated[second] == before[second]);
+
+    before = counter->generated;
+    wf::scene::remove_child(child);
+    CHECK(counter->generated[first] == before[first] + 1);
+    CHECK(counter->generated[second] == before[second]);
+
+    // Updates outside of the output nodes still reach every output.
+    before = counter->generated;
+    wf::scene::remove_child(counter);
+    wf::scene::add_front(wf::get_core().scene()->layers[(size_t)wf::scene::layer::TOP], counter);
+    CHECK(counter->generated[first] > before[first]);
+    CHECK(counter->generated[second] > before[second]);
+    wf::scene::remove_child(counter);
+}
+
+TEST_CASE("Moving a view to another output regenerates the instances of both outputs")
+{
+    wf::test::headless_core_harness_t harness;
+    auto first = harness.output();
+    auto second = harness.add_output();
+    REQUIRE(second);
+
+    wf::test::wayland_xdg_client_t client{harness.socket_name()};
+    auto view = wf::test::map_toplevel(harness, client, "output instances test");
+    REQUIRE(view);
+    REQUIRE(view->get_output() == first);
+
+    auto counter = std::make_shared<counting_node_t>();
+    wf::scene::add_front(wf::get_core().scene()->layers[(size_t)wf::scene::layer::TOP], counter);
+    auto before = counter->generated;
+
+    wf::move_view_to_output(view, second, true);
+    harness.roundtrip();
+    CHECK(view->get_output() == second);
+    CHECK(counter->generated[first] > before[first]);
+    CHECK(counter->generated[second] > before[second]);
+    wf::scene::remove_child(counter);
+}
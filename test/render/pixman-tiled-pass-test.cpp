@@ -0,0 +1,193 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <wayfire/config/config-manager.hpp>
+#include <wayfire/core.hpp>
+#include <wayfire/nonstd/wlroots-full.hpp>
+#include <wayfire/render.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/toplevel-view.hpp>
+
+#include "../support/headless-core-harness.hpp"
+#include "../support/wayland-xdg-client.hpp"
+
+namespace
+{
+constexpr int WIDTH  = 320;
+constexpr int HEIGHT = 240;
+
+void set_render_threads(int threads)
+{
+    wf::get_core().config->get_option("core/software_render_threads")->set_value_str(
+        std::to_string(threads));
+}
+
+wf::render_target_t make_target(wf::auxilliary_buffer_t& buffer)
+{
+    wf::render_target_t target{buffer};
+    target.geometry = wf::construct_box({0, 0}, buffer.get_size());
+    return target;
+}
+
+std::vector<uint8_t> read_pixels(wlr_buffer *buffer)
+{
+    void *data;
+    uint32_t format;
+    size_t stride;
+    REQUIRE(wlr_buffer_begin_data_ptr_access(buffer, WLR_BUFFER_DATA_PTR_ACCESS_READ,
+        &data, &format, &stride));
+
+    std::vector<uint8_t> pixels;
+    for (int y = 0; y < buffer->height; y++)
+    {
+        auto row = static_cast<const uint8_t*>(data) + y * stride;
+        pixels.insert(pixels.end(), row, row + buffer->width * 4);
+    }
+
+    wlr_buffer_end_data_ptr_access(buffer);
+    return pixels;
+}
+
+/**
+ * Render a few overlapping rectangles and textures, with scaling, transforms, alpha and a damage region
+ * which does not cover the whole buffer.
+ */
+std::vector<uint8_t> render_scene(wf::auxilliary_buffer_t& source)
+{
+    wf::auxilliary_buffer_t buffer;
+    REQUIRE(buffer.allocate({WIDTH, HEIGHT}) == wf::buffer_reallocation_result_t::REALLOCATED);
+    auto target = make_target(buffer);
+
+    wf::region_t damage;
+    damage |= wf::geometry_t{0, 0, WIDTH, 100};
+    damage |= wf::geometry_t{40, 90, 200, 150};
+
+    wf::render_pass_params_t params;
+    params.target = target;
+    params.damage = wf::construct_box({0, 0}, {WIDTH, HEIGHT});
+    params.background_color = {0.1, 0.2, 0.3, 1.0};
+    params.flags = wf::RPASS_CLEAR_BACKGROUND;
+
+    wf::render_pass_t pass{params};
+    pass.run_partial();
+    pass.add_rect({0.5, 0.0, 0.0, 0.5}, target, wf::geometry_t{10, 10, 200, 150}, damage);
+
+    auto texture = wf::texture_t::from_aux(source);
+    pass.add_texture(texture, target, wf::geometry_t{50, 30, 64, 48}, damage, 0.75);
+
+    auto scaled = wf::texture_t::from_aux(source);
+    scaled->set_filter_mode(WLR_SCALE_FILTER_NEAREST);
+    pass.add_texture(scaled, target, wf::geometry_t{120, 20, 128, 96}, damage);
+
+    auto rotated = wf::texture_t::from_aux(source);
+    rotated->set_transform(WL_OUTPUT_TRANSFORM_90);
+    rotated->set_filter_mode(WLR_SCALE_FILTER_NEAREST);
+    pass.add_texture(rotated, target, wf::geometry_t{20, 120, 48, 64}, damage);
+
+    pass.add_rect({0.0, 0.4, 0.0, 1.0}, target, wf::geometry_t{200, 150, 100, 80}, damage);
+    REQUIRE(pass.submit());
+
+    return read_pixels(buffer.get_buffer());
+}
+
+size_t count_mismatches(const std::vector<uint8_t>& reference, const std::vector<uint8_t>& tiled)
+{
+    REQUIRE(reference.size() == tiled.size());
+    size_t mismatches = 0;
+    for (size_t i = 0; i < reference.size(); i++)
+    {
+        // Allow for rounding differences between the wlroots and the tiled texture transforms.
+        if (std::abs(int(reference[i]) - int(tiled[i])) > 2)
+        {
+            ++mismatches;
+        }
+    }
+
+    return mismatches;
+}
+
+/** Render a client texture scaled up, so that worker threads sample it with a transform. */
+std::vector<uint8_t> render_client_texture(std::shared_ptr<wf::texture_t> texture)
+{
+    wf::auxilliary_buffer_t buffer;
+    REQUIRE(buffer.allocate({WIDTH, HEIGHT}) == wf::buffer_reallocation_result_t::REALLOCATED);
+    auto target = make_target(buffer);
+
+    wf::render_pass_params_t params;
+    params.target = target;
+    params.damage = target.geometry;
+    params.background_color = {0.0, 0.0, 0.0, 1.0};
+    params.flags = wf::RPASS_CLEAR_BACKGROUND;
+
+    wf::render_pass_t pass{params};
+    pass.run_partial();
+    pass.add_texture(texture, target, wf::geometry_t{0, 0, WIDTH, HEIGHT}, target.geometry);
+    REQUIRE(pass.submit());
+
+    return read_pixels(buffer.get_buffer());
+}
+
+void fill_source(wf::auxilliary_buffer_t& source)
+{
+    REQUIRE(source.allocate({64, 48}) == wf::buffer_reallocation_result_t::REALLOCATED);
+    auto target = make_target(source);
+
+    wf::render_pass_params_t params;
+    params.target = target;
+    wf::render_pass_t pass{params};
+    pass.run_partial();
+    pass.clear(wf::construct_box({0, 0}, {64, 48}), {0.0, 0.0, 0.0, 0.0});
+    pass.add_rect({1.0, 0.0, 0.0, 1.0}, target, wf::geometry_t{0, 0, 32, 24}, target.geometry);
+    pass.add_rect({0.0, 1.0, 0.0, 1.0}, target, wf::geometry_t{32, 0, 32, 24}, target.geometry);
+    pass.add_rect({0.0, 0.0, 0.5, 0.5}, target, wf::geometry_t{0, 24, 64, 24}, target.geometry);
+    REQUIRE(pass.submit());
+}
+}
+
+TEST_CASE("Tiled pixman rendering matches the wlroots pixman renderer")
+{
+    wf::test::headless_core_harness_t harness;
+    REQUIRE(wf::get_core().is_pixman());
+
+    set_render_threads(1);
+    wf::auxilliary_buffer_t source;
+    fill_source(source);
+    auto reference = render_scene(source);
+
+    set_render_threads(4);
+    auto tiled = render_scene(source);
+
+    CHECK(count_mismatches(reference, tiled) == 0);
+}
+
+TEST_CASE("Tiled pixman rendering of client buffers")
+{
+    wf::test::headless_core_harness_t harness;
+    REQUIRE(wf::get_core().is_pixman());
+
+    wf::test::wayland_xdg_client_t client{harness.socket_name()};
+    auto view = wf::test::map_toplevel(harness, client, "pixman test", 160, 120);
+    REQUIRE(view);
+
+    auto surface = view->get_wlr_surface();
+    REQUIRE(surface->buffer);
+    auto texture = wf::texture_t::from_buffer(&surface->buffer->base, surface->buffer->texture);
+
+    // The shm pool of the client is accessed only on the compositor thread, the workers sample a copy.
+    set_render_threads(1);
+    auto reference = render_client_texture(texture);
+    set_render_threads(4);
+    auto tiled = render_client_texture(texture);
+    CHECK(count_mismatches(reference, tiled) == 0);
+
+    // The client fills its buffers with 0xff336699 (ARGB), stored as BGRA in memory.
+    const size_t center = ((HEIGHT / 2) * WIDTH + WIDTH / 2) * 4;
+    CHECK(tiled[center + 0] == 0x99);
+    CHECK(tiled[center + 1] == 0x66);
+    CHECK(tiled[center + 2] == 0x33);
+}
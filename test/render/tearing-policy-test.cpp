@@ -0,0 +1,38 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/config-backend.hpp>
+#include <wayfire/core.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/render-manager.hpp>
+
+#include "../support/headless-core-harness.hpp"
+
+TEST_CASE("Tearing is decided by the output option, the client hint and plugins")
+{
+    wf::test::headless_core_harness_t harness;
+    auto output = harness.output();
+    REQUIRE(output);
+
+    auto section = wf::get_core().config_backend->get_output_section(output->handle);
+    auto allow_tearing = section->get_option("allow_tearing");
+
+    // Disabled by default.
+    CHECK_FALSE(output->render->should_tear(nullptr));
+
+    // Enabled on the output, but surfaces without a tearing-control hint want vsync.
+    allow_tearing->set_value_str("true");
+    CHECK_FALSE(output->render->should_tear(nullptr));
+
+    wf::signal::connection_t<wf::output_tearing_request_signal> force_tearing =
+        [] (wf::output_tearing_request_signal *ev)
+    {
+        ev->allow_tearing = true;
+    };
+
+    output->connect(&force_tearing);
+    CHECK(output->render->should_tear(nullptr));
+
+    force_tearing.disconnect();
+    CHECK_FALSE(output->render->should_tear(nullptr));
+}
@@ -0,0 +1,129 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <wayfire/core.hpp>
+#include <wayfire/render.hpp>
+#include <wayfire/toplevel-view.hpp>
+#include <wayfire/view-transform.hpp>
+#include <wayfire/nonstd/wlroots-full.hpp>
+
+#include "../support/headless-core-harness.hpp"
+#include "../support/wayland-xdg-client.hpp"
+
+namespace
+{
+constexpr int WIDTH  = 200;
+constexpr int HEIGHT = 120;
+
+/** Render the node into a new buffer covering @geometry and return the painted part of it. */
+wf::geometry_t render_painted_box(wf::scene::node_ptr node, wf::geometry_t geometry, wf::output_t *output)
+{
+    wf::auxilliary_buffer_t buffer;
+    REQUIRE(buffer.allocate(wf::dimensions(geometry)) == wf::buffer_reallocation_result_t::REALLOCATED);
+
+    wf::render_target_t target{buffer};
+    target.geometry = geometry;
+
+    std::vector<wf::scene::render_instance_uptr> instances;
+    node->gen_render_instances(instances, [] (const wf::region_t&) {}, output);
+
+    wf::render_pass_params_t params;
+    params.instances = &instances;
+    params.target    = target;
+    params.damage    = geometry;
+    params.background_color = {0.0, 0.0, 0.0, 1.0};
+    params.reference_output = output;
+    params.flags = wf::RPASS_CLEAR_BACKGROUND;
+    wf::render_pass_t::run(params);
+
+    void *data;
+    uint32_t format;
+    size_t stride;
+    REQUIRE(wlr_buffer_begin_data_ptr_access(buffer.get_buffer(), WLR_BUFFER_DATA_PTR_ACCESS_READ,
+        &data, &format, &stride));
+
+    // The corner is outside of the node, so it has the background color.
+    const uint32_t background = *static_cast<const uint32_t*>(data);
+    int x1 = geometry.width, y1 = geometry.height, x2 = 0, y2 = 0;
+    for (int y = 0; y < geometry.height; y++)
+    {
+        auto row = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(data) + y * stride);
+        for (int x = 0; x < geometry.width; x++)
+        {
+            if (row[x] != background)
+            {
+                x1 = std::min(x1, x);
+                y1 = std::min(y1, y);
+                x2 = std::max(x2, x + 1);
+                y2 = std::max(y2, y + 1);
+            }
+        }
+    }
+
+    wlr_buffer_end_data_ptr_access(buffer.get_buffer());
+    return {geometry.x + x1, geometry.y + y1, x2 - x1, y2 - y1};
+}
+}
+
+TEST_CASE("The content scale of transformers is quantized to a few fixed steps")
+{
+    wf::test::headless_core_harness_t harness;
+    wf::scene::transformer_base_node_t node{false};
+    CHECK(node.get_content_scale() == 1.0f);
+
+    const std::vector<std::pair<float, float>> steps = {
+        {2.0, 1.0},
+        {1.0, 1.0},
+        {0.6, 1.0},
+        {0.5, 0.5},
+        {0.3, 0.5},
+        {0.25, 0.25},
+        {0.2, 0.25},
+        {0.125, 0.125},
+        {0.1, 0.125},
+        {0.01, 0.125},
+        {-0.3, 0.5},
+    };
+
+    for (auto& [scale, expected] : steps)
+    {
+        CAPTURE(scale);
+        node.set_content_scale(scale);
+        CHECK(node.get_content_scale() == expected);
+    }
+}
+
+TEST_CASE("Transformed content at a reduced content scale keeps its displayed size")
+{
+    wf::test::headless_core_harness_t harness;
+    wf::test::wayland_xdg_client_t client{harness.socket_name()};
+    auto view = wf::test::map_toplevel(harness, client, "content scale test", WIDTH, HEIGHT);
+    REQUIRE(view);
+
+    // The outer transformer renders the inner one, which has no zero-copy texture, into its buffer.
+    auto inner = std::make_shared<wf::scene::view_2d_transformer_t>(view);
+    auto outer = std::make_shared<wf::scene::view_2d_transformer_t>(view);
+    outer->scale_x = outer->scale_y = 0.25;
+    view->get_transformed_node()->add_transformer(inner, wf::TRANSFORMER_2D, "content-scale-inner");
+    view->get_transformed_node()->add_transformer(outer, wf::TRANSFORMER_2D + 1, "content-scale-outer");
+
+    auto bbox = outer->get_bounding_box();
+    REQUIRE(wf::dimensions(bbox) == wf::dimensions_t{WIDTH / 4, HEIGHT / 4});
+
+    wf::geometry_t area = bbox;
+    area.x -= 10;
+    area.y -= 10;
+    area.width  += 20;
+    area.height += 20;
+    CHECK(render_painted_box(outer, area, harness.output()) == bbox);
+
+    CHECK(outer->get_content_scale() == 0.25f);
+    CHECK(outer->inner_content.get_size() == wf::dimensions_t{WIDTH / 4, HEIGHT / 4});
+
+    view->get_transformed_node()->rem_transformer(outer);
+    view->get_transformed_node()->rem_transformer(inner);
+}
@@ -0,0 +1,109 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <memory>
+
+#include <wayfire/core.hpp>
+#include <wayfire/render.hpp>
+#include <wayfire/scene-operations.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/toplevel-view.hpp>
+#include <wayfire/view-snapshot.hpp>
+#include <wayfire/nonstd/wlroots-full.hpp>
+
+#include "../support/headless-core-harness.hpp"
+#include "../support/wayland-xdg-client.hpp"
+
+namespace
+{
+constexpr int WIDTH  = 200;
+constexpr int HEIGHT = 120;
+constexpr uint32_t FIRST_COLOR  = 0xff336699u;
+constexpr uint32_t SECOND_COLOR = 0xffcc2200u;
+
+/** Render the snapshot into a new buffer and return the color of the pixel in its center. */
+uint32_t render_center_pixel(wf::view_snapshot_t& snapshot)
+{
+    wf::auxilliary_buffer_t buffer;
+    REQUIRE(buffer.allocate({WIDTH, HEIGHT}) == wf::buffer_reallocation_result_t::REALLOCATED);
+
+    wf::render_target_t target{buffer};
+    target.geometry = snapshot.get_region();
+
+    wf::render_pass_params_t params;
+    params.target = target;
+    params.damage = target.geometry;
+    params.background_color = {0.0, 0.0, 0.0, 1.0};
+    params.flags = wf::RPASS_CLEAR_BACKGROUND;
+
+    wf::render_pass_t pass{params};
+    pass.run_partial();
+    wf::scene::render_instruction_t instruction;
+    instruction.pass   = &pass;
+    instruction.target = target;
+    instruction.damage = target.geometry;
+    snapshot.render(instruction, target.geometry);
+    REQUIRE(pass.submit());
+
+    void *data;
+    uint32_t format;
+    size_t stride;
+    REQUIRE(wlr_buffer_begin_data_ptr_access(buffer.get_buffer(), WLR_BUFFER_DATA_PTR_ACCESS_READ,
+        &data, &format, &stride));
+    auto row = static_cast<const uint8_t*>(data) + (HEIGHT / 2) * stride;
+    uint32_t pixel = *reinterpret_cast<const uint32_t*>(row + (WIDTH / 2) * 4);
+    wlr_buffer_end_data_ptr_access(buffer.get_buffer());
+    return pixel;
+}
+}
+
+TEST_CASE("Snapshots of plain xdg toplevels keep the client buffer")
+{
+    wf::test::headless_core_harness_t harness;
+    wf::test::wayland_xdg_client_t client{harness.socket_name()};
+    auto view = wf::test::map_toplevel(harness, client, "snapshot test", WIDTH, HEIGHT, FIRST_COLOR);
+    REQUIRE(view);
+
+    wf::view_snapshot_t snapshot;
+    snapshot.capture(view);
+    CHECK(snapshot.is_zero_copy());
+    CHECK(wf::dimensions(snapshot.get_region()) == wf::dimensions_t{WIDTH, HEIGHT});
+    const uint32_t first = render_center_pixel(snapshot);
+
+    // The snapshot holds on to the old buffer, so a new commit of the client does not change it.
+    auto surface = view->get_wlr_surface();
+    const uint32_t seq = surface->current.seq;
+    client.commit_frame(WIDTH, HEIGHT, SECOND_COLOR);
+    REQUIRE(harness.run_until([&] () { return surface->current.seq != seq; }));
+    CHECK(render_center_pixel(snapshot) == first);
+
+    // A new capture sees the new contents.
+    snapshot.capture(view);
+    CHECK(snapshot.is_zero_copy());
+    CHECK(render_center_pixel(snapshot) != first);
+}
+
+TEST_CASE("Snapshots of views with custom nodes are rendered")
+{
+    wf::test::headless_core_harness_t harness;
+    wf::test::wayland_xdg_client_t client{harness.socket_name()};
+    auto view = wf::test::map_toplevel(harness, client, "snapshot test", WIDTH, HEIGHT, FIRST_COLOR);
+    REQUIRE(view);
+    wf::view_snapshot_t zero_copy;
+    zero_copy.capture(view);
+    REQUIRE(zero_copy.is_zero_copy());
+
+    // For example server-side decorations, which are not client surfaces.
+    auto custom = std::make_shared<wf::scene::node_t>(false);
+    wf::scene::add_back(view->get_surface_root_node(), custom);
+
+    wf::view_snapshot_t snapshot;
+    snapshot.capture(view);
+    CHECK(!snapshot.is_zero_copy());
+    CHECK(snapshot.get_region() == zero_copy.get_region());
+    CHECK(render_center_pixel(snapshot) == render_center_pixel(zero_copy));
+
+    wf::scene::remove_child(custom);
+    snapshot.capture(view);
+    CHECK(snapshot.is_zero_copy());
+}
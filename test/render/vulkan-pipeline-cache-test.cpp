@@ -0,0 +1,160 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+#include "../../src/core/vulkan-priv.hpp"
+
+namespace
+{
+VkPhysicalDeviceProperties make_device(uint32_t device_id)
+{
+    VkPhysicalDeviceProperties properties{};
+    properties.vendorID = 0x1002;
+    properties.deviceID = device_id;
+    std::memset(properties.pipelineCacheUUID, 0x42, VK_UUID_SIZE);
+    return properties;
+}
+
+std::vector<char> make_cache(const VkPhysicalDeviceProperties& properties, size_t payload)
+{
+    VkPipelineCacheHeaderVersionOne header{};
+    header.headerSize    = sizeof(header);
+    header.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+    header.vendorID = properties.vendorID;
+    header.deviceID = properties.deviceID;
+    std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    std::vector<char> data(sizeof(header) + payload);
+    std::memcpy(data.data(), &header, sizeof(header));
+    for (size_t i = 0; i < payload; i++)
+    {
+        data[sizeof(header) + i] = char(i);
+    }
+
+    return data;
+}
+
+struct temp_dir_t
+{
+    std::filesystem::path path;
+    temp_dir_t()
+    {
+        path = std::filesystem::temp_directory_path() / ("wayfire-vk-cache-test-" + std::to_string(getpid()));
+        std::filesystem::remove_all(path);
+    }
+
+    ~temp_dir_t()
+    {
+        std::filesystem::remove_all(path);
+    }
+};
+
+VkPipeline fake_pipeline(uintptr_t id)
+{
+    return (VkPipeline)id;
+}
+}
+
+TEST_CASE("Pipeline cache files round-trip for the same device")
+{
+    temp_dir_t dir;
+    const auto cache_path = (dir.path / "wayfire" / "vulkan-pipeline-cache").string();
+    auto device = make_device(0x73bf);
+    auto data   = make_cache(device, 1000);
+
+    // Parent directories are created as needed, and no temporary file is left behind.
+    REQUIRE(wf::vk::write_pipeline_cache_file(cache_path, data));
+    CHECK(!std::filesystem::exists(cache_path + ".tmp"));
+    CHECK(wf::vk::read_pipeline_cache_file(cache_path, device) == data);
+
+    // Overwriting replaces the old cache completely.
+    auto smaller = make_cache(device, 10);
+    REQUIRE(wf::vk::write_pipeline_cache_file(cache_path, smaller));
+    CHECK(wf::vk::read_pipeline_cache_file(cache_path, device) == smaller);
+}
+
+TEST_CASE("Pipeline caches of other devices are ignored")
+{
+    temp_dir_t dir;
+    const auto cache_path = (dir.path / "vulkan-pipeline-cache").string();
+    auto device = make_device(0x73bf);
+    REQUIRE(wf::vk::write_pipeline_cache_file(cache_path, make_cache(device, 100)));
+
+    CHECK(wf::vk::read_pipeline_cache_file(cache_path, make_device(0x1234)).empty());
+
+    auto new_driver = device;
+    new_driver.pipelineCacheUUID[0] = 0;
+    CHECK(wf::vk::read_pipeline_cache_file(cache_path, new_driver).empty());
+
+    // Missing and truncated files
+    CHECK(wf::vk::read_pipeline_cache_file((dir.path / "missing").string(), device).empty());
+    {
+        std::ofstream truncated(cache_path, std::ios::binary | std::ios::trunc);
+        truncated.write("abc", 3);
+    }
+
+    CHECK(wf::vk::read_pipeline_cache_file(cache_path, device).empty());
+}
+
+TEST_CASE("Queued pipeline compilations can be taken over by the compositor thread")
+{
+    int compiled = 0;
+    wf::vk::pipeline_compile_job_t job{[&] { ++compiled; return fake_pipeline(0x10); }};
+
+    // The job was not started in the background yet, so it is compiled right away instead of waiting.
+    CHECK(job.get() == fake_pipeline(0x10));
+    CHECK(compiled == 1);
+
+    // The background thread reaches the job later and must not compile it again.
+    job.run();
+    CHECK(compiled == 1);
+    CHECK(!job.cancel());
+    CHECK(job.get() == fake_pipeline(0x10));
+}
+
+TEST_CASE("Cancelled pipeline compilations never run")
+{
+    int compiled = 0;
+    wf::vk::pipeline_compile_job_t job{[&] { ++compiled; return fake_pipeline(0x20); }};
+    CHECK(job.cancel());
+    job.run();
+    CHECK(compiled == 0);
+}
+
+TEST_CASE("Waiting for a pipeline which is being compiled in the background")
+{
+    std::atomic<int> compiled = 0;
+    std::atomic<bool> started = false;
+    std::atomic<bool> release = false;
+    wf::vk::pipeline_compile_job_t job{[&]
+        {
+            started = true;
+            while (!release)
+            {
+                std::this_thread::yield();
+            }
+
+            ++compiled;
+            return fake_pipeline(0x30);
+        }
+    };
+
+    std::thread worker([&] { job.run(); });
+    while (!started)
+    {
+        std::this_thread::yield();
+    }
+
+    // The job has started, so it cannot be cancelled anymore and get() waits for the worker.
+    CHECK(!job.cancel());
+    release = true;
+    CHECK(job.get() == fake_pipeline(0x30));
+    worker.join();
+    CHECK(compiled == 1);
+}
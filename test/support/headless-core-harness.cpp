@@ -32,6 +32,9 @@ namespace
 class test_config_backend_t : public wf::config_backend_t
 {
   public:
+    test_config_backend_t(const std::string& extra_config) : extra_config(extra_config)
+    {}
+
     void init(wl_display*, wf::config::config_manager_t& config,
         const std::string&) override
     {
@@ -52,7 +55,15 @@ class test_config_backend_t : public wf::config_backend_t
             "enable_input_method_v2 = false\n"
             "use_external_output_configuration = false\n",
             "xdg-shell-test-config");
+
+        if (!extra_config.empty())
+        {
+            wf::config::load_configuration_options_from_string(config, extra_config, "extra-test-config");
+        }
     }
+
+  private:
+    std::string extra_config;
 };
 
 static std::string add_test_socket(wl_display *display)
@@ -116,9 +127,10 @@ struct wf::test::headless_core_harness_t::impl
     bool had_xdg_runtime_dir = false;
 };
 
-wf::test::headless_core_harness_t::headless_core_harness_t()
+wf::test::headless_core_harness_t::headless_core_harness_t(const std::string& extra_config,
+    wf::log::log_level_t log_level)
 {
-    wf::log::initialize_logging(std::cout, wf::log::LOG_LEVEL_DEBUG,
+    wf::log::initialize_logging(std::cout, log_level,
         wf::log::LOG_COLOR_MODE_OFF);
     wlr_log_init(WLR_ERROR, nullptr);
 
@@ -166,7 +178,7 @@ wf::test::headless_core_harness_t::headless_core_harness_t()
         throw std::runtime_error("Failed to create allocator");
     }
 
-    core.config_backend = std::make_unique<test_config_backend_t>();
+    core.config_backend = std::make_unique<test_config_backend_t>(extra_config);
     core.config_backend->init(core.display, *core.config, "");
     core.init();
 
@@ -225,6 +237,12 @@ wf::test::headless_core_harness_t::~headless_core_harness_t()
     }
 }
 
+void wf::test::headless_core_harness_t::post_init()
+{
+    priv->core->post_init();
+    roundtrip();
+}
+
 void wf::test::headless_core_harness_t::dispatch_once(int timeout_ms)
 {
     wl_event_loop_dispatch(priv->core->ev_loop, timeout_ms);
@@ -259,6 +277,26 @@ wf::output_t*wf::test::headless_core_harness_t::output() const
     return outputs.empty() ? nullptr : outputs.front();
 }
 
+wf::output_t*wf::test::headless_core_harness_t::add_output(int width, int height)
+{
+    auto *handle = wlr_headless_add_output(priv->core->backend, width, height);
+    if (!handle)
+    {
+        throw std::runtime_error("Failed to create headless output");
+    }
+
+    roundtrip();
+    for (auto output : priv->core->output_layout->get_outputs())
+    {
+        if (output->handle == handle)
+        {
+            return output;
+        }
+    }
+
+    return nullptr;
+}
+
 const std::string& wf::test::headless_core_harness_t::socket_name() const
 {
     return priv->core->wayland_display;
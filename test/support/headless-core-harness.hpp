@@ -4,13 +4,20 @@
 #include <memory>
 #include <string>
 #include <wayfire/core.hpp>
+#include <wayfire/util/log.hpp>
 
 namespace wf::test
 {
 class headless_core_harness_t
 {
   public:
-    headless_core_harness_t();
+    /**
+     * @param extra_config Additional configuration in the ini format, loaded after the defaults of the harness
+     *   (which load no plugins).
+     * @param log_level The minimal level of messages which are logged to stdout.
+     */
+    headless_core_harness_t(const std::string& extra_config = "",
+        wf::log::log_level_t log_level = wf::log::LOG_LEVEL_DEBUG);
     ~headless_core_harness_t();
 
     headless_core_harness_t(const headless_core_harness_t&) = delete;
@@ -18,11 +25,20 @@ class headless_core_harness_t
     headless_core_harness_t& operator =(const headless_core_harness_t&) = delete;
     headless_core_harness_t& operator =(headless_core_harness_t&&) = delete;
 
+    /**
+     * Finish starting the compositor like Wayfire does once the backend is running: load the plugins from
+     * core/plugins and start processing cursor input. Tests which do not need this do not call it.
+     */
+    void post_init();
+
     void dispatch_once(int timeout_ms = 0);
     void roundtrip();
     bool run_until(const std::function<bool()>& predicate, int max_iterations = 200);
 
+    /** The first output, which is created with the harness. */
     wf::output_t *output() const;
+    /** Add another headless output and return it once it is ready. */
+    wf::output_t *add_output(int width = 1280, int height = 720);
     const std::string& socket_name() const;
 
   private:
@@ -1,5 +1,6 @@
 #include "wayland-xdg-client.hpp"
 
+#include <map>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -7,6 +8,10 @@
 #include <wayland-client-core.h>
 #include <wayland-client-protocol.h>
 
+#include <wayfire/core.hpp>
+#include <wayfire/signal-definitions.hpp>
+
+#include "headless-core-harness.hpp"
 #include "wayland-client-utils.hpp"
 #include "xdg-shell-client-protocol.h"
 
@@ -22,14 +27,24 @@ struct wf::test::wayland_xdg_client_t::impl
     ::xdg_surface *shell_surface   = nullptr;
     ::xdg_toplevel *shell_toplevel = nullptr;
     wl_buffer *buffer = nullptr;
+    int buffer_width  = 0;
+    int buffer_height = 0;
+    uint32_t buffer_color = 0xff336699u;
+
+    int toplevel_width  = 0;
+    int toplevel_height = 0;
 
     bool configured = false;
     uint32_t configure_serial = 0;
 
+    /** Interface name -> global name, for globals bound later by the tests. */
+    std::map<std::string, uint32_t> globals;
+
     static void handle_registry_global(void *data, wl_registry *registry,
         uint32_t name, const char *interface, uint32_t version)
     {
         auto *self = static_cast<impl*>(data);
+        self->globals[interface] = name;
         if (std::string{interface} == wl_compositor_interface.name)
         {
             self->compositor = static_cast<wl_compositor*>(wl_registry_bind(registry,
@@ -74,6 +89,30 @@ struct wf::test::wayland_xdg_client_t::impl
     static constexpr ::xdg_surface_listener xdg_surface_listener = {
         .configure = handle_xdg_surface_configure,
     };
+
+    static void handle_toplevel_configure(void *data, ::xdg_toplevel*, int32_t width, int32_t height,
+        wl_array*)
+    {
+        auto *self = static_cast<impl*>(data);
+        self->toplevel_width  = width;
+        self->toplevel_height = height;
+    }
+
+    static void handle_toplevel_close(void*, ::xdg_toplevel*)
+    {}
+
+    static void handle_toplevel_configure_bounds(void*, ::xdg_toplevel*, int32_t, int32_t)
+    {}
+
+    static void handle_toplevel_wm_capabilities(void*, ::xdg_toplevel*, wl_array*)
+    {}
+
+    static constexpr ::xdg_toplevel_listener xdg_toplevel_listener = {
+        .configure = handle_toplevel_configure,
+        .close     = handle_toplevel_close,
+        .configure_bounds = handle_toplevel_configure_bounds,
+        .wm_capabilities  = handle_toplevel_wm_capabilities,
+    };
 };
 
 wf::test::wayland_xdg_client_t::wayland_xdg_client_t(const std::string& socket_name)
@@ -162,6 +201,7 @@ void wf::test::wayland_xdg_client_t::create_toplevel(const std::string& title,
     priv->shell_surface = xdg_wm_base_get_xdg_surface(priv->wm_base, priv->surface);
     xdg_surface_add_listener(priv->shell_surface, &impl::xdg_surface_listener, priv.get());
     priv->shell_toplevel = xdg_surface_get_toplevel(priv->shell_surface);
+    xdg_toplevel_add_listener(priv->shell_toplevel, &impl::xdg_toplevel_listener, priv.get());
 
     xdg_toplevel_set_title(priv->shell_toplevel, title.c_str());
     xdg_toplevel_set_app_id(priv->shell_toplevel, app_id.c_str());
@@ -192,6 +232,9 @@ void wf::test::wayland_xdg_client_t::ack_last_configure()
 void wf::test::wayland_xdg_client_t::attach_and_commit(int width, int height)
 {
     priv->buffer = create_shm_buffer(priv->shm, width, height, 0xff336699u);
+    priv->buffer_width  = width;
+    priv->buffer_height = height;
+    priv->buffer_color  = 0xff336699u;
 
     wl_surface_attach(priv->surface, priv->buffer, 0, 0);
     wl_surface_damage_buffer(priv->surface, 0, 0, width, height);
@@ -199,6 +242,38 @@ void wf::test::wayland_xdg_client_t::attach_and_commit(int width, int height)
     wl_display_flush(priv->display);
 }
 
+void wf::test::wayland_xdg_client_t::commit_frame(int width, int height, uint32_t color)
+{
+    if (!priv->buffer || (priv->buffer_width != width) || (priv->buffer_height != height) ||
+        (priv->buffer_color != color))
+    {
+        if (priv->buffer)
+        {
+            wl_buffer_destroy(priv->buffer);
+        }
+
+        priv->buffer = create_shm_buffer(priv->shm, width, height, color);
+        priv->buffer_width  = width;
+        priv->buffer_height = height;
+        priv->buffer_color  = color;
+    }
+
+    wl_surface_attach(priv->surface, priv->buffer, 0, 0);
+    wl_surface_damage_buffer(priv->surface, 0, 0, width, height);
+    wl_surface_commit(priv->surface);
+    wl_display_flush(priv->display);
+}
+
+int wf::test::wayland_xdg_client_t::configured_width() const
+{
+    return priv->toplevel_width;
+}
+
+int wf::test::wayland_xdg_client_t::configured_height() const
+{
+    return priv->toplevel_height;
+}
+
 void wf::test::wayland_xdg_client_t::commit_surface()
 {
     wl_surface_commit(priv->surface);
@@ -236,3 +311,55 @@ void wf::test::wayland_xdg_client_t::destroy_toplevel()
         wl_display_flush(priv->display);
     }
 }
+
+wl_surface*wf::test::wayland_xdg_client_t::get_surface() const
+{
+    return priv->surface;
+}
+
+void*wf::test::wayland_xdg_client_t::bind_global(const wl_interface *interface, uint32_t version)
+{
+    auto it = priv->globals.find(interface->name);
+    if (it == priv->globals.end())
+    {
+        return nullptr;
+    }
+
+    return wl_registry_bind(priv->registry, it->second, interface, version);
+}
+
+wayfire_toplevel_view wf::test::map_toplevel(headless_core_harness_t& harness, wayland_xdg_client_t& client,
+    const std::string& title, int width, int height, uint32_t color)
+{
+    wayfire_toplevel_view mapped;
+    wf::signal::connection_t<wf::view_mapped_signal> on_map = [&] (wf::view_mapped_signal *ev)
+    {
+        mapped = wf::toplevel_cast(ev->view);
+    };
+    wf::get_core().connect(&on_map);
+
+    bool ready = harness.run_until([&]
+    {
+        client.dispatch_once();
+        return client.has_required_globals();
+    });
+    if (!ready)
+    {
+        return nullptr;
+    }
+
+    client.create_toplevel(title, "org.wayfire.Test");
+    ready = harness.run_until([&]
+    {
+        client.dispatch_once();
+        return client.has_pending_configure();
+    });
+    if (!ready)
+    {
+        return nullptr;
+    }
+
+    client.commit_frame(width, height, color);
+    harness.run_until([&] () { return mapped != nullptr; });
+    return mapped;
+}
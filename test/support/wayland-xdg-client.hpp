@@ -4,6 +4,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <wayfire/toplevel-view.hpp>
 
 struct wl_display;
 struct wl_registry;
@@ -11,12 +12,15 @@ struct wl_compositor;
 struct wl_shm;
 struct wl_surface;
 struct wl_buffer;
+struct wl_interface;
 struct xdg_wm_base;
 struct xdg_surface;
 struct xdg_toplevel;
 
 namespace wf::test
 {
+class headless_core_harness_t;
+
 class wayland_xdg_client_t
 {
   public:
@@ -38,11 +42,34 @@ class wayland_xdg_client_t
     uint32_t last_configure_serial() const;
     void ack_last_configure();
     void attach_and_commit(int width, int height);
+    /**
+     * Commit a new frame with full damage. Unlike attach_and_commit(), the buffer is reused as long as the
+     * size and color do not change, so this can be called at a high rate.
+     *
+     * @param color The color of the buffer in the XRGB8888 format.
+     */
+    void commit_frame(int width, int height, uint32_t color = 0xff336699u);
+    /** The size from the last xdg_toplevel.configure event, 0 if the client may choose. */
+    int configured_width() const;
+    int configured_height() const;
     void commit_surface();
     void destroy_toplevel();
 
+    wl_surface *get_surface() const;
+    /** Bind a global advertised by the compositor, or return nullptr if it is not available. */
+    void *bind_global(const wl_interface *interface, uint32_t version);
+
   private:
     struct impl;
     std::unique_ptr<impl> priv;
 };
+
+/**
+ * Wait until @client has received the globals, create a toplevel, commit a frame of the given size and
+ * color, and wait until the compositor maps it.
+ *
+ * @return The mapped view, or nullptr if the toplevel was not mapped in time.
+ */
+wayfire_toplevel_view map_toplevel(headless_core_harness_t& harness, wayland_xdg_client_t& client,
+    const std::string& title, int width = 200, int height = 120, uint32_t color = 0xff336699u);
 }
@@ -290,3 +290,32 @@ TEST_CASE("Concurrent committed")
     REQUIRE(mgr.pending.size() == 0);
     REQUIRE(mgr.done.size() == 2);
 }
+
+TEST_CASE("Objects wait while they are pending or committed")
+{
+    setup_wayfire_debugging_state();
+    wf::txn::transaction_manager_t mgr;
+
+    auto obj = std::make_shared<txn_test_object_t>(false);
+    REQUIRE(!mgr.is_object_waiting(obj));
+
+    auto tx = new_tx();
+    tx->add_object(obj);
+    mgr.schedule_transaction(std::move(tx));
+    REQUIRE(mgr.is_object_committed(obj));
+    REQUIRE(mgr.is_object_waiting(obj));
+
+    tx = new_tx();
+    tx->add_object(obj);
+    mgr.schedule_transaction(std::move(tx));
+    REQUIRE(mgr.is_object_pending(obj));
+    REQUIRE(mgr.is_object_waiting(obj));
+
+    obj->emit_ready();
+    REQUIRE(!mgr.is_object_pending(obj));
+    REQUIRE(mgr.is_object_waiting(obj));
+
+    obj->emit_ready();
+    REQUIRE(!mgr.is_object_waiting(obj));
+    wl_event_loop_dispatch_idle(wf::wl_idle_call::loop);
+}